@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal self-contained benchmark runner. Each benchmark is timed in `repetitions` batches of
+// an auto-calibrated iteration count; the JSON report carries the median, min and max ns/op so
+// CI can compare runs between commits, plus heap allocations per op when the executable counts
+// them (by replacing operator new to increment g_allocations).
+//
+// Command line:
+//   --filter=<substring>   only run benchmarks whose name contains <substring>
+//   --min-time=<seconds>   target duration of each repetition (default 0.1)
+//   --repetitions=<n>      batches per benchmark (default 5)
+//   --out=<file>           write the JSON report to <file> instead of stdout
+namespace ox_sim {
+namespace bench {
+
+// Keep the compiler from optimizing away a value that is otherwise unused.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Heap allocations so far, if the executable's operator new counts them.
+inline std::atomic<uint64_t> g_allocations{0};
+
+struct Result {
+    std::string name;
+    uint64_t iterations;  // per repetition
+    std::vector<double> ns_per_op;
+    double allocs_per_op;  // over all repetitions
+};
+
+class Runner {
+   public:
+    Runner(int argc, char** argv) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--filter=", 0) == 0) {
+                filter_ = arg.substr(9);
+            } else if (arg.rfind("--min-time=", 0) == 0) {
+                min_time_s_ = std::stod(arg.substr(11));
+            } else if (arg.rfind("--repetitions=", 0) == 0) {
+                repetitions_ = std::max(1, std::stoi(arg.substr(14)));
+            } else if (arg.rfind("--out=", 0) == 0) {
+                out_path_ = arg.substr(6);
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+            }
+        }
+    }
+
+    // Time `op`, a callable performing one operation.
+    template <typename Op>
+    void Run(const std::string& name, Op&& op) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) return;
+
+        // Calibrate: grow the batch until it takes long enough to time reliably, then scale it
+        // to the requested repetition length.
+        uint64_t iterations = 1;
+        double batch_ns = TimeBatch(op, iterations);
+        while (batch_ns < 1e7 && iterations < (1ull << 40)) {
+            iterations *= 10;
+            batch_ns = TimeBatch(op, iterations);
+        }
+        const double per_op_ns = batch_ns / static_cast<double>(iterations);
+        iterations = std::max<uint64_t>(1, static_cast<uint64_t>(min_time_s_ * 1e9 / std::max(per_op_ns, 1e-3)));
+
+        Result result{name, iterations, {}, 0.0};
+        const uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+        for (int rep = 0; rep < repetitions_; rep++) {
+            result.ns_per_op.push_back(TimeBatch(op, iterations) / static_cast<double>(iterations));
+        }
+        result.allocs_per_op = static_cast<double>(g_allocations.load(std::memory_order_relaxed) - allocations) /
+                               static_cast<double>(iterations * repetitions_);
+        std::sort(result.ns_per_op.begin(), result.ns_per_op.end());
+        std::cerr << name << ": " << result.ns_per_op[result.ns_per_op.size() / 2] << " ns/op, "
+                  << result.allocs_per_op << " allocs/op (" << iterations << " iterations x " << repetitions_ << ")"
+                  << std::endl;
+        results_.push_back(std::move(result));
+    }
+
+    // Write the JSON report; returns the process exit code.
+    int Finish() const {
+        std::ostringstream out;
+        out << "{\n  \"context\": {\"timestamp\": " << static_cast<long long>(std::time(nullptr))
+            << ", \"min_time_s\": " << min_time_s_ << ", \"repetitions\": " << repetitions_ << ", \"build_type\": \""
+#ifdef NDEBUG
+            << "release"
+#else
+            << "debug"
+#endif
+            << "\"},\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results_.size(); i++) {
+            const Result& r = results_[i];
+            out << (i ? "," : "") << "\n    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"ns_per_op_median\": " << r.ns_per_op[r.ns_per_op.size() / 2]
+                << ", \"ns_per_op_min\": " << r.ns_per_op.front() << ", \"ns_per_op_max\": " << r.ns_per_op.back()
+                << ", \"allocs_per_op\": " << r.allocs_per_op << "}";
+        }
+        out << "\n  ]\n}\n";
+
+        if (out_path_.empty()) {
+            std::cout << out.str();
+            return 0;
+        }
+        std::ofstream file(out_path_);
+        if (!file) {
+            std::cerr << "Failed to open " << out_path_ << std::endl;
+            return 1;
+        }
+        file << out.str();
+        return 0;
+    }
+
+   private:
+    template <typename Op>
+    static double TimeBatch(Op& op, uint64_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++) op();
+        const auto end = std::chrono::steady_clock::now();
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    std::string filter_;
+    double min_time_s_ = 0.1;
+    int repetitions_ = 5;
+    std::string out_path_;
+    std::vector<Result> results_;
+};
+
+}  // namespace bench
+}  // namespace ox_sim
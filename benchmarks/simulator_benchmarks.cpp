@@ -0,0 +1,328 @@
+// Microbenchmarks for the simulator's hot paths: SimulatorCore state access, eye image
+// encoding and analysis, and the API route handlers (called directly, no sockets). See benchmark.h for options.
+
+#include <ox_driver.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "api_handlers.h"
+#include "benchmark.h"
+#include "device_profiles.h"
+#include "frame_data.h"
+#include "frame_encoder.h"
+#include "pixel_ops.h"
+#include "qoi.h"
+#include "request_arena.h"
+#include "simulator_core.h"
+
+namespace ox_sim {
+
+// driver.cpp owns the real frame data; the benchmarks feed the handlers their own.
+FrameData* GetFrameData() {
+    static FrameData frame_data;
+    return &frame_data;
+}
+
+}  // namespace ox_sim
+
+// Count heap allocations for the allocs/op column. Every non-aligned form is replaced so each
+// allocation and its release go through the same malloc/free pair; the nothrow forms call these.
+// GCC inlines the replaced deletes into library code and then misreports free() on memory from
+// operator new as a mismatch, so that warning is off for this file only.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static void* CountedAlloc(std::size_t size) {
+    ox_sim::bench::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+using namespace ox_sim;
+using bench::DoNotOptimize;
+using bench::Runner;
+
+// Config names of all built-in profiles (see NAME_TO_TYPE in device_profiles.cpp)
+static const char* const kProfileNames[] = {
+    "oculus_quest_2", "oculus_quest_3", "htc_vive", "valve_index", "htc_vive_tracker",
+};
+
+// Synthetic eye image: smooth gradients with some high-frequency detail, so PNG compression
+// works about as hard as on a rendered frame. Stored bottom-row-first like runtime submissions.
+static std::vector<uint8_t> MakeEyeImage(uint32_t width, uint32_t height) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    uint32_t noise = 0x12345678u;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            noise = noise * 1664525u + 1013904223u;
+            uint8_t* p = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            p[0] = static_cast<uint8_t>(x * 255 / width);
+            p[1] = static_cast<uint8_t>(y * 255 / height);
+            p[2] = static_cast<uint8_t>((x ^ y) + (noise >> 29));
+            p[3] = 0;
+        }
+    }
+    return pixels;
+}
+
+static void BenchInputAccess(Runner& runner) {
+    SimulatorCore simulator;
+    simulator.Initialize(GetDeviceProfileByName("oculus_quest_2"));
+    const char* hand = "/user/hand/right";
+
+    bool b = false;
+    float f = 0.0f;
+    OxVector2f v = {0.0f, 0.0f};
+    runner.Run("SimulatorCore/GetInputStateBoolean", [&] {
+        DoNotOptimize(simulator.GetInputStateBoolean(hand, "/input/a/click", &b));
+    });
+    runner.Run("SimulatorCore/GetInputStateFloat", [&] {
+        DoNotOptimize(simulator.GetInputStateFloat(hand, "/input/trigger/value", &f));
+    });
+    runner.Run("SimulatorCore/GetInputStateVec2", [&] {
+        DoNotOptimize(simulator.GetInputStateVec2(hand, "/input/thumbstick", &v));
+    });
+    runner.Run("SimulatorCore/SetInputStateBoolean", [&] {
+        b = !b;
+        simulator.SetInputStateBoolean(hand, "/input/a/click", b);
+    });
+    runner.Run("SimulatorCore/SetInputStateFloat", [&] {
+        f = f > 0.5f ? 0.0f : 0.75f;
+        simulator.SetInputStateFloat(hand, "/input/trigger/value", f);
+    });
+
+    // Linked VEC2 sync: writing the VEC2 updates its FLOAT axes and vice versa.
+    runner.Run("SimulatorCore/SetInputStateVec2/linked", [&] {
+        v.x = v.x > 0.0f ? -0.5f : 0.5f;
+        simulator.SetInputStateVec2(hand, "/input/thumbstick", v);
+    });
+    runner.Run("SimulatorCore/SetInputStateFloat/linked_axis", [&] {
+        f = f > 0.0f ? -0.25f : 0.25f;
+        simulator.SetInputStateFloat(hand, "/input/thumbstick/x", f);
+    });
+
+    OxPose pose = {{0.2f, 1.4f, -0.3f}, {0.0f, 0.0f, 0.0f, 1.0f}};
+    bool is_active = false;
+    runner.Run("SimulatorCore/GetDevicePose", [&] {
+        DoNotOptimize(simulator.GetDevicePose(hand, &pose, &is_active));
+    });
+    runner.Run("SimulatorCore/SetDevicePose", [&] {
+        pose.position.x = -pose.position.x;
+        simulator.SetDevicePose(hand, pose, true);
+    });
+
+    // What the GUI reads once per frame instead of one getter per widget
+    DeviceState snapshot{};
+    runner.Run("SimulatorCore/GetSnapshot", [&] { DoNotOptimize(simulator.GetSnapshot(&snapshot)); });
+}
+
+static void BenchUpdateAllDevices(Runner& runner) {
+    // Quest 2 padded with trackers up to the requested device count.
+    const DeviceProfile& base = *GetDeviceProfileByName("oculus_quest_2");
+    const DeviceDef& tracker = GetDeviceProfileByName("htc_vive_tracker")->devices[0];
+    std::vector<std::string> tracker_paths;
+    for (uint32_t i = 0; i < OX_MAX_DEVICES; i++) {
+        tracker_paths.push_back("/user/vive_tracker_htcx/role/bench_" + std::to_string(i));
+    }
+
+    OxDeviceState states[OX_MAX_DEVICES];
+    uint32_t count = 0;
+    for (uint32_t devices = 1; devices <= OX_MAX_DEVICES; devices *= 2) {
+        DeviceProfile profile = base;
+        profile.devices.resize(std::min<size_t>(devices, profile.devices.size()));
+        for (uint32_t i = 0; profile.devices.size() < devices; i++) {
+            DeviceDef def = tracker;
+            def.user_path = tracker_paths[i].c_str();
+            profile.devices.push_back(def);
+        }
+
+        SimulatorCore simulator;
+        simulator.Initialize(&profile);
+        runner.Run("SimulatorCore/UpdateAllDevices/" + std::to_string(devices), [&] {
+            simulator.UpdateAllDevices(states, &count);
+            DoNotOptimize(states);
+        });
+    }
+}
+
+static void BenchEncode(Runner& runner) {
+    uint32_t last_width = 0, last_height = 0;
+    for (const char* name : kProfileNames) {
+        const DeviceProfile* profile = GetDeviceProfileByName(name);
+        const uint32_t width = profile->recommended_width;
+        const uint32_t height = profile->recommended_height;
+        if (width == 0 || height == 0) continue;                      // no display (tracker-only profile)
+        if (width == last_width && height == last_height) continue;  // same resolution as the previous profile
+        last_width = width;
+        last_height = height;
+
+        const std::vector<uint8_t> pixels = MakeEyeImage(width, height);
+        const std::string suffix = "/" + std::string(name) + "/" + std::to_string(width) + "x" + std::to_string(height);
+
+        runner.Run("EncodeRGBAToPng" + suffix, [&] { DoNotOptimize(EncodeRGBAToPng(pixels.data(), width, height)); });
+
+        // Streamed PNG (GET /v1/views?stream=true): time to the first part, and to the whole file
+        const uint32_t strip_rows = 64 * 1024 / (width * 4 + 1);
+        std::string png;
+        runner.Run("PngStreamEncoder/first" + suffix, [&] {
+            PngStreamEncoder encoder(pixels.data(), width, height, strip_rows);
+            png.clear();
+            DoNotOptimize(encoder.Next(png));
+        });
+        runner.Run("PngStreamEncoder/all" + suffix, [&] {
+            PngStreamEncoder encoder(pixels.data(), width, height, strip_rows);
+            png.clear();
+            while (encoder.Next(png)) {
+            }
+            DoNotOptimize(png.size());
+        });
+
+        // Preview size used by the GUI and typical ?size= requests
+        const uint32_t preview_width = 512;
+        const uint32_t preview_height = static_cast<uint32_t>(preview_width * height / width);
+        std::vector<uint8_t> resized;
+        runner.Run("stbir_resize_uint8" + suffix + "/to_512", [&] {
+            DoNotOptimize(ResizeRGBA(pixels.data(), width, height, preview_width, preview_height, resized));
+        });
+    }
+}
+
+// Per-frame pixel analysis done on the submit path
+static void BenchPixelOps(Runner& runner) {
+    const DeviceProfile* profile = GetDeviceProfileByName("oculus_quest_2");
+    const uint32_t width = profile->recommended_width;
+    const uint32_t height = profile->recommended_height;
+    const std::vector<uint8_t> a = MakeEyeImage(width, height);
+    std::vector<uint8_t> b = a;
+    std::reverse(b.begin(), b.end());
+    const std::string size = std::to_string(width) + "x" + std::to_string(height);
+
+    runner.Run("SumAbsDiffRGB/" + size, [&] { DoNotOptimize(SumAbsDiffRGB(a.data(), b.data(), a.size() / 4)); });
+
+    // Pixel probes: brightness of a whole eye
+    runner.Run("SumLuma/" + size, [&] { DoNotOptimize(SumLuma(a.data(), a.size() / 4)); });
+
+    // Latency probe: compare a watched region against its baseline
+    const PixelRect region = {width / 2 - 32, height / 2 - 32, 64, 64};
+    std::vector<uint8_t> baseline(region.PixelCount() * 4);
+    CopyRegionRGBA(b.data(), width, height, region, baseline.data());
+    runner.Run("RegionMeanAbsDiff/64x64", [&] {
+        DoNotOptimize(RegionMeanAbsDiff(a.data(), width, height, region, baseline.data()));
+    });
+
+    // Flight recorder: downsample on the submit path to its default 480 px width, then QOI on the worker
+    const uint32_t factor = (width + 479) / 480;
+    std::vector<uint8_t> small(static_cast<size_t>(width / factor) * (height / factor) * 4);
+    runner.Run("DownsampleRGBA/" + size + "/" + std::to_string(factor), [&] {
+        DownsampleRGBA(a.data(), width, height, factor, small.data());
+        DoNotOptimize(small.data());
+    });
+    std::vector<uint8_t> qoi;
+    runner.Run("EncodeQoi/" + std::to_string(width / factor) + "x" + std::to_string(height / factor), [&] {
+        qoi.clear();
+        EncodeQoi(small.data(), width / factor, height / factor, &qoi);
+        DoNotOptimize(qoi.data());
+    });
+
+    // Frame monitor: statistics and hash of every 4th row (its default), on the worker
+    const size_t sampled_bytes = a.size() / 4;
+    runner.Run("AccumulateLumaStats/" + size + "/4", [&] {
+        LumaStats stats;
+        AccumulateLumaStats(a.data(), sampled_bytes / 4, &stats);
+        DoNotOptimize(stats.sum);
+    });
+    runner.Run("HashBytes/" + size + "/4", [&] { DoNotOptimize(HashBytes(a.data(), sampled_bytes, 0)); });
+}
+
+static void BenchHandlers(Runner& runner) {
+    SimulatorCore simulator;
+    const DeviceProfile* profile = GetDeviceProfileByName("oculus_quest_2");
+    simulator.Initialize(profile);
+
+    // The pose and input handlers work in the thread's request arena, which the server resets after
+    // every request; do the same here so it does not grow across iterations.
+    RequestArena& arena = RequestArena::ForThread();
+
+    runner.Run("Handler/GetDevice", [&] {
+        DoNotOptimize(HandleGetDevice(simulator, "user/hand/right"));
+        arena.Reset();
+    });
+
+    crow::request put_device;
+    put_device.method = crow::HTTPMethod::Put;
+    put_device.body =
+        R"({"position":{"x":0.2,"y":1.4,"z":-0.3},"orientation":{"x":0,"y":0,"z":0,"w":1},"active":true})";
+    runner.Run("Handler/PutDevice", [&] {
+        DoNotOptimize(HandlePutDevice(simulator, put_device, "user/hand/right"));
+        arena.Reset();
+    });
+
+    runner.Run("Handler/GetInput/float", [&] {
+        DoNotOptimize(HandleGetInput(simulator, "user/hand/right/input/trigger/value"));
+        arena.Reset();
+    });
+    runner.Run("Handler/GetInput/vec2", [&] {
+        DoNotOptimize(HandleGetInput(simulator, "user/hand/right/input/thumbstick"));
+        arena.Reset();
+    });
+
+    crow::request put_float;
+    put_float.method = crow::HTTPMethod::Put;
+    put_float.body = R"({"value":0.75})";
+    runner.Run("Handler/PutInput/float", [&] {
+        DoNotOptimize(HandlePutInput(simulator, put_float, "user/hand/right/input/trigger/value"));
+        arena.Reset();
+    });
+
+    crow::request put_vec2;
+    put_vec2.method = crow::HTTPMethod::Put;
+    put_vec2.body = R"({"x":0.5,"y":-0.5})";
+    runner.Run("Handler/PutInput/vec2", [&] {
+        DoNotOptimize(HandlePutInput(simulator, put_vec2, "user/hand/right/input/thumbstick"));
+        arena.Reset();
+    });
+
+    runner.Run("Handler/GetStatus", [&] { DoNotOptimize(HandleGetStatus()); });
+    runner.Run("Handler/GetProfile", [&] { DoNotOptimize(HandleGetProfile(profile)); });
+
+    // Eye image at the Quest 2 resolution, downscaled as the GUI/preview clients request it
+    FrameData* fd = GetFrameData();
+    const std::vector<uint8_t> pixels = MakeEyeImage(profile->recommended_width, profile->recommended_height);
+    fd->width = profile->recommended_width;
+    fd->height = profile->recommended_height;
+    fd->pixel_data[0] = pixels.data();
+    fd->data_size[0] = static_cast<uint32_t>(pixels.size());
+
+    crow::request get_view;
+    get_view.url_params = crow::query_string("?size=512");
+    runner.Run("Handler/GetView/size_512", [&] { DoNotOptimize(HandleGetView(get_view, 0)); });
+    crow::request get_view_raw;
+    get_view_raw.url_params = crow::query_string("?format=raw");
+    runner.Run("Handler/GetView/raw", [&] { DoNotOptimize(HandleGetView(get_view_raw, 0)); });
+
+    fd->pixel_data[0] = nullptr;
+    fd->width = fd->height = 0;
+}
+
+int main(int argc, char** argv) {
+    Runner runner(argc, argv);
+    BenchInputAccess(runner);
+    BenchUpdateAllDevices(runner);
+    BenchEncode(runner);
+    BenchPixelOps(runner);
+    BenchHandlers(runner);
+    return runner.Finish();
+}
@@ -0,0 +1,371 @@
+// Contention stress test reproducing the production access pattern: API/GUI threads writing poses
+// and inputs while the runtime reads device state once per display frame.
+//
+// A reader thread issues the per-frame driver callback sequence (update_devices followed by every
+// input component, the way xrSyncActions polls them) on a fixed 90/120 Hz schedule. Writer
+// threads hammer SetDevicePose and the SetInputState* setters at a configurable rate.
+//
+// Reported (JSON, see --out):
+//   - deadline misses: frames whose callbacks finished later than --deadline-us after the frame's
+//     scheduled start
+//   - frame and per-call latency percentiles
+//   - torn reads: a linked VEC2 that is unchanged across the frame while its FLOAT axes disagree
+//     with it, i.e. the reader observed a half-applied linked update
+//
+// Options:
+//   --seconds=<s>          run time (default 10)
+//   --reader-hz=<hz>       reader frame rate (default 90)
+//   --deadline-us=<us>     per-frame budget for the reader's callbacks (default 1000)
+//   --pose-writers=<n>     threads calling SetDevicePose (default 2)
+//   --input-writers=<n>    threads calling SetInputState* (default 2)
+//   --writer-hz=<hz>       updates per second per writer, 0 = unthrottled (default 0)
+//   --device=<name>        device profile (default oculus_quest_2)
+//   --out=<file>           write the JSON report to <file> instead of stdout
+//   --lock-profiling       enable per-call-site lock profiling (as config.json "lock_profiling")
+//   --frame-commit         stage writes and publish them at each reader frame (as config.json "frame_commit")
+//   --strict               exit with 1 if any deadline miss or torn read was observed
+//
+// Build with -DOX_SIM_STRESS_TSAN=ON to run under ThreadSanitizer (expect far fewer iterations and
+// a looser --deadline-us there).
+
+#include <ox_driver.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "device_profiles.h"
+#include "profiled_mutex.h"
+#include "simulator_core.h"
+
+using namespace ox_sim;
+using Clock = std::chrono::steady_clock;
+
+struct StressOptions {
+    double seconds = 10.0;
+    double reader_hz = 90.0;
+    int64_t deadline_us = 1000;
+    int pose_writers = 2;
+    int input_writers = 2;
+    double writer_hz = 0.0;
+    std::string device = "oculus_quest_2";
+    std::string out_path;
+    bool lock_profiling = false;
+    bool frame_commit = false;
+    bool strict = false;
+};
+
+static bool ParseOptions(int argc, char** argv, StressOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&arg](const char* prefix) -> const char* {
+            return arg.rfind(prefix, 0) == 0 ? arg.c_str() + std::char_traits<char>::length(prefix) : nullptr;
+        };
+        if (const char* v = value("--seconds=")) {
+            options.seconds = std::stod(v);
+        } else if (const char* v = value("--reader-hz=")) {
+            options.reader_hz = std::stod(v);
+        } else if (const char* v = value("--deadline-us=")) {
+            options.deadline_us = std::stoll(v);
+        } else if (const char* v = value("--pose-writers=")) {
+            options.pose_writers = std::stoi(v);
+        } else if (const char* v = value("--input-writers=")) {
+            options.input_writers = std::stoi(v);
+        } else if (const char* v = value("--writer-hz=")) {
+            options.writer_hz = std::stod(v);
+        } else if (const char* v = value("--device=")) {
+            options.device = v;
+        } else if (const char* v = value("--out=")) {
+            options.out_path = v;
+        } else if (arg == "--lock-profiling") {
+            options.lock_profiling = true;
+        } else if (arg == "--frame-commit") {
+            options.frame_commit = true;
+        } else if (arg == "--strict") {
+            options.strict = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.reader_hz > 0.0 && options.seconds > 0.0;
+}
+
+// A linked VEC2 and its FLOAT axes, resolved from the profile.
+struct LinkedVec2 {
+    const char* user_path;
+    const char* vec2_path;
+    const char* x_path = nullptr;
+    const char* y_path = nullptr;
+};
+
+static std::vector<LinkedVec2> FindLinkedVec2s(const DeviceProfile& profile) {
+    std::vector<LinkedVec2> linked;
+    for (const DeviceDef& dev : profile.devices) {
+        for (const ComponentDef& comp : dev.components) {
+            if (comp.type != ComponentType::VEC2) continue;
+            LinkedVec2 l{dev.user_path, comp.path};
+            for (const ComponentDef& axis : dev.components) {
+                if (!axis.linked_vec2_path || std::string(axis.linked_vec2_path) != comp.path) continue;
+                (axis.linked_axis == Vec2Axis::X ? l.x_path : l.y_path) = axis.path;
+            }
+            if (l.x_path && l.y_path) linked.push_back(l);
+        }
+    }
+    return linked;
+}
+
+// Sleeps until the next tick of a fixed-rate schedule; no-op when hz is 0.
+class RateLimiter {
+   public:
+    explicit RateLimiter(double hz)
+        : period_(hz > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz))
+                           : Clock::duration::zero()),
+          next_(Clock::now()) {}
+
+    void Wait() {
+        if (period_ == Clock::duration::zero()) return;
+        next_ += period_;
+        std::this_thread::sleep_until(next_);
+    }
+
+   private:
+    Clock::duration period_;
+    Clock::time_point next_;
+};
+
+static void PoseWriter(SimulatorCore& simulator, const DeviceProfile& profile, double hz,
+                       const std::atomic<bool>& stop, std::atomic<uint64_t>& writes) {
+    RateLimiter rate(hz);
+    uint64_t n = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        const DeviceDef& dev = profile.devices[n % profile.devices.size()];
+        OxPose pose = dev.default_pose;
+        pose.position.y += static_cast<float>(n % 100) * 0.001f;
+        simulator.SetDevicePose(dev.user_path, pose, true);
+        n++;
+        rate.Wait();
+    }
+    writes.fetch_add(n, std::memory_order_relaxed);
+}
+
+static void InputWriter(SimulatorCore& simulator, const DeviceProfile& profile, const std::vector<LinkedVec2>& linked,
+                        int seed, double hz, const std::atomic<bool>& stop, std::atomic<uint64_t>& writes) {
+    RateLimiter rate(hz);
+    uint64_t n = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        // Distinct value per write so the reader can tell updates apart.
+        const uint64_t step = (n * 7919 + static_cast<uint64_t>(seed) * 104729) % 2000;
+        const float value = static_cast<float>(step) / 1000.0f - 1.0f;
+
+        if (!linked.empty() && n % 2 == 0) {
+            // Linked pairs, written alternately through the VEC2 and through one of its axes
+            const LinkedVec2& l = linked[(n / 2) % linked.size()];
+            if (n % 4 == 0) {
+                simulator.SetInputStateVec2(l.user_path, l.vec2_path, OxVector2f{value, -value});
+            } else {
+                simulator.SetInputStateFloat(l.user_path, (n % 8 == 2) ? l.x_path : l.y_path, value);
+            }
+        } else {
+            const DeviceDef& dev = profile.devices[n % profile.devices.size()];
+            if (!dev.components.empty()) {
+                const ComponentDef& comp = dev.components[(n / profile.devices.size()) % dev.components.size()];
+                switch (comp.type) {
+                    case ComponentType::BOOLEAN:
+                        simulator.SetInputStateBoolean(dev.user_path, comp.path, value > 0.0f);
+                        break;
+                    case ComponentType::FLOAT:
+                        simulator.SetInputStateFloat(dev.user_path, comp.path, value);
+                        break;
+                    case ComponentType::VEC2:
+                        simulator.SetInputStateVec2(dev.user_path, comp.path, OxVector2f{value, -value});
+                        break;
+                }
+            }
+        }
+        n++;
+        rate.Wait();
+    }
+    writes.fetch_add(n, std::memory_order_relaxed);
+}
+
+struct ReaderStats {
+    uint64_t frames = 0;
+    uint64_t deadline_misses = 0;
+    uint64_t torn_reads = 0;
+    uint64_t linked_checks = 0;
+    std::vector<int64_t> frame_ns;  // scheduled frame start -> last callback returned
+    std::vector<int64_t> call_ns;   // individual callbacks
+};
+
+static int64_t ElapsedNs(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+static void Reader(SimulatorCore& simulator, const DeviceProfile& profile, const std::vector<LinkedVec2>& linked,
+                   const StressOptions& options, const std::atomic<bool>& stop, ReaderStats& stats) {
+    const Clock::duration period =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.reader_hz));
+    const int64_t deadline_ns = options.deadline_us * 1000;
+
+    OxDeviceState states[OX_MAX_DEVICES];
+    uint32_t count = 0;
+    Clock::time_point frame_start = Clock::now();
+
+    // Times one callback into stats.call_ns.
+    auto timed = [&stats](auto&& call) {
+        const Clock::time_point start = Clock::now();
+        call();
+        stats.call_ns.push_back(ElapsedNs(start, Clock::now()));
+    };
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_until(frame_start);
+
+        // Commit mode: publish the writes staged since the last frame, as the driver's first
+        // callback of a frame does.
+        const int64_t predicted_time = ElapsedNs(Clock::time_point{}, frame_start);
+        timed([&] {
+            simulator.OnFrameBoundary(predicted_time);
+            simulator.UpdateAllDevices(states, &count);
+        });
+
+        // Component reads go through the predicted-time overloads, as the driver's input callbacks
+        // do, so latched values and generators are sampled like in a real session.
+        for (const DeviceDef& dev : profile.devices) {
+            for (const ComponentDef& comp : dev.components) {
+                switch (comp.type) {
+                    case ComponentType::BOOLEAN: {
+                        bool b = false;
+                        timed([&] { simulator.GetInputStateBoolean(dev.user_path, comp.path, predicted_time, &b); });
+                        break;
+                    }
+                    case ComponentType::FLOAT: {
+                        float f = 0.0f;
+                        timed([&] { simulator.GetInputStateFloat(dev.user_path, comp.path, predicted_time, &f); });
+                        break;
+                    }
+                    case ComponentType::VEC2: {
+                        OxVector2f v;
+                        timed([&] { simulator.GetInputStateVec2(dev.user_path, comp.path, predicted_time, &v); });
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Linked pair consistency: if the VEC2 did not change while its axes were read, the
+        // axes must match it.
+        for (const LinkedVec2& l : linked) {
+            OxVector2f before, after;
+            float x = 0.0f, y = 0.0f;
+            simulator.GetInputStateVec2(l.user_path, l.vec2_path, &before);
+            simulator.GetInputStateFloat(l.user_path, l.x_path, &x);
+            simulator.GetInputStateFloat(l.user_path, l.y_path, &y);
+            simulator.GetInputStateVec2(l.user_path, l.vec2_path, &after);
+            stats.linked_checks++;
+            if (before.x == after.x && before.y == after.y && (x != before.x || y != before.y)) stats.torn_reads++;
+        }
+
+        const int64_t frame_ns = ElapsedNs(frame_start, Clock::now());
+        stats.frame_ns.push_back(frame_ns);
+        if (frame_ns > deadline_ns) stats.deadline_misses++;
+        stats.frames++;
+
+        // Fixed schedule; if we fell more than a frame behind, skip ahead instead of bursting.
+        frame_start += period;
+        const Clock::time_point now = Clock::now();
+        if (now > frame_start + period) frame_start = now;
+    }
+}
+
+static double Percentile(std::vector<int64_t>& values, double p) {
+    if (values.empty()) return 0.0;
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return static_cast<double>(values[index]) / 1000.0;
+}
+
+static void AppendLatency(std::ostringstream& out, const char* name, std::vector<int64_t>& values) {
+    const int64_t max_ns = values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+    const double max_us = static_cast<double>(max_ns) / 1000.0;
+    out << "\"" << name << "\": {\"count\": " << values.size() << ", \"p50_us\": " << Percentile(values, 0.50)
+        << ", \"p99_us\": " << Percentile(values, 0.99) << ", \"p999_us\": " << Percentile(values, 0.999)
+        << ", \"max_us\": " << max_us << "}";
+}
+
+int main(int argc, char** argv) {
+    StressOptions options;
+    if (!ParseOptions(argc, argv, options)) return 2;
+
+    const DeviceProfile* profile = GetDeviceProfileByName(options.device);
+    if (!profile) {
+        std::cerr << "Unknown device: " << options.device << std::endl;
+        return 2;
+    }
+
+    lock_profiler::SetEnabled(options.lock_profiling);
+
+    SimulatorCore simulator;
+    simulator.Initialize(profile);
+    simulator.SetCommitMode(options.frame_commit);
+    const std::vector<LinkedVec2> linked = FindLinkedVec2s(*profile);
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> pose_writes{0};
+    std::atomic<uint64_t> input_writes{0};
+    ReaderStats stats;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.pose_writers; i++) {
+        threads.emplace_back(PoseWriter, std::ref(simulator), std::cref(*profile), options.writer_hz, std::cref(stop),
+                             std::ref(pose_writes));
+    }
+    for (int i = 0; i < options.input_writers; i++) {
+        threads.emplace_back(InputWriter, std::ref(simulator), std::cref(*profile), std::cref(linked), i,
+                             options.writer_hz, std::cref(stop), std::ref(input_writes));
+    }
+    std::thread reader(Reader, std::ref(simulator), std::cref(*profile), std::cref(linked), std::cref(options),
+                       std::cref(stop), std::ref(stats));
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop.store(true);
+    reader.join();
+    for (std::thread& t : threads) t.join();
+
+    std::ostringstream out;
+    out << "{\n  \"config\": {\"device\": \"" << options.device << "\", \"seconds\": " << options.seconds
+        << ", \"reader_hz\": " << options.reader_hz << ", \"deadline_us\": " << options.deadline_us
+        << ", \"pose_writers\": " << options.pose_writers << ", \"input_writers\": " << options.input_writers
+        << ", \"writer_hz\": " << options.writer_hz
+        << ", \"frame_commit\": " << (options.frame_commit ? "true" : "false") << "},\n";
+    out << "  \"writes\": {\"pose\": " << pose_writes.load() << ", \"input\": " << input_writes.load() << "},\n";
+    out << "  \"reader\": {\"frames\": " << stats.frames << ", \"deadline_misses\": " << stats.deadline_misses
+        << ", \"linked_checks\": " << stats.linked_checks << ", \"torn_reads\": " << stats.torn_reads << ",\n    ";
+    AppendLatency(out, "frame_latency", stats.frame_ns);
+    out << ",\n    ";
+    AppendLatency(out, "call_latency", stats.call_ns);
+    out << "\n  }\n}\n";
+
+    if (options.out_path.empty()) {
+        std::cout << out.str();
+    } else {
+        std::ofstream file(options.out_path);
+        if (!file) {
+            std::cerr << "Failed to open " << options.out_path << std::endl;
+            return 1;
+        }
+        file << out.str();
+    }
+
+    if (options.strict && (stats.deadline_misses > 0 || stats.torn_reads > 0)) return 1;
+    return 0;
+}
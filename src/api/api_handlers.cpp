@@ -0,0 +1,1318 @@
+#include "api_handlers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "arena_json.h"
+#include "buffer_pool.h"
+#include "frame_data.h"
+#include "frame_encoder.h"
+#include "metrics.h"
+#include "profiled_mutex.h"
+#include "request_arena.h"
+#include "scenario_loader.h"
+#include "trace.h"
+
+namespace ox_sim {
+
+// Map OxSessionState enum to a human-readable string
+static const char* SessionStateName(OxSessionState s) {
+    switch (s) {
+        case OX_SESSION_STATE_UNKNOWN:
+            return "unknown";
+        case OX_SESSION_STATE_IDLE:
+            return "idle";
+        case OX_SESSION_STATE_READY:
+            return "ready";
+        case OX_SESSION_STATE_SYNCHRONIZED:
+            return "synchronized";
+        case OX_SESSION_STATE_VISIBLE:
+            return "visible";
+        case OX_SESSION_STATE_FOCUSED:
+            return "focused";
+        case OX_SESSION_STATE_STOPPING:
+            return "stopping";
+        case OX_SESSION_STATE_EXITING:
+            return "exiting";
+        default:
+            return "unknown";
+    }
+}
+
+// Split "/user/.../input/..." into its user path and component path, both NUL-terminated copies in
+// `arena`. Both are empty (but still valid C strings) if there is no "/input/" segment.
+static std::pair<std::string_view, std::string_view> SplitBindingPath(RequestArena& arena,
+                                                                      std::string_view binding_path) {
+    size_t pos = binding_path.find("/input/");
+    if (pos == std::string_view::npos) {
+        return {arena.Copy(""), arena.Copy("")};  // Invalid path
+    }
+    return {arena.Copy(binding_path.substr(0, pos)), arena.Copy(binding_path.substr(pos))};
+}
+
+// A JSON response whose body was built in the request arena. The body is copied out because the
+// arena is reset before Crow writes the response.
+static crow::response JsonResponse(const JsonWriter& writer) {
+    crow::response res(200, std::string(writer.View()));
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+// The members of a pose object; false unless all of them are numbers.
+static bool ReadNumbers(const JsonNode* object, const char* const* names, float* const* out, int count) {
+    if (!object) return false;
+    for (int i = 0; i < count; i++) {
+        const JsonNode* value = object->Find(names[i]);
+        if (!value || !value->IsNumber()) return false;
+        *out[i] = static_cast<float>(value->number);
+    }
+    return true;
+}
+
+// The pose and input routes are the hot path for test drivers, so they parse and build JSON in the
+// calling thread's RequestArena instead of crow::json, which allocates per node and per number.
+crow::response HandleGetDevice(SimulatorCore& simulator, const std::string& user_path) {
+    RequestArena& arena = RequestArena::ForThread();
+    // prepend '/' to user_path since it'll be missing
+    std::string_view full_user_path = arena.Concat("/", user_path);
+
+    OxPose pose;
+    bool is_active;
+    if (!simulator.GetDevicePose(full_user_path.data(), &pose, &is_active)) {
+        return crow::response(404, "Device not found");
+    }
+
+    JsonWriter writer(arena);
+    writer.BeginObject().Key("active").Bool(is_active);
+    writer.Key("position").BeginObject();
+    writer.Key("x").Number(pose.position.x).Key("y").Number(pose.position.y).Key("z").Number(pose.position.z);
+    writer.EndObject();
+    writer.Key("orientation").BeginObject();
+    writer.Key("x").Number(pose.orientation.x).Key("y").Number(pose.orientation.y);
+    writer.Key("z").Number(pose.orientation.z).Key("w").Number(pose.orientation.w);
+    writer.EndObject().EndObject();
+    return JsonResponse(writer);
+}
+
+crow::response HandlePutDevice(SimulatorCore& simulator, const crow::request& req, const std::string& user_path) {
+    RequestArena& arena = RequestArena::ForThread();
+    const JsonNode* json = ParseJson(arena, req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    OxPose pose;
+    static const char* const kPositionNames[] = {"x", "y", "z"};
+    static const char* const kOrientationNames[] = {"x", "y", "z", "w"};
+    float* const position[] = {&pose.position.x, &pose.position.y, &pose.position.z};
+    float* const orientation[] = {&pose.orientation.x, &pose.orientation.y, &pose.orientation.z, &pose.orientation.w};
+    if (!ReadNumbers(json->Find("position"), kPositionNames, position, 3) ||
+        !ReadNumbers(json->Find("orientation"), kOrientationNames, orientation, 4)) {
+        return crow::response(400, "Missing required fields: position{x,y,z}, orientation{x,y,z,w}");
+    }
+
+    bool is_active = true;
+    if (const JsonNode* active = json->Find("active")) {
+        if (!active->IsBool()) {
+            return crow::response(400, "Invalid value for active");
+        }
+        is_active = active->Bool();
+    }
+
+    // prepend '/' to user_path since it'll be missing
+    std::string_view full_user_path = arena.Concat("/", user_path);
+
+    simulator.SetDevicePose(full_user_path.data(), pose, is_active);
+    return crow::response(200, "OK");
+}
+
+crow::response HandleGetInput(SimulatorCore& simulator, const std::string& binding_path) {
+    RequestArena& arena = RequestArena::ForThread();
+    // prepend '/' to binding_path since it'll be missing
+    std::string_view full_binding_path = arena.Concat("/", binding_path);
+
+    auto [user_path, component_path] = SplitBindingPath(arena, full_binding_path);
+    if (user_path.empty() || component_path.empty()) {
+        return crow::response(400, "Invalid binding path");
+    }
+
+    // Determine component type from device profile
+    const DeviceDef* device_def = simulator.FindDeviceDefByUserPath(user_path.data());
+    if (!device_def) {
+        return crow::response(404, "Device not found");
+    }
+    auto [comp_index, comp_type] = simulator.FindComponentInfo(device_def, component_path.data());
+    if (comp_index == -1) {
+        return crow::response(404, "Component not found in device profile");
+    }
+
+    JsonWriter writer(arena);
+    OxComponentResult result;
+
+    // Call the appropriate type-specific function
+    if (comp_type == ComponentType::BOOLEAN) {
+        bool value = false;
+        result = simulator.GetInputStateBoolean(user_path.data(), component_path.data(), &value);
+        if (result != OX_COMPONENT_AVAILABLE) {
+            return crow::response(404, "Component not available");
+        }
+        writer.BeginObject().Key("type").String("boolean").Key("value").Bool(value).EndObject();
+    } else if (comp_type == ComponentType::FLOAT) {
+        float value = 0.0f;
+        result = simulator.GetInputStateFloat(user_path.data(), component_path.data(), &value);
+        if (result != OX_COMPONENT_AVAILABLE) {
+            return crow::response(404, "Component not available");
+        }
+        writer.BeginObject().Key("type").String("float").Key("value").Number(value).EndObject();
+    } else {  // VEC2
+        OxVector2f vec;
+        result = simulator.GetInputStateVec2(user_path.data(), component_path.data(), &vec);
+        if (result != OX_COMPONENT_AVAILABLE) {
+            return crow::response(404, "Component not available");
+        }
+        writer.BeginObject().Key("type").String("vec2").Key("x").Number(vec.x).Key("y").Number(vec.y).EndObject();
+    }
+
+    return JsonResponse(writer);
+}
+
+crow::response HandlePutInput(SimulatorCore& simulator, const crow::request& req, const std::string& binding_path) {
+    RequestArena& arena = RequestArena::ForThread();
+    const JsonNode* json = ParseJson(arena, req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    // prepend '/' to binding_path since it'll be missing
+    std::string_view full_binding_path = arena.Concat("/", binding_path);
+
+    auto [user_path, component_path] = SplitBindingPath(arena, full_binding_path);
+    if (user_path.empty() || component_path.empty()) {
+        return crow::response(400, "Invalid binding path");
+    }
+
+    // Determine component type from device profile
+    const DeviceDef* device_def = simulator.FindDeviceDefByUserPath(user_path.data());
+    if (!device_def) {
+        return crow::response(404, "Device not found");
+    }
+    auto [comp_index, comp_type] = simulator.FindComponentInfo(device_def, component_path.data());
+    if (comp_index == -1) {
+        return crow::response(404, "Component not found in device profile");
+    }
+
+    // Handle different component types
+    switch (comp_type) {
+        case ComponentType::BOOLEAN: {
+            const JsonNode* value = json->Find("value");
+            if (!value) {
+                return crow::response(400, "Missing required field: value");
+            }
+            bool bool_value = false;
+            if (value->IsBool()) {
+                bool_value = value->Bool();
+            } else if (value->IsNumber()) {
+                bool_value = value->number >= 0.5;
+            } else {
+                return crow::response(400, "Invalid value for boolean component");
+            }
+            simulator.SetInputStateBoolean(user_path.data(), component_path.data(), bool_value);
+            break;
+        }
+        case ComponentType::FLOAT: {
+            const JsonNode* value = json->Find("value");
+            if (!value) {
+                return crow::response(400, "Missing required field: value");
+            }
+            float float_value = 0.0f;
+            if (value->IsNumber()) {
+                float_value = static_cast<float>(value->number);
+            } else if (value->IsBool()) {
+                float_value = value->Bool() ? 1.0f : 0.0f;
+            } else {
+                return crow::response(400, "Invalid value for float component");
+            }
+            simulator.SetInputStateFloat(user_path.data(), component_path.data(), float_value);
+            break;
+        }
+        case ComponentType::VEC2: {
+            OxVector2f vec = {0.0f, 0.0f};
+
+            // Check if it's an object with x,y fields
+            const JsonNode* x = json->Find("x");
+            const JsonNode* y = json->Find("y");
+            if (x && y) {
+                if (x->IsNumber() && y->IsNumber()) {
+                    vec.x = static_cast<float>(x->number);
+                    vec.y = static_cast<float>(y->number);
+                } else {
+                    return crow::response(400, "Invalid x,y values for vec2 component");
+                }
+            } else {
+                return crow::response(400, "Missing required fields: x,y for vec2 component");
+            }
+
+            simulator.SetInputStateVec2(user_path.data(), component_path.data(), vec);
+            break;
+        }
+    }
+
+    return crow::response(200, "OK");
+}
+
+crow::response HandleGetStatus() {
+    FrameData* fd = GetFrameData();
+    OxSessionState state = fd ? static_cast<OxSessionState>(fd->session_state.load(std::memory_order_relaxed))
+                              : OX_SESSION_STATE_UNKNOWN;
+    uint32_t fps = (fd && fd->IsSessionActive()) ? fd->app_fps.load(std::memory_order_relaxed) : 0u;
+
+    crow::json::wvalue response;
+    response["session_state"] = SessionStateName(state);
+    response["session_state_id"] = static_cast<int>(state);
+    response["session_active"] = fd ? fd->IsSessionActive() : false;
+    response["fps"] = fps;
+    return crow::response(response);
+}
+
+// Reused buffers for GET /v1/views: the frame copy taken under the frame lock and its resized version,
+// ?format=raw bodies and ?stream=true snapshots. A client polling both eyes keeps two bodies in flight,
+// plus the copies of the requests being handled.
+static BufferPool g_view_buffers(4);
+
+// Filtered bytes per streamed PNG strip, so each IDAT chunk is about this large before compression.
+static constexpr size_t kViewStreamStripBytes = 64 * 1024;
+
+// Encoded strips a streamed view may hold ahead of a connection that is slower than the encoder.
+static constexpr size_t kViewStreamQueuedStrips = 2;
+
+namespace {
+
+// The body of a ?stream=true view. Strips are encoded one task at a time (the encoder is sequential),
+// at most kViewStreamQueuedStrips ahead of the connection, and handed over as the connection asks for
+// them, so neither side waits on the other's thread. Tasks keep the stream alive; Cancel() stops them
+// once the response no longer wants the rest of the image.
+class ViewStream : public std::enable_shared_from_this<ViewStream> {
+   public:
+    ViewStream(std::shared_ptr<std::vector<uint8_t>> snapshot, uint32_t width, uint32_t height, uint32_t strip_rows,
+               const ViewStreaming& streaming)
+        : snapshot_(std::move(snapshot)),
+          encoder_(snapshot_->data(), width, height, strip_rows),
+          streaming_(streaming) {}
+
+    // Called by the connection for each chunk; answers at once if a strip is ready, otherwise as soon
+    // as the running task has encoded one.
+    void Request(crow::response::chunk_callback next) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) return;
+        if (ready_.empty() && !finished_) {
+            waiting_ = std::move(next);
+            ScheduleLocked();
+            return;
+        }
+        std::string chunk;
+        if (!ready_.empty()) {
+            chunk = std::move(ready_.front());
+            ready_.pop_front();
+        }
+        ScheduleLocked();
+        DeliverLocked(next, std::move(chunk));
+    }
+
+    void Cancel() {
+        // The callback holds the connection, so it is released after the lock.
+        crow::response::chunk_callback waiting;
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        waiting.swap(waiting_);
+        ready_.clear();
+    }
+
+   private:
+    // Start an encode task unless one is running, the queue is full or the image is done. If no task
+    // can be started the body ends here, cut short; the client sees a truncated PNG.
+    void ScheduleLocked() {
+        if (scheduled_ || finished_ || cancelled_ || ready_.size() >= kViewStreamQueuedStrips) return;
+        scheduled_ = true;
+        if (streaming_.submit([self = shared_from_this()] { self->Encode(); })) return;
+        scheduled_ = false;
+        finished_ = true;
+        if (waiting_) DeliverLocked(std::exchange(waiting_, nullptr), std::string());
+    }
+
+    void Encode() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) {
+                scheduled_ = false;
+                return;
+            }
+        }
+        // Only the one scheduled task touches the encoder, so it runs outside the lock.
+        std::string chunk;
+        const bool more = encoder_.Next(chunk);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        scheduled_ = false;
+        if (cancelled_) return;
+        finished_ = !more;
+        if (waiting_) {
+            DeliverLocked(std::exchange(waiting_, nullptr), std::move(chunk));
+        } else {
+            ready_.push_back(std::move(chunk));
+        }
+        ScheduleLocked();
+    }
+
+    // The callback only posts the write to the connection's thread, so it is cheap to call with the
+    // lock held.
+    void DeliverLocked(const crow::response::chunk_callback& next, std::string chunk) {
+        if (streaming_.bytes_sent) streaming_.bytes_sent->Add(chunk.size());
+        const bool more = !(finished_ && ready_.empty());
+        next(std::move(chunk), more);
+    }
+
+    std::shared_ptr<std::vector<uint8_t>> snapshot_;  // the pixels encoder_ reads
+    PngStreamEncoder encoder_;
+    const ViewStreaming streaming_;
+
+    std::mutex mutex_;  // per request and never contended for long, so not a ProfiledMutex
+    std::deque<std::string> ready_;
+    crow::response::chunk_callback waiting_;  // the connection's request while no strip is ready
+    bool scheduled_ = false;
+    bool finished_ = false;  // the encoder has returned the last strip
+    bool cancelled_ = false;
+};
+
+// Owned by the response's chunk source; cancels the stream when the response drops it.
+struct ViewStreamOwner {
+    std::shared_ptr<ViewStream> stream;
+    ~ViewStreamOwner() { stream->Cancel(); }
+};
+
+}  // namespace
+
+crow::response HandleGetView(const crow::request& req, int eye_index, const ViewStreaming* streaming) {
+    FrameData* fd = GetFrameData();
+    if (!fd) {
+        return crow::response(503, "Frame data unavailable");
+    }
+
+    bool raw = false;
+    if (auto format_param = req.url_params.get("format")) {
+        if (std::strcmp(format_param, "raw") == 0) {
+            raw = true;
+        } else if (std::strcmp(format_param, "png") != 0) {
+            return crow::response(400, "Invalid value for format (png or raw)");
+        }
+    }
+    bool stream = false;
+    if (auto stream_param = req.url_params.get("stream")) {
+        const std::string value = stream_param;
+        if (value != "true" && value != "false") {
+            return crow::response(400, "Invalid value for stream (true or false)");
+        }
+        stream = value == "true" && streaming && !(req.http_ver_major == 1 && req.http_ver_minor == 0);
+    }
+
+    // Only copying the frame happens under the frame lock, which submit_frame_pixels waits on; resizing
+    // and encoding work on the copy.
+    ProfiledLock lock(fd->mutex);
+
+    if (!fd->pixel_data[eye_index] || fd->width == 0 || fd->height == 0) {
+        return crow::response(404, "No frame available");
+    }
+
+    uint32_t output_width = fd->width;
+    uint32_t output_height = fd->height;
+
+    // Check for optional "size" query parameter (target width)
+    if (auto size_param = req.url_params.get("size")) {
+        try {
+            int requested_width = std::stoi(size_param);
+            if (requested_width > 0) {
+                float aspect_ratio = static_cast<float>(fd->width) / static_cast<float>(fd->height);
+                output_width = static_cast<uint32_t>(requested_width);
+                output_height = static_cast<uint32_t>(requested_width / aspect_ratio);
+            }
+        } catch (...) {
+            // Invalid size parameter, ignore and use original size
+        }
+    }
+
+    const uint32_t frame_width = fd->width;
+    const uint32_t frame_height = fd->height;
+    auto frame = g_view_buffers.Acquire(static_cast<size_t>(frame_width) * frame_height * 4);
+    std::memcpy(frame->data(), fd->pixel_data[eye_index], frame->size());
+    lock.unlock();
+
+    if (output_width != frame_width || output_height != frame_height) {
+        auto resized = g_view_buffers.Acquire(static_cast<size_t>(output_width) * output_height * 4);
+        if (!ResizeRGBA(frame->data(), frame_width, frame_height, output_width, output_height, *resized)) {
+            return crow::response(500, "Image resizing failed");
+        }
+        frame = std::move(resized);
+    }
+    const uint8_t* pixels = frame->data();
+
+    // Both formats go out from a shared buffer, without being copied into the response body.
+    crow::response resp;
+    resp.code = 200;
+    if (raw) {
+        auto buffer = g_view_buffers.Acquire(static_cast<size_t>(output_width) * output_height * 4);
+        DownsampleRGBA(pixels, output_width, output_height, 1, buffer->data());
+        resp.set_header("Content-Type", "application/octet-stream");
+        resp.set_header("X-Image-Width", std::to_string(output_width));
+        resp.set_header("X-Image-Height", std::to_string(output_height));
+        resp.set_shared_body(buffer, buffer->data(), buffer->size());
+        return resp;
+    }
+
+    if (stream) {
+        // Turn the copy top row first and opaque, as the encoder wants it, and compress it strip by strip
+        // while the response is written.
+        auto snapshot = g_view_buffers.Acquire(static_cast<size_t>(output_width) * output_height * 4);
+        DownsampleRGBA(pixels, output_width, output_height, 1, snapshot->data());
+        const uint32_t strip_rows = static_cast<uint32_t>(kViewStreamStripBytes / (output_width * 4 + 1));
+        auto owner = std::make_shared<ViewStreamOwner>();
+        owner->stream = std::make_shared<ViewStream>(std::move(snapshot), output_width, output_height, strip_rows,
+                                                     *streaming);
+        resp.set_header("Content-Type", "image/png");
+        resp.set_chunked_body(
+            [owner](crow::response::chunk_callback next) { owner->stream->Request(std::move(next)); });
+        return resp;
+    }
+
+    SharedBytes png = EncodeRGBAToPngShared(pixels, output_width, output_height);
+    if (png.size == 0) {
+        return crow::response(500, "PNG encoding failed");
+    }
+    resp.set_header("Content-Type", "image/png");
+    resp.set_shared_body(std::move(png.owner), png.data, png.size);
+    return resp;
+}
+
+crow::response HandleGetProfile(const DeviceProfile* profile) {
+    if (!profile) {
+        return crow::response(500, "No device profile loaded");
+    }
+
+    crow::json::wvalue response;
+    response["type"] = profile->name;
+    response["manufacturer"] = profile->manufacturer;
+    response["interaction_profile"] = profile->interaction_profile;
+
+    // List devices
+    crow::json::wvalue devices_array(crow::json::type::List);
+    for (size_t i = 0; i < profile->devices.size(); ++i) {
+        const auto& dev = profile->devices[i];
+        crow::json::wvalue dev_obj;
+        dev_obj["user_path"] = dev.user_path;
+        dev_obj["role"] = dev.role;
+        dev_obj["always_active"] = dev.always_active;
+
+        // List components
+        crow::json::wvalue components_array(crow::json::type::List);
+        for (size_t j = 0; j < dev.components.size(); ++j) {
+            const auto& comp = dev.components[j];
+            crow::json::wvalue comp_obj;
+            comp_obj["path"] = comp.path;
+            comp_obj["type"] = (comp.type == ComponentType::FLOAT     ? "float"
+                                : comp.type == ComponentType::BOOLEAN ? "boolean"
+                                                                      : "vec2");
+            comp_obj["description"] = comp.description;
+            components_array[j] = std::move(comp_obj);
+        }
+        dev_obj["components"] = std::move(components_array);
+
+        devices_array[i] = std::move(dev_obj);
+    }
+    response["devices"] = std::move(devices_array);
+
+    return crow::response(response);
+}
+
+crow::response HandlePutProfile(SimulatorCore& simulator, const DeviceProfile** device_profile_ptr,
+                                const crow::request& req) {
+    auto json = crow::json::load(req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    if (!json.has("device") || json["device"].t() != crow::json::type::String) {
+        return crow::response(400, "Missing required field: device (string)");
+    }
+
+    std::string device_name = json["device"].s();
+    const DeviceProfile* new_profile = GetDeviceProfileByName(device_name);
+    if (!new_profile) {
+        return crow::response(404, "Unknown device: " + device_name);
+    }
+
+    // Switch the device
+    if (!simulator.SwitchDevice(new_profile)) {
+        return crow::response(500, "Failed to switch device");
+    }
+
+    // Update the global pointer
+    *device_profile_ptr = new_profile;
+
+    crow::json::wvalue response;
+    response["status"] = "ok";
+    response["device"] = new_profile->name;
+    response["interaction_profile"] = new_profile->interaction_profile;
+    return crow::response(response);
+}
+
+// Reads the optional generator parameters present in `json` into *generator. Returns an error
+// message, or an empty string on success.
+static std::string ParseGenerator(const crow::json::rvalue& json, InputGenerator* generator) {
+    if (!json.has("shape") || json["shape"].t() != crow::json::type::String ||
+        !InputGenerator::ParseShape(json["shape"].s(), &generator->shape)) {
+        return "Missing or invalid shape (ramp, sine, square, circle, figure_eight, random_walk)";
+    }
+
+    struct NumberField {
+        const char* name;
+        float* out;
+    };
+    const NumberField fields[] = {
+        {"min", &generator->min},
+        {"max", &generator->max},
+        {"frequency", &generator->frequency_hz},
+        {"phase", &generator->phase},
+        {"duty", &generator->duty},
+        {"radius", &generator->radius},
+        {"step", &generator->step},
+        {"rate", &generator->rate_hz},
+    };
+    for (const NumberField& field : fields) {
+        if (!json.has(field.name)) continue;
+        if (json[field.name].t() != crow::json::type::Number) {
+            return std::string("Invalid value for ") + field.name + " (number)";
+        }
+        *field.out = static_cast<float>(json[field.name].d());
+    }
+    if (json.has("center")) {
+        const crow::json::rvalue& center = json["center"];
+        if (!center.has("x") || !center.has("y") || center["x"].t() != crow::json::type::Number ||
+            center["y"].t() != crow::json::type::Number) {
+            return "Invalid value for center {x,y}";
+        }
+        generator->center = {static_cast<float>(center["x"].d()), static_cast<float>(center["y"].d())};
+    }
+    if (json.has("seed")) {
+        if (json["seed"].t() != crow::json::type::Number || json["seed"].d() < 0) {
+            return "Invalid value for seed (number >= 0)";
+        }
+        generator->seed = static_cast<uint64_t>(json["seed"].d());
+    }
+
+    if (!(generator->frequency_hz >= 0.0f)) return "frequency must be >= 0";
+    if (!(generator->duty >= 0.0f && generator->duty <= 1.0f)) return "duty must be within 0..1";
+    if (!(generator->rate_hz > 0.0f && generator->rate_hz <= 10000.0f)) return "rate must be within (0, 10000]";
+    return "";
+}
+
+crow::response HandleGetGenerators(SimulatorCore& simulator) {
+    crow::json::wvalue generators(crow::json::type::List);
+    size_t i = 0;
+    for (const auto& [binding_path, g] : simulator.GetInputGenerators()) {
+        crow::json::wvalue entry;
+        entry["input"] = binding_path;
+        entry["shape"] = InputGenerator::ShapeName(g.shape);
+        entry["min"] = g.min;
+        entry["max"] = g.max;
+        entry["frequency"] = g.frequency_hz;
+        entry["phase"] = g.phase;
+        entry["duty"] = g.duty;
+        entry["radius"] = g.radius;
+        entry["center"]["x"] = g.center.x;
+        entry["center"]["y"] = g.center.y;
+        entry["step"] = g.step;
+        entry["rate"] = g.rate_hz;
+        entry["seed"] = g.seed;
+        generators[i++] = std::move(entry);
+    }
+
+    crow::json::wvalue response;
+    response["generators"] = std::move(generators);
+    return crow::response(response);
+}
+
+crow::response HandleDeleteGenerators(SimulatorCore& simulator) {
+    simulator.ClearInputGenerators();
+    return crow::response(200, "OK");
+}
+
+crow::response HandlePutGenerator(SimulatorCore& simulator, const crow::request& req, const std::string& binding_path) {
+    auto json = crow::json::load(req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    RequestArena& arena = RequestArena::ForThread();
+    auto [user_path, component_path] = SplitBindingPath(arena, arena.Concat("/", binding_path));
+    if (user_path.empty() || component_path.empty()) {
+        return crow::response(400, "Invalid binding path");
+    }
+
+    InputGenerator generator;
+    std::string error = ParseGenerator(json, &generator);
+    if (!error.empty()) {
+        return crow::response(400, error);
+    }
+
+    const DeviceDef* device_def = simulator.FindDeviceDefByUserPath(user_path.data());
+    if (!device_def || simulator.FindComponentInfo(device_def, component_path.data()).first == -1) {
+        return crow::response(404, "Component not found in device profile");
+    }
+    if (!simulator.SetInputGenerator(user_path.data(), component_path.data(), generator)) {
+        return crow::response(400, std::string("Shape ") + InputGenerator::ShapeName(generator.shape) +
+                                       " does not fit this component's type");
+    }
+    return crow::response(200, "OK");
+}
+
+crow::response HandleDeleteGenerator(SimulatorCore& simulator, const std::string& binding_path) {
+    RequestArena& arena = RequestArena::ForThread();
+    auto [user_path, component_path] = SplitBindingPath(arena, arena.Concat("/", binding_path));
+    if (user_path.empty() || component_path.empty()) {
+        return crow::response(400, "Invalid binding path");
+    }
+    if (!simulator.ClearInputGenerator(user_path.data(), component_path.data())) {
+        return crow::response(404, "No generator on this component");
+    }
+    return crow::response(200, "OK");
+}
+
+crow::response HandleGetScenario(const ScenarioRunner& runner) {
+    const ScenarioRunner::Status status = runner.GetStatus();
+
+    crow::json::wvalue response;
+    response["state"] = ScenarioRunner::StateName(status.state);
+    response["time"] = static_cast<double>(status.time_ns) / 1e9;
+    response["duration"] = static_cast<double>(status.duration_ns) / 1e9;
+    response["next_event"] = status.next_event;
+    response["events"] = status.event_count;
+    response["frames"] = status.frames;
+    if (!status.error.empty()) {
+        response["error"] = status.error;
+    }
+    return crow::response(response);
+}
+
+crow::response HandlePutScenario(SimulatorCore& simulator, const DeviceProfile** device_profile_ptr,
+                                 ScenarioRunner& runner, const crow::request& req) {
+    Scenario scenario;
+    std::string error;
+    if (!CompileScenario(req.body, *device_profile_ptr, &scenario, &error)) {
+        return crow::response(400, error);
+    }
+
+    crow::json::wvalue response;
+    response["status"] = "ok";
+    response["events"] = scenario.events.size();
+    response["duration"] = static_cast<double>(scenario.duration_ns) / 1e9;
+    runner.Start(std::move(scenario), &simulator, device_profile_ptr);
+    return crow::response(response);
+}
+
+crow::response HandleDeleteScenario(ScenarioRunner& runner) {
+    runner.Stop();
+    return crow::response(200, "OK");
+}
+
+crow::response HandleGetCommit(SimulatorCore& simulator) {
+    crow::json::wvalue response;
+    response["enabled"] = simulator.GetCommitMode();
+    response["staged"] = simulator.GetStagedCount();
+    return crow::response(response);
+}
+
+crow::response HandlePutCommit(SimulatorCore& simulator, const crow::request& req) {
+    auto json = crow::json::load(req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+    if (!json.has("enabled") ||
+        (json["enabled"].t() != crow::json::type::True && json["enabled"].t() != crow::json::type::False)) {
+        return crow::response(400, "Missing required field: enabled (boolean)");
+    }
+    simulator.SetCommitMode(json["enabled"].b());
+    return crow::response(200, "OK");
+}
+
+crow::response HandlePostCommit(SimulatorCore& simulator) {
+    crow::json::wvalue response;
+    response["committed"] = simulator.CommitStaged();
+    return crow::response(response);
+}
+
+// Parse a component value: true/false or a number for BOOLEAN and FLOAT, {x, y} for VEC2.
+static bool ParseInputValue(const crow::json::rvalue& json, ComponentType type, InputValue* out) {
+    const crow::json::type t = json.t();
+    const bool is_bool = t == crow::json::type::True || t == crow::json::type::False;
+    switch (type) {
+        case ComponentType::BOOLEAN:
+            if (is_bool) *out = json.b();
+            if (t == crow::json::type::Number) *out = json.d() >= 0.5;
+            return is_bool || t == crow::json::type::Number;
+        case ComponentType::FLOAT:
+            if (is_bool) *out = json.b() ? 1.0f : 0.0f;
+            if (t == crow::json::type::Number) *out = static_cast<float>(json.d());
+            return is_bool || t == crow::json::type::Number;
+        case ComponentType::VEC2:
+            if (t != crow::json::type::Object || !json.has("x") || !json.has("y") ||
+                json["x"].t() != crow::json::type::Number || json["y"].t() != crow::json::type::Number) {
+                return false;
+            }
+            *out = OxVector2f{static_cast<float>(json["x"].d()), static_cast<float>(json["y"].d())};
+            return true;
+    }
+    return false;
+}
+
+// Parse {"x", "y", "width", "height"} (pixels, GET /v1/views coordinates).
+static bool ParsePixelRect(const crow::json::rvalue& json, PixelRect* out) {
+    const char* names[] = {"x", "y", "width", "height"};
+    uint32_t* fields[] = {&out->x, &out->y, &out->width, &out->height};
+    for (size_t i = 0; i < 4; i++) {
+        if (!json.has(names[i]) || json[names[i]].t() != crow::json::type::Number) return false;
+        const double value = json[names[i]].d();
+        if (!(value >= 0.0 && value <= 65535.0)) return false;
+        *fields[i] = static_cast<uint32_t>(value);
+    }
+    return out->width > 0 && out->height > 0;
+}
+
+crow::response HandleGetLatency(const LatencyProbe& probe) {
+    const LatencyProbe::Status status = probe.GetStatus();
+
+    crow::json::wvalue response;
+    response["state"] = LatencyProbe::StateName(status.state);
+    response["trials"] = status.trials;
+    response["completed"] = status.samples.size();
+    response["timeouts"] = status.timeouts;
+    if (!status.error.empty()) {
+        response["error"] = status.error;
+    }
+
+    crow::json::wvalue samples(crow::json::type::List);
+    std::vector<double> latencies_ms;
+    double frames_total = 0.0;
+    for (size_t i = 0; i < status.samples.size(); i++) {
+        const LatencyProbe::Sample& sample = status.samples[i];
+        const double ms = static_cast<double>(sample.latency_ns) / 1e6;
+        samples[i]["frames"] = sample.frames;
+        samples[i]["ms"] = ms;
+        latencies_ms.push_back(ms);
+        frames_total += sample.frames;
+    }
+    response["samples"] = std::move(samples);
+
+    if (!latencies_ms.empty()) {
+        std::sort(latencies_ms.begin(), latencies_ms.end());
+        auto percentile = [&latencies_ms](double p) {
+            return latencies_ms[std::min(latencies_ms.size() - 1, static_cast<size_t>(p * latencies_ms.size()))];
+        };
+        double sum = 0.0;
+        for (double ms : latencies_ms) sum += ms;
+        response["latency_ms"]["min"] = latencies_ms.front();
+        response["latency_ms"]["p50"] = percentile(0.50);
+        response["latency_ms"]["p90"] = percentile(0.90);
+        response["latency_ms"]["p99"] = percentile(0.99);
+        response["latency_ms"]["max"] = latencies_ms.back();
+        response["latency_ms"]["mean"] = sum / static_cast<double>(latencies_ms.size());
+        response["mean_frames"] = frames_total / static_cast<double>(latencies_ms.size());
+    }
+    return crow::response(response);
+}
+
+crow::response HandlePutLatency(SimulatorCore& simulator, LatencyProbe& probe, const crow::request& req) {
+    auto json = crow::json::load(req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    LatencyProbeConfig config;
+    if (!json.has("input") || json["input"].t() != crow::json::type::String) {
+        return crow::response(400, "Missing required field: input (binding path)");
+    }
+    const std::string input = json["input"].s();
+    auto [user_path, component_path] = SplitBindingPath(RequestArena::ForThread(), input);
+    if (user_path.empty() || component_path.empty()) {
+        return crow::response(400, "Invalid binding path");
+    }
+    const DeviceDef* device_def = simulator.FindDeviceDefByUserPath(user_path.data());
+    if (!device_def) {
+        return crow::response(404, "Device not found");
+    }
+    auto [comp_index, comp_type] = simulator.FindComponentInfo(device_def, component_path.data());
+    if (comp_index == -1) {
+        return crow::response(404, "Component not found in device profile");
+    }
+    config.user_path = std::string(user_path);
+    config.component_path = std::string(component_path);
+    config.type = comp_type;
+
+    if (!json.has("active") || !ParseInputValue(json["active"], comp_type, &config.active_value)) {
+        return crow::response(400, "Missing or invalid active (the value to inject)");
+    }
+    if (json.has("rest")) {
+        if (!ParseInputValue(json["rest"], comp_type, &config.rest_value)) {
+            return crow::response(400, "Invalid value for rest");
+        }
+    } else if (comp_type == ComponentType::BOOLEAN) {
+        config.rest_value = false;
+    } else if (comp_type == ComponentType::FLOAT) {
+        config.rest_value = 0.0f;
+    } else {
+        config.rest_value = OxVector2f{0.0f, 0.0f};
+    }
+
+    if (!json.has("region") || !ParsePixelRect(json["region"], &config.region)) {
+        return crow::response(400, "Missing or invalid region {x, y, width, height}");
+    }
+
+    struct NumberField {
+        const char* name;
+        double min;
+        double max;
+        double value;
+    };
+    NumberField fields[] = {
+        {"eye", 0, 1, 0},
+        {"threshold", 0, 255, config.threshold},
+        {"trials", 1, 10000, static_cast<double>(config.trials)},
+        {"settle_frames", 0, 10000, static_cast<double>(config.settle_frames)},
+        {"timeout", 0.001, 60, static_cast<double>(config.timeout_ns) / 1e9},
+    };
+    for (NumberField& field : fields) {
+        if (!json.has(field.name)) continue;
+        if (json[field.name].t() != crow::json::type::Number || !(json[field.name].d() >= field.min) ||
+            !(json[field.name].d() <= field.max)) {
+            return crow::response(400, std::string("Invalid value for ") + field.name);
+        }
+        field.value = json[field.name].d();
+    }
+    config.eye = static_cast<uint32_t>(fields[0].value);
+    config.threshold = static_cast<float>(fields[1].value);
+    config.trials = static_cast<uint32_t>(fields[2].value);
+    config.settle_frames = static_cast<uint32_t>(fields[3].value);
+    config.timeout_ns = static_cast<int64_t>(fields[4].value * 1e9);
+
+    probe.Start(config, &simulator);
+    return crow::response(200, "OK");
+}
+
+crow::response HandleDeleteLatency(LatencyProbe& probe) {
+    probe.Stop();
+    return crow::response(200, "OK");
+}
+
+static crow::json::wvalue ProbeJson(const PixelProbeStatus& status) {
+    const PixelProbeSpec& spec = status.spec;
+    crow::json::wvalue json;
+    json["id"] = status.id;
+    json["eye"] = spec.eye;
+    if (spec.kind == PixelProbeSpec::Kind::kColor) {
+        json["pixel"]["x"] = spec.region.x;
+        json["pixel"]["y"] = spec.region.y;
+        json["color"] = crow::json::wvalue::list{spec.color[0], spec.color[1], spec.color[2]};
+        json["tolerance"] = spec.tolerance;
+    } else {
+        json["region"]["x"] = spec.region.x;
+        json["region"]["y"] = spec.region.y;
+        json["region"]["width"] = spec.region.width;
+        json["region"]["height"] = spec.region.height;
+        json[spec.above ? "above" : "below"] = spec.threshold;
+    }
+    json["evaluated"] = status.evaluated;
+    json["matched"] = status.matched;
+    if (status.evaluated) {
+        if (spec.kind == PixelProbeSpec::Kind::kColor) {
+            json["observed"] = crow::json::wvalue::list{status.observed[0], status.observed[1], status.observed[2]};
+        } else {
+            json["brightness"] = status.value;
+        }
+        json["frame"] = status.frame;
+        json["transitions"] = status.transitions;
+    }
+    return json;
+}
+
+crow::response HandleGetProbes(const PixelWatch& watch, const crow::request& req) {
+    uint64_t since = 0;
+    if (auto since_param = req.url_params.get("since")) {
+        try {
+            since = std::stoull(since_param);
+        } catch (...) {
+            return crow::response(400, "Invalid value for since");
+        }
+    }
+
+    crow::json::wvalue response;
+    crow::json::wvalue probes(crow::json::type::List);
+    const std::vector<PixelProbeStatus> statuses = watch.GetProbes();
+    for (size_t i = 0; i < statuses.size(); i++) {
+        probes[i] = ProbeJson(statuses[i]);
+    }
+    response["probes"] = std::move(probes);
+
+    uint64_t next_seq = 0;
+    crow::json::wvalue events(crow::json::type::List);
+    const std::vector<PixelProbeEvent> recent = watch.GetEvents(since, &next_seq);
+    for (size_t i = 0; i < recent.size(); i++) {
+        events[i]["seq"] = recent[i].seq;
+        events[i]["id"] = recent[i].id;
+        events[i]["matched"] = recent[i].matched;
+        events[i]["frame"] = recent[i].frame;
+        events[i]["time_ns"] = recent[i].time_ns;
+    }
+    response["events"] = std::move(events);
+    response["next"] = next_seq;
+    return crow::response(response);
+}
+
+crow::response HandleGetProbe(const PixelWatch& watch, const std::string& id) {
+    PixelProbeStatus status;
+    if (!watch.GetProbe(id, &status)) {
+        return crow::response(404, "Probe not found");
+    }
+    return crow::response(ProbeJson(status));
+}
+
+crow::response HandlePutProbe(PixelWatch& watch, const crow::request& req, const std::string& id) {
+    auto json = crow::json::load(req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    PixelProbeSpec spec;
+    if (json.has("eye")) {
+        if (json["eye"].t() != crow::json::type::Number || (json["eye"].d() != 0 && json["eye"].d() != 1)) {
+            return crow::response(400, "Invalid value for eye (0 or 1)");
+        }
+        spec.eye = static_cast<uint32_t>(json["eye"].d());
+    }
+
+    auto read_byte = [](const crow::json::rvalue& value, uint8_t* out) {
+        if (value.t() != crow::json::type::Number || !(value.d() >= 0.0 && value.d() <= 255.0)) return false;
+        *out = static_cast<uint8_t>(value.d());
+        return true;
+    };
+
+    if (json.has("pixel")) {
+        spec.kind = PixelProbeSpec::Kind::kColor;
+        const crow::json::rvalue& pixel = json["pixel"];
+        if (pixel.t() != crow::json::type::Object || !pixel.has("x") || !pixel.has("y") ||
+            pixel["x"].t() != crow::json::type::Number || pixel["y"].t() != crow::json::type::Number ||
+            !(pixel["x"].d() >= 0.0 && pixel["x"].d() <= 65535.0) ||
+            !(pixel["y"].d() >= 0.0 && pixel["y"].d() <= 65535.0)) {
+            return crow::response(400, "Invalid pixel {x, y}");
+        }
+        spec.region = {static_cast<uint32_t>(pixel["x"].d()), static_cast<uint32_t>(pixel["y"].d()), 1, 1};
+        if (!json.has("color") || json["color"].t() != crow::json::type::List || json["color"].size() != 3 ||
+            !read_byte(json["color"][0], &spec.color[0]) || !read_byte(json["color"][1], &spec.color[1]) ||
+            !read_byte(json["color"][2], &spec.color[2])) {
+            return crow::response(400, "Missing or invalid color [r, g, b] (0-255)");
+        }
+        if (json.has("tolerance") && !read_byte(json["tolerance"], &spec.tolerance)) {
+            return crow::response(400, "Invalid value for tolerance (0-255)");
+        }
+    } else if (json.has("region")) {
+        spec.kind = PixelProbeSpec::Kind::kBrightness;
+        if (!ParsePixelRect(json["region"], &spec.region)) {
+            return crow::response(400, "Invalid region {x, y, width, height}");
+        }
+        spec.above = json.has("above");
+        const char* field = spec.above ? "above" : "below";
+        if (json.has("above") == json.has("below") || json[field].t() != crow::json::type::Number ||
+            !(json[field].d() >= 0.0 && json[field].d() <= 255.0)) {
+            return crow::response(400, "Exactly one of above or below (brightness, 0-255) is required");
+        }
+        spec.threshold = static_cast<float>(json[field].d());
+    } else {
+        return crow::response(400, "Missing pixel {x, y} or region {x, y, width, height}");
+    }
+
+    if (!watch.SetProbe(id, spec)) {
+        return crow::response(409, "Too many probes");
+    }
+    return crow::response(200, "OK");
+}
+
+crow::response HandleDeleteProbe(PixelWatch& watch, const std::string& id) {
+    if (!watch.RemoveProbe(id)) {
+        return crow::response(404, "Probe not found");
+    }
+    return crow::response(200, "OK");
+}
+
+crow::response HandleDeleteProbes(PixelWatch& watch) {
+    watch.RemoveAll();
+    return crow::response(200, "OK");
+}
+
+void HandleWaitProbe(PixelWatch& watch, const crow::request& req, crow::response& res, const std::string& id) {
+    bool matched = true;
+    if (auto matched_param = req.url_params.get("matched")) {
+        const std::string value = matched_param;
+        if (value != "true" && value != "false") {
+            res = crow::response(400, "Invalid value for matched (true or false)");
+            res.end();
+            return;
+        }
+        matched = value == "true";
+    }
+    double timeout_s = 5.0;
+    if (auto timeout_param = req.url_params.get("timeout")) {
+        char* end = nullptr;
+        timeout_s = std::strtod(timeout_param, &end);
+        if (end == timeout_param || *end != '\0' || !(timeout_s > 0.0 && timeout_s <= 60.0)) {
+            res = crow::response(400, "Invalid value for timeout (seconds, up to 60)");
+            res.end();
+            return;
+        }
+    }
+
+    // The callback runs on the PixelWatch worker; hand the response back to the connection's own
+    // io_context to write it. The connection (and so `res`) stays alive until res.end().
+    asio::io_context* io_context = req.io_context;
+    crow::response* pending = &res;
+    auto complete = [io_context, pending](PixelWatch::WaitResult result, const PixelProbeStatus& status) {
+        int code = 200;
+        std::string body;
+        if (result == PixelWatch::WaitResult::kRemoved) {
+            code = 410;
+            body = "Probe was removed or replaced";
+        } else {
+            crow::json::wvalue json = ProbeJson(status);
+            json["timed_out"] = result == PixelWatch::WaitResult::kTimedOut;
+            body = json.dump();
+        }
+        asio::post(*io_context, [pending, code, body = std::move(body)]() {
+            pending->code = code;
+            pending->body = body;
+            if (code == 200) pending->set_header("Content-Type", "application/json");
+            pending->end();
+        });
+    };
+    if (!watch.Wait(id, matched, static_cast<int64_t>(timeout_s * 1e9), std::move(complete))) {
+        res = crow::response(404, "Probe not found");
+        res.end();
+    }
+}
+
+crow::response HandleGetRecorder(const FlightRecorder& recorder) {
+    const FlightRecorder::Status status = recorder.GetStatus();
+
+    crow::json::wvalue response;
+    response["enabled"] = status.enabled;
+    response["budget_mb"] = static_cast<double>(status.config.budget_bytes) / (1 << 20);
+    response["width"] = status.config.max_width;
+    response["decimation"] = status.config.decimation;
+    response["frames"] = status.frames;
+    response["bytes"] = status.bytes;
+    response["seconds"] = static_cast<double>(status.newest_ns - status.oldest_ns) / 1e9;
+    if (status.frames > 0) {
+        response["frame_width"] = status.width;
+        response["frame_height"] = status.height;
+    }
+    response["dump"]["state"] = FlightRecorder::DumpStateName(status.dump_state);
+    if (status.dump_state != FlightRecorder::DumpState::kIdle) {
+        response["dump"]["path"] = status.dump_path;
+        response["dump"]["written"] = status.dump_written;
+        response["dump"]["total"] = status.dump_total;
+    }
+    if (!status.dump_error.empty()) {
+        response["dump"]["error"] = status.dump_error;
+    }
+    return crow::response(response);
+}
+
+crow::response HandlePutRecorder(FlightRecorder& recorder, const crow::request& req) {
+    auto json = crow::json::load(req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    FlightRecorderConfig config = recorder.GetStatus().config;
+    struct NumberField {
+        const char* name;
+        double min;
+        double max;
+        double value;
+    };
+    NumberField fields[] = {
+        {"budget_mb", 1, 4096, static_cast<double>(config.budget_bytes >> 20)},
+        {"width", 0, 16384, static_cast<double>(config.max_width)},
+        {"decimation", 1, 1000, static_cast<double>(config.decimation)},
+    };
+    for (NumberField& field : fields) {
+        if (!json.has(field.name)) continue;
+        if (json[field.name].t() != crow::json::type::Number || !(json[field.name].d() >= field.min) ||
+            !(json[field.name].d() <= field.max)) {
+            return crow::response(400, std::string("Invalid value for ") + field.name);
+        }
+        field.value = json[field.name].d();
+    }
+    if (json.has("enabled") && json["enabled"].t() != crow::json::type::True &&
+        json["enabled"].t() != crow::json::type::False) {
+        return crow::response(400, "Invalid value for enabled (boolean)");
+    }
+
+    config.budget_bytes = static_cast<size_t>(fields[0].value * (1 << 20));
+    config.max_width = static_cast<uint32_t>(fields[1].value);
+    config.decimation = static_cast<uint32_t>(fields[2].value);
+    recorder.Configure(config);
+    if (json.has("enabled")) {
+        recorder.SetEnabled(json["enabled"].b());
+    }
+    return crow::response(200, "OK");
+}
+
+crow::response HandlePostRecorderDump(FlightRecorder& recorder, const crow::request& req) {
+    std::string path;
+    if (!req.body.empty()) {
+        auto json = crow::json::load(req.body);
+        if (!json) {
+            return crow::response(400, "Invalid JSON");
+        }
+        if (json.has("path")) {
+            if (json["path"].t() != crow::json::type::String) {
+                return crow::response(400, "Invalid value for path (string)");
+            }
+            path = json["path"].s();
+        }
+    }
+
+    std::string resolved_path;
+    std::string error;
+    if (!recorder.Dump(path, &resolved_path, &error)) {
+        return crow::response(409, error);
+    }
+    crow::json::wvalue response;
+    response["path"] = resolved_path;
+    return crow::response(202, response);
+}
+
+static crow::json::wvalue DetectorJson(const FrameDetectorStatus& detector) {
+    crow::json::wvalue json;
+    json["active"] = detector.active;
+    json["frames"] = detector.frames;
+    json["episodes"] = detector.episodes;
+    if (detector.episodes > 0) {
+        json["since_ns"] = detector.since_ns;
+        json["last_ns"] = detector.last_ns;
+    }
+    return json;
+}
+
+crow::response HandleGetMonitor(const FrameMonitor& monitor) {
+    const FrameMonitor::Status status = monitor.GetStatus();
+
+    crow::json::wvalue response;
+    response["enabled"] = status.enabled;
+    response["row_stride"] = status.config.row_stride;
+    response["black_threshold"] = status.config.black_threshold;
+    response["black_frames"] = status.config.black_frames;
+    response["frozen_frames"] = status.config.frozen_frames;
+    response["mismatch_threshold"] = status.config.mismatch_threshold;
+    response["now_ns"] = trace::NowNs();
+
+    crow::json::wvalue eyes(crow::json::type::List);
+    for (int i = 0; i < 2; i++) {
+        const FrameEyeStatus& eye = status.eyes[i];
+        crow::json::wvalue& json = eyes[i];
+        json["measured"] = eye.measured;
+        if (eye.measured) {
+            json["frame"] = eye.frame;
+            json["time_ns"] = eye.time_ns;
+            json["width"] = eye.width;
+            json["height"] = eye.height;
+            json["mean"] = eye.luma.Mean();
+            json["stddev"] = std::sqrt(eye.luma.Variance());
+            crow::json::wvalue histogram(crow::json::type::List);
+            for (int bucket = 0; bucket < 16; bucket++) {
+                histogram[bucket] = eye.luma.count ? static_cast<double>(eye.luma.histogram[bucket]) / eye.luma.count
+                                                   : 0.0;
+            }
+            json["histogram"] = std::move(histogram);
+            char hash[17];
+            std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(eye.hash));
+            json["hash"] = hash;
+            json["repeats"] = eye.repeats;
+            json["changed_ns"] = eye.changed_ns;
+        }
+        json["black"] = DetectorJson(eye.black);
+        json["frozen"] = DetectorJson(eye.frozen);
+    }
+    response["eyes"] = std::move(eyes);
+    response["mismatch"] = DetectorJson(status.mismatch);
+    response["mismatch"]["distance"] = status.mismatch_distance;
+    return crow::response(response);
+}
+
+crow::response HandlePutMonitor(FrameMonitor& monitor, const crow::request& req) {
+    auto json = crow::json::load(req.body);
+    if (!json) {
+        return crow::response(400, "Invalid JSON");
+    }
+
+    FrameMonitorConfig config = monitor.GetStatus().config;
+    struct NumberField {
+        const char* name;
+        double min;
+        double max;
+        double value;
+    };
+    NumberField fields[] = {
+        {"row_stride", 1, 64, static_cast<double>(config.row_stride)},
+        {"black_threshold", 0, 255, config.black_threshold},
+        {"black_frames", 1, 1e6, static_cast<double>(config.black_frames)},
+        {"frozen_frames", 1, 1e6, static_cast<double>(config.frozen_frames)},
+        {"mismatch_threshold", 0, 1, config.mismatch_threshold},
+    };
+    for (NumberField& field : fields) {
+        if (!json.has(field.name)) continue;
+        if (json[field.name].t() != crow::json::type::Number || !(json[field.name].d() >= field.min) ||
+            !(json[field.name].d() <= field.max)) {
+            return crow::response(400, std::string("Invalid value for ") + field.name);
+        }
+        field.value = json[field.name].d();
+    }
+    if (json.has("enabled") && json["enabled"].t() != crow::json::type::True &&
+        json["enabled"].t() != crow::json::type::False) {
+        return crow::response(400, "Invalid value for enabled (boolean)");
+    }
+
+    config.row_stride = static_cast<uint32_t>(fields[0].value);
+    config.black_threshold = static_cast<float>(fields[1].value);
+    config.black_frames = static_cast<uint32_t>(fields[2].value);
+    config.frozen_frames = static_cast<uint32_t>(fields[3].value);
+    config.mismatch_threshold = static_cast<float>(fields[4].value);
+    monitor.Configure(config);
+    if (json.has("enabled")) {
+        monitor.SetEnabled(json["enabled"].b());
+    }
+    return crow::response(200, "OK");
+}
+
+crow::response HandleDeleteMonitor(FrameMonitor& monitor) {
+    monitor.Reset();
+    return crow::response(200, "OK");
+}
+
+}  // namespace ox_sim
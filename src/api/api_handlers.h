@@ -0,0 +1,105 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "crow/http_request.h"
+#include "crow/http_response.h"
+#include "crow/json.h"
+#include "device_profiles.h"
+#include "flight_recorder.h"
+#include "frame_monitor.h"
+#include "latency_probe.h"
+#include "metrics.h"
+#include "pixel_watch.h"
+#include "scenario.h"
+#include "simulator_core.h"
+
+namespace ox_sim {
+
+// Handlers behind the simulator's HTTP API routes. HttpServer binds them to URLs; they take no
+// server state, so they can also be called directly (benchmarks, tools).
+// Path arguments are the route captures, i.e. without the leading '/'.
+
+// GET/PUT /v1/devices/<user_path>
+crow::response HandleGetDevice(SimulatorCore& simulator, const std::string& user_path);
+crow::response HandlePutDevice(SimulatorCore& simulator, const crow::request& req, const std::string& user_path);
+
+// GET/PUT /v1/inputs/<binding_path>
+crow::response HandleGetInput(SimulatorCore& simulator, const std::string& binding_path);
+crow::response HandlePutInput(SimulatorCore& simulator, const crow::request& req, const std::string& binding_path);
+
+// GET /v1/status (reads GetFrameData())
+crow::response HandleGetStatus();
+
+// Where ?stream=true view bodies are encoded: `submit` runs a task on a background thread (false if it
+// cannot, e.g. while shutting down), and each strip's size is added to `bytes_sent` when the connection
+// takes it, as chunked bodies are not part of the response's body_size().
+struct ViewStreaming {
+    std::function<bool(std::function<void()> task)> submit;
+    metrics::Counter* bytes_sent = nullptr;
+};
+
+// GET /v1/views/<eye_index> (reads GetFrameData()); honours the optional ?size=<width>, ?format=png|raw and
+// ?stream=true|false parameters. The image is sent from a shared buffer set with
+// crow::response::set_shared_body(), or, when streamed, encoded strip by strip on `streaming` tasks while it
+// is written as a chunked body. Without `streaming`, and for HTTP/1.0 clients (which cannot receive
+// chunked bodies), ?stream=true sends the whole PNG at once.
+crow::response HandleGetView(const crow::request& req, int eye_index, const ViewStreaming* streaming = nullptr);
+
+// GET/PUT /v1/profile. PUT switches `simulator` and updates *device_profile_ptr on success.
+crow::response HandleGetProfile(const DeviceProfile* profile);
+crow::response HandlePutProfile(SimulatorCore& simulator, const DeviceProfile** device_profile_ptr,
+                                const crow::request& req);
+
+// GET/DELETE /v1/generators (list/remove all) and PUT/DELETE /v1/generators/<binding_path>
+crow::response HandleGetGenerators(SimulatorCore& simulator);
+crow::response HandleDeleteGenerators(SimulatorCore& simulator);
+crow::response HandlePutGenerator(SimulatorCore& simulator, const crow::request& req, const std::string& binding_path);
+crow::response HandleDeleteGenerator(SimulatorCore& simulator, const std::string& binding_path);
+
+// GET/PUT/DELETE /v1/scenario. PUT compiles the body (see CompileScenario()) against the current
+// profile and starts it on `runner`, replacing any running scenario.
+crow::response HandleGetScenario(const ScenarioRunner& runner);
+crow::response HandlePutScenario(SimulatorCore& simulator, const DeviceProfile** device_profile_ptr,
+                                 ScenarioRunner& runner, const crow::request& req);
+crow::response HandleDeleteScenario(ScenarioRunner& runner);
+
+// GET/PUT /v1/commit (commit mode and staged write count) and POST /v1/commit (publish staged writes now)
+crow::response HandleGetCommit(SimulatorCore& simulator);
+crow::response HandlePutCommit(SimulatorCore& simulator, const crow::request& req);
+crow::response HandlePostCommit(SimulatorCore& simulator);
+
+// GET/PUT/DELETE /v1/latency. PUT starts an input-to-photon measurement on `probe`, replacing any
+// running one; GET reports its samples and latency distribution.
+crow::response HandleGetLatency(const LatencyProbe& probe);
+crow::response HandlePutLatency(SimulatorCore& simulator, LatencyProbe& probe, const crow::request& req);
+crow::response HandleDeleteLatency(LatencyProbe& probe);
+
+// GET/DELETE /v1/probes (all probes, plus the matched-state events after ?since=<seq>) and
+// GET/PUT/DELETE /v1/probes/<id>. PUT registers {"pixel", "color", "tolerance"} or
+// {"region", "above" | "below"} on an eye, replacing any probe with the same id.
+crow::response HandleGetProbes(const PixelWatch& watch, const crow::request& req);
+crow::response HandleGetProbe(const PixelWatch& watch, const std::string& id);
+crow::response HandlePutProbe(PixelWatch& watch, const crow::request& req, const std::string& id);
+crow::response HandleDeleteProbe(PixelWatch& watch, const std::string& id);
+crow::response HandleDeleteProbes(PixelWatch& watch);
+
+// GET /v1/probes/<id>/wait?matched=true|false&timeout=<seconds>. Asynchronous: returns at once and
+// ends `res` from the connection's event loop once the probe reaches the state or the timeout passes
+// ("timed_out" in the probe JSON), so the single API thread keeps serving other requests meanwhile.
+void HandleWaitProbe(PixelWatch& watch, const crow::request& req, crow::response& res, const std::string& id);
+
+// GET/PUT /v1/recorder (flight recorder state and settings, dump progress) and
+// POST /v1/recorder/dump (write the recorded frames to {"path"} or a new directory, in the background)
+crow::response HandleGetRecorder(const FlightRecorder& recorder);
+crow::response HandlePutRecorder(FlightRecorder& recorder, const crow::request& req);
+crow::response HandlePostRecorderDump(FlightRecorder& recorder, const crow::request& req);
+
+// GET/PUT /v1/monitor (per-eye frame statistics and black/frozen/mismatch detectors, their
+// settings) and DELETE /v1/monitor (clear the measurements and detector counters)
+crow::response HandleGetMonitor(const FrameMonitor& monitor);
+crow::response HandlePutMonitor(FrameMonitor& monitor, const crow::request& req);
+crow::response HandleDeleteMonitor(FrameMonitor& monitor);
+
+}  // namespace ox_sim
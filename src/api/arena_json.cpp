@@ -0,0 +1,340 @@
+#include "arena_json.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace ox_sim {
+
+static constexpr int kMaxDepth = 64;
+
+const JsonNode* JsonNode::Find(std::string_view name) const {
+    if (type != JsonType::kObject) return nullptr;
+    for (const JsonNode* member = child; member; member = member->next) {
+        if (member->key == name) return member;
+    }
+    return nullptr;
+}
+
+namespace {
+
+// Recursive-descent parser over [p_, end_). Every Parse* function returns false on malformed input.
+class Parser {
+   public:
+    Parser(RequestArena& arena, std::string_view text)
+        : arena_(arena), p_(text.data()), end_(text.data() + text.size()) {}
+
+    const JsonNode* ParseDocument() {
+        JsonNode* root = NewNode();
+        SkipSpace();
+        if (!ParseValue(root, 0)) return nullptr;
+        SkipSpace();
+        return p_ == end_ ? root : nullptr;
+    }
+
+   private:
+    JsonNode* NewNode() { return new (arena_.AllocateArray<JsonNode>(1)) JsonNode(); }
+
+    void SkipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) p_++;
+    }
+
+    bool Literal(const char* word, size_t size) {
+        if (static_cast<size_t>(end_ - p_) < size || std::memcmp(p_, word, size) != 0) return false;
+        p_ += size;
+        return true;
+    }
+
+    bool ParseValue(JsonNode* node, int depth) {
+        if (p_ == end_) return false;
+        switch (*p_) {
+            case '{':
+                node->type = JsonType::kObject;
+                return depth < kMaxDepth && ParseMembers(node, depth + 1, '}');
+            case '[':
+                node->type = JsonType::kList;
+                return depth < kMaxDepth && ParseMembers(node, depth + 1, ']');
+            case '"':
+                node->type = JsonType::kString;
+                return ParseString(&node->string);
+            case 't':
+                node->type = JsonType::kTrue;
+                return Literal("true", 4);
+            case 'f':
+                node->type = JsonType::kFalse;
+                return Literal("false", 5);
+            case 'n':
+                node->type = JsonType::kNull;
+                return Literal("null", 4);
+            default:
+                node->type = JsonType::kNumber;
+                return ParseNumber(&node->number);
+        }
+    }
+
+    // Object members (with keys) or list elements, appended in order.
+    bool ParseMembers(JsonNode* parent, int depth, char close) {
+        p_++;  // '{' or '['
+        SkipSpace();
+        if (p_ < end_ && *p_ == close) {
+            p_++;
+            return true;
+        }
+        const JsonNode** tail = &parent->child;
+        for (;;) {
+            JsonNode* member = NewNode();
+            if (close == '}') {
+                if (p_ == end_ || *p_ != '"' || !ParseString(&member->key)) return false;
+                SkipSpace();
+                if (p_ == end_ || *p_++ != ':') return false;
+                SkipSpace();
+            }
+            if (!ParseValue(member, depth)) return false;
+            *tail = member;
+            tail = &member->next;
+
+            SkipSpace();
+            if (p_ == end_) return false;
+            const char c = *p_++;
+            if (c == close) return true;
+            if (c != ',') return false;
+            SkipSpace();
+        }
+    }
+
+    static int HexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool ParseHex4(uint32_t* out) {
+        if (end_ - p_ < 4) return false;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            const int digit = HexDigit(*p_++);
+            if (digit < 0) return false;
+            value = (value << 4) | static_cast<uint32_t>(digit);
+        }
+        *out = value;
+        return true;
+    }
+
+    // Unescape a string into the arena. Unescaped text is never longer than the escaped source,
+    // so the output buffer is sized by the distance to the closing quote.
+    bool ParseString(std::string_view* out) {
+        const char* start = ++p_;  // opening quote
+        const char* close = start;
+        while (close < end_ && *close != '"') close += *close == '\\' ? 2 : 1;
+        if (close >= end_) return false;
+
+        char* buffer = static_cast<char*>(arena_.Allocate(static_cast<size_t>(close - start) + 1, 1));
+        char* o = buffer;
+        while (p_ < close) {
+            const char c = *p_++;
+            if (static_cast<unsigned char>(c) < 0x20) return false;
+            if (c != '\\') {
+                *o++ = c;
+                continue;
+            }
+            switch (*p_++) {
+                case '"': *o++ = '"'; break;
+                case '\\': *o++ = '\\'; break;
+                case '/': *o++ = '/'; break;
+                case 'b': *o++ = '\b'; break;
+                case 'f': *o++ = '\f'; break;
+                case 'n': *o++ = '\n'; break;
+                case 'r': *o++ = '\r'; break;
+                case 't': *o++ = '\t'; break;
+                case 'u': {
+                    uint32_t code;
+                    if (!ParseHex4(&code)) return false;
+                    if (code >= 0xD800 && code < 0xDC00) {
+                        // High surrogate; the low half follows as another \u escape (12 bytes in
+                        // total for 4 UTF-8 bytes, so the buffer is still large enough).
+                        uint32_t low;
+                        if (close - p_ < 6 || p_[0] != '\\' || p_[1] != 'u') return false;
+                        p_ += 2;
+                        if (!ParseHex4(&low) || low < 0xDC00 || low >= 0xE000) return false;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    if (code < 0x80) {
+                        *o++ = static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        *o++ = static_cast<char>(0xC0 | (code >> 6));
+                        *o++ = static_cast<char>(0x80 | (code & 0x3F));
+                    } else if (code < 0x10000) {
+                        *o++ = static_cast<char>(0xE0 | (code >> 12));
+                        *o++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        *o++ = static_cast<char>(0x80 | (code & 0x3F));
+                    } else {
+                        *o++ = static_cast<char>(0xF0 | (code >> 18));
+                        *o++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                        *o++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        *o++ = static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        p_ = close + 1;
+        *o = '\0';
+        *out = std::string_view(buffer, static_cast<size_t>(o - buffer));
+        return true;
+    }
+
+    // JSON number grammar, converted without strtod so the host app's C locale cannot change the
+    // decimal separator. Up to 19 significant digits are kept, far more than the floats they set.
+    bool ParseNumber(double* out) {
+        const bool negative = p_ < end_ && *p_ == '-';
+        if (negative) p_++;
+        if (p_ == end_ || *p_ < '0' || *p_ > '9') return false;
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        auto digit = [&](char c, bool fraction) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(c - '0');
+                if (mantissa != 0) digits++;
+                if (fraction) exponent--;
+            } else if (!fraction) {
+                exponent++;
+            }
+        };
+        if (*p_ == '0') {
+            p_++;
+        } else {
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') digit(*p_++, false);
+        }
+        if (p_ < end_ && *p_ == '.') {
+            p_++;
+            if (p_ == end_ || *p_ < '0' || *p_ > '9') return false;
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') digit(*p_++, true);
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            p_++;
+            bool exponent_negative = false;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) exponent_negative = *p_++ == '-';
+            if (p_ == end_ || *p_ < '0' || *p_ > '9') return false;
+            int value = 0;
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                if (value < 10000) value = value * 10 + (*p_ - '0');
+                p_++;
+            }
+            exponent += exponent_negative ? -value : value;
+        }
+        double result = static_cast<double>(mantissa);
+        if (mantissa != 0 && exponent != 0) {
+            result = exponent < 0 ? result / std::pow(10.0, -exponent) : result * std::pow(10.0, exponent);
+        }
+        *out = negative ? -result : result;
+        return true;
+    }
+
+    RequestArena& arena_;
+    const char* p_;
+    const char* end_;
+};
+
+}  // namespace
+
+const JsonNode* ParseJson(RequestArena& arena, std::string_view text) { return Parser(arena, text).ParseDocument(); }
+
+JsonWriter::JsonWriter(RequestArena& arena, size_t capacity)
+    : arena_(arena), data_(static_cast<char*>(arena.Allocate(capacity, 1))), capacity_(capacity) {}
+
+void JsonWriter::Append(const char* text, size_t size) {
+    if (size_ + size > capacity_) {
+        // The old buffer stays in the arena until it is reset.
+        const size_t capacity = capacity_ * 2 > size_ + size ? capacity_ * 2 : size_ + size;
+        char* data = static_cast<char*>(arena_.Allocate(capacity, 1));
+        std::memcpy(data, data_, size_);
+        data_ = data;
+        capacity_ = capacity;
+    }
+    std::memcpy(data_ + size_, text, size);
+    size_ += size;
+}
+
+void JsonWriter::BeginValue() {
+    if (need_comma_) Append(',');
+    need_comma_ = true;
+}
+
+JsonWriter& JsonWriter::BeginObject() {
+    BeginValue();
+    Append('{');
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject() {
+    Append('}');
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::string_view key) {
+    String(key);
+    Append(':');
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Bool(bool value) {
+    BeginValue();
+    if (value) {
+        Append("true", 4);
+    } else {
+        Append("false", 5);
+    }
+    return *this;
+}
+
+// Same output as crow::json::wvalue for a float: "%f" with trailing zeros removed, keeping one
+// digit after the decimal point ("1.0", "0.25"), and null for NaN and infinities.
+JsonWriter& JsonWriter::Number(float value) {
+    BeginValue();
+    if (std::isnan(value) || std::isinf(value)) {
+        Append("null", 4);
+        return *this;
+    }
+    char buffer[64];
+    int length = std::snprintf(buffer, sizeof(buffer), "%f", static_cast<double>(value));
+    if (length < 0) length = 0;
+    if (length >= static_cast<int>(sizeof(buffer))) length = static_cast<int>(sizeof(buffer)) - 1;
+    const char* point = static_cast<const char*>(std::memchr(buffer, '.', static_cast<size_t>(length)));
+    if (point) {
+        const int keep = static_cast<int>(point - buffer) + 2;  // the point and one digit
+        while (length > keep && buffer[length - 1] == '0') length--;
+    }
+    Append(buffer, static_cast<size_t>(length));
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(std::string_view value) {
+    BeginValue();
+    Append('"');
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            const char escaped[2] = {'\\', c};
+            Append(escaped, 2);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            Append(escaped, 6);
+        } else {
+            Append(c);
+        }
+    }
+    Append('"');
+    return *this;
+}
+
+}  // namespace ox_sim
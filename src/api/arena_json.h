@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "request_arena.h"
+
+namespace ox_sim {
+
+enum class JsonType { kNull, kFalse, kTrue, kNumber, kString, kList, kObject };
+
+// One value of a JSON document parsed into a RequestArena. The members of a list or object are
+// linked through `child` and `next`; object members carry their key. Everything, including
+// unescaped strings, lives in the arena, so parsing a request body does no heap allocation.
+struct JsonNode {
+    JsonType type = JsonType::kNull;
+    std::string_view key;     // object members only
+    std::string_view string;  // kString
+    double number = 0.0;      // kNumber
+    const JsonNode* child = nullptr;
+    const JsonNode* next = nullptr;
+
+    bool IsBool() const { return type == JsonType::kTrue || type == JsonType::kFalse; }
+    bool IsNumber() const { return type == JsonType::kNumber; }
+    bool Bool() const { return type == JsonType::kTrue; }
+
+    // The member named `name` of an object (the first, if repeated), or null.
+    const JsonNode* Find(std::string_view name) const;
+};
+
+// Parse `text` into `arena`. Returns null if `text` is not a single valid JSON value or nests
+// deeper than 64 levels.
+const JsonNode* ParseJson(RequestArena& arena, std::string_view text);
+
+// Writes a compact JSON object into a RequestArena, growing its buffer there. Numbers are
+// formatted like crow::json::wvalue formats floats, so responses read the same as before.
+class JsonWriter {
+   public:
+    explicit JsonWriter(RequestArena& arena, size_t capacity = 256);
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& Key(std::string_view key);
+    JsonWriter& Bool(bool value);
+    JsonWriter& Number(float value);
+    JsonWriter& String(std::string_view value);
+
+    // The document so far; valid until the arena is reset.
+    std::string_view View() const { return std::string_view(data_, size_); }
+
+   private:
+    void Append(const char* text, size_t size);
+    void Append(char c) { Append(&c, 1); }
+    void BeginValue();
+
+    RequestArena& arena_;
+    char* data_;
+    size_t size_ = 0;
+    size_t capacity_;
+    bool need_comma_ = false;
+};
+
+}  // namespace ox_sim
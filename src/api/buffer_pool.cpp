@@ -0,0 +1,42 @@
+#include "buffer_pool.h"
+
+#include "metrics.h"
+
+namespace ox_sim {
+
+static metrics::Counter g_buffers_allocated("ox_response_buffers_allocated_total",
+                                            "Response buffers allocated because no pooled one was free");
+
+BufferPool::BufferPool(size_t max_free) : free_(std::make_shared<FreeList>()) { free_->max_free = max_free; }
+
+std::shared_ptr<std::vector<uint8_t>> BufferPool::Acquire(size_t size) {
+    std::unique_ptr<std::vector<uint8_t>> buffer;
+    {
+        std::lock_guard<std::mutex> lock(free_->mutex);
+        // Prefer the most recently released buffer that is already large enough.
+        for (size_t i = free_->buffers.size(); i-- > 0;) {
+            if (free_->buffers[i]->capacity() >= size) {
+                buffer = std::move(free_->buffers[i]);
+                free_->buffers.erase(free_->buffers.begin() + i);
+                break;
+            }
+        }
+        if (!buffer && !free_->buffers.empty()) {
+            buffer = std::move(free_->buffers.back());
+            free_->buffers.pop_back();
+        }
+    }
+    if (!buffer || buffer->capacity() < size) g_buffers_allocated.Add();
+    if (!buffer) buffer = std::make_unique<std::vector<uint8_t>>();
+    buffer->resize(size);
+
+    // The deleter holds the free list, not the pool, so buffers can outlive the pool.
+    std::shared_ptr<FreeList> free = free_;
+    return std::shared_ptr<std::vector<uint8_t>>(buffer.release(), [free](std::vector<uint8_t>* released) {
+        std::unique_ptr<std::vector<uint8_t>> owned(released);
+        std::lock_guard<std::mutex> lock(free->mutex);
+        if (free->buffers.size() < free->max_free) free->buffers.push_back(std::move(owned));
+    });
+}
+
+}  // namespace ox_sim
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ox_sim {
+
+// Recycles large byte buffers, such as the raw eye images sent by GET /v1/views, so each request
+// does not allocate (and fault in) tens of megabytes again. A buffer goes back to the pool when its
+// last reference is dropped, e.g. once the HTTP response holding it has been written. Up to
+// `max_free` idle buffers are kept; any beyond that are freed.
+class BufferPool {
+   public:
+    explicit BufferPool(size_t max_free);
+
+    // A buffer of `size` bytes with unspecified contents. Safe to call from any thread; the buffer
+    // may outlive the pool.
+    std::shared_ptr<std::vector<uint8_t>> Acquire(size_t size);
+
+   private:
+    struct FreeList {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<std::vector<uint8_t>>> buffers;
+        size_t max_free;
+    };
+
+    std::shared_ptr<FreeList> free_;
+};
+
+}  // namespace ox_sim
@@ -0,0 +1,318 @@
+#include "frame_encoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "metrics.h"
+#include "trace.h"
+
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#define STB_IMAGE_RESIZE_STATIC
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize.h"
+
+namespace ox_sim {
+
+static metrics::Histogram g_png_encode_time("ox_encode_duration_seconds", "Time spent encoding or resizing eye images",
+                                            "stage=\"png\"");
+static metrics::Histogram g_png_stream_time("ox_encode_duration_seconds", "Time spent encoding or resizing eye images",
+                                            "stage=\"png_stream\"");
+static metrics::Histogram g_resize_time("ox_encode_duration_seconds", "Time spent encoding or resizing eye images",
+                                        "stage=\"resize\"");
+
+// Encode with stb into a buffer it allocates with STBIW_MALLOC; the caller frees it with STBIW_FREE.
+static unsigned char* EncodePng(const void* rgba_data, uint32_t width, uint32_t height, int* size) {
+    metrics::ScopedTimer timer(g_png_encode_time);
+    OX_TRACE_SCOPE("encode", "EncodeRGBAToPng");
+    const int stride = static_cast<int>(width * 4);
+    // Copy pixels and force alpha to fully opaque.
+    std::vector<uint8_t> opaque(static_cast<const uint8_t*>(rgba_data),
+                                static_cast<const uint8_t*>(rgba_data) + width * height * 4);
+    for (uint32_t i = 0; i < width * height; ++i) opaque[i * 4 + 3] = 255;
+    // Point to the first byte of the last row, then walk backwards row by row.
+    const uint8_t* last_row = opaque.data() + (height - 1) * stride;
+    return stbi_write_png_to_mem(last_row,
+                                 -stride,  // negative stride flips the image vertically
+                                 static_cast<int>(width), static_cast<int>(height),
+                                 4,  // 4 channels: RGBA
+                                 size);
+}
+
+std::vector<uint8_t> EncodeRGBAToPng(const void* rgba_data, uint32_t width, uint32_t height) {
+    int size = 0;
+    unsigned char* png = EncodePng(rgba_data, width, height, &size);
+    if (!png) return {};
+    std::vector<uint8_t> out(png, png + size);
+    STBIW_FREE(png);
+    return out;
+}
+
+SharedBytes EncodeRGBAToPngShared(const void* rgba_data, uint32_t width, uint32_t height) {
+    int size = 0;
+    unsigned char* png = EncodePng(rgba_data, width, height, &size);
+    if (!png) return {};
+    SharedBytes bytes;
+    bytes.owner = std::shared_ptr<const void>(png, [](const void* data) { STBIW_FREE(const_cast<void*>(data)); });
+    bytes.data = png;
+    bytes.size = static_cast<size_t>(size);
+    return bytes;
+}
+
+// Deflate parameters of the streaming encoder. Distances stop at 32767, as in stb.
+static constexpr size_t kWindowSize = 32768;
+static constexpr size_t kMaxDistance = kWindowSize - 1;
+static constexpr size_t kMinMatch = 3;
+static constexpr size_t kMaxMatch = 258;
+static constexpr int kHashBits = 15;
+static constexpr int kMaxChain = 16;
+static constexpr size_t kMaxLazy = 32;  // matches at least this long are taken without looking one byte ahead
+
+static uint32_t HashBytes3(const uint8_t* data) {
+    const uint32_t bytes = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (bytes * 2654435761u) >> (32 - kHashBits);
+}
+
+static uint32_t ReverseBits(uint32_t code, int count) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < count; i++, code >>= 1) reversed = (reversed << 1) | (code & 1);
+    return reversed;
+}
+
+static void AppendBigEndian32(std::string& out, uint32_t value) {
+    out += static_cast<char>(value >> 24);
+    out += static_cast<char>(value >> 16);
+    out += static_cast<char>(value >> 8);
+    out += static_cast<char>(value);
+}
+
+// Close the chunk started with its length placeholder and type at `start`.
+static void FinishPngChunk(std::string& out, size_t start) {
+    const size_t data_size = out.size() - start - 8;
+    for (int i = 0; i < 4; i++) out[start + i] = static_cast<char>(data_size >> (24 - 8 * i));
+    AppendBigEndian32(out, stbiw__crc32(reinterpret_cast<unsigned char*>(&out[start + 4]),
+                                        static_cast<int>(data_size + 4)));
+}
+
+PngStreamEncoder::PngStreamEncoder(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t strip_rows)
+    : pixels_(pixels),
+      width_(width),
+      height_(height),
+      strip_rows_(std::max<uint32_t>(strip_rows, 1)),
+      head_(size_t(1) << kHashBits, -1),
+      prev_(kWindowSize, -1),
+      line_(static_cast<size_t>(width) * 4) {}
+
+bool PngStreamEncoder::Next(std::string& out) {
+    if (next_row_ >= height_) return false;
+    OX_TRACE_SCOPE("encode", "PngStreamEncoder::Next");
+    const auto start_time = metrics::Clock::now();
+
+    const size_t row_bytes = static_cast<size_t>(width_) * 4;
+    const bool first = next_row_ == 0;
+    if (first) {
+        static const char kSignature[] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+        out.append(kSignature, sizeof(kSignature));
+        const size_t header = out.size();
+        out.append("\0\0\0\0IHDR", 8);
+        AppendBigEndian32(out, width_);
+        AppendBigEndian32(out, height_);
+        out.append("\x08\x06\0\0\0", 5);  // 8 bits per channel, RGBA, no interlacing
+        FinishPngChunk(out, header);
+    }
+
+    // Filter the strip's rows into the window, choosing each row's filter the way stb does.
+    const uint32_t end_row = std::min(height_, next_row_ + strip_rows_);
+    const size_t strip_start = window_.size();
+    for (uint32_t row = next_row_; row < end_row; row++) {
+        int best_filter = 0;
+        int best_estimate = 0x7fffffff;
+        for (int filter = 0; filter < 5; filter++) {
+            stbiw__encode_png_line(const_cast<uint8_t*>(pixels_), static_cast<int>(row_bytes), width_, height_, row,
+                                   4, filter, reinterpret_cast<signed char*>(line_.data()));
+            int estimate = 0;
+            for (int8_t value : line_) estimate += std::abs(value);
+            if (estimate < best_estimate) {
+                best_estimate = estimate;
+                best_filter = filter;
+            }
+        }
+        stbiw__encode_png_line(const_cast<uint8_t*>(pixels_), static_cast<int>(row_bytes), width_, height_, row, 4,
+                               best_filter, reinterpret_cast<signed char*>(line_.data()));
+        window_.push_back(static_cast<uint8_t>(best_filter));
+        window_.insert(window_.end(), line_.begin(), line_.end());
+    }
+    next_row_ = end_row;
+    const bool last = next_row_ == height_;
+
+    for (size_t i = strip_start; i < window_.size();) {
+        const size_t block_end = std::min(window_.size(), i + 5552);
+        for (; i < block_end; i++) {
+            adler_a_ += window_[i];
+            adler_b_ += adler_a_;
+        }
+        adler_a_ %= 65521;
+        adler_b_ %= 65521;
+    }
+
+    const size_t idat = out.size();
+    out.append("\0\0\0\0IDAT", 8);
+    if (first) out.append("\x78\x5e", 2);  // zlib header: 32K window
+    Deflate(out, last);
+    FinishPngChunk(out, idat);
+    if (last) out.append("\0\0\0\0IEND\xae\x42\x60\x82", 12);
+
+    encode_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(metrics::Clock::now() - start_time);
+    if (last) g_png_stream_time.Observe(std::chrono::duration_cast<metrics::Clock::duration>(encode_time_));
+    return !last;
+}
+
+// Compress the window from pos_ to its end as one fixed-Huffman block. All but the last block are
+// followed by an empty stored block (a sync flush), which byte-aligns the stream so the strip can be
+// decoded without the data after it.
+void PngStreamEncoder::Deflate(std::string& out, bool last) {
+    static const uint16_t kLengthBase[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                           31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 259};
+    static const uint8_t kLengthExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                           2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const uint16_t kDistanceBase[] = {1,    2,    3,    4,    5,    7,     9,     13,    17,    25,   33,
+                                             49,   65,   97,   129,  193,  257,   385,   513,   769,   1025, 1537,
+                                             2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577, 32768};
+    static const uint8_t kDistanceExtra[] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                             6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    const size_t end = window_base_ + window_.size();
+    PutBits(out, last ? 1 : 0, 1);  // BFINAL
+    PutBits(out, 1, 2);             // BTYPE: fixed Huffman codes
+    while (pos_ < end) {
+        InsertHashes(pos_, end);
+        size_t distance = 0;
+        size_t length = LongestMatch(pos_, end, &distance);
+        if (length > 0 && length < kMaxLazy) {
+            // Lazy matching, as in stb: prefer a literal when the next byte starts a longer match.
+            InsertHashes(pos_ + 1, end);
+            size_t next_distance = 0;
+            if (LongestMatch(pos_ + 1, end, &next_distance) > length) length = 0;
+        }
+        if (length == 0) {
+            PutSymbol(out, window_[pos_ - window_base_]);
+            pos_++;
+            continue;
+        }
+        int code = 0;
+        while (length >= kLengthBase[code + 1]) code++;
+        PutSymbol(out, 257 + code);
+        if (kLengthExtra[code]) PutBits(out, static_cast<uint32_t>(length - kLengthBase[code]), kLengthExtra[code]);
+        code = 0;
+        while (distance >= kDistanceBase[code + 1]) code++;
+        PutBits(out, ReverseBits(code, 5), 5);
+        if (kDistanceExtra[code]) {
+            PutBits(out, static_cast<uint32_t>(distance - kDistanceBase[code]), kDistanceExtra[code]);
+        }
+        pos_ += length;
+    }
+    PutSymbol(out, 256);  // end of block
+
+    if (!last) PutBits(out, 0, 3);  // empty stored block
+    if (bit_count_ > 0) PutBits(out, 0, 8 - bit_count_);
+    if (last) {
+        AppendBigEndian32(out, (adler_b_ << 16) | adler_a_);
+    } else {
+        out.append("\0\0\xff\xff", 4);
+    }
+
+    // Keep the last 32 KB as the history of the next strip.
+    if (window_.size() > kWindowSize) {
+        const size_t drop = window_.size() - kWindowSize;
+        window_.erase(window_.begin(), window_.begin() + drop);
+        window_base_ += drop;
+    }
+}
+
+void PngStreamEncoder::InsertHashes(size_t limit, size_t end) {
+    for (; inserted_ < limit && inserted_ + kMinMatch <= end; inserted_++) {
+        const uint32_t hash = HashBytes3(&window_[inserted_ - window_base_]);
+        prev_[inserted_ & (kWindowSize - 1)] = head_[hash];
+        head_[hash] = static_cast<int64_t>(inserted_);
+    }
+}
+
+size_t PngStreamEncoder::LongestMatch(size_t pos, size_t end, size_t* distance) const {
+    if (pos + kMinMatch > end) return 0;
+    const uint8_t* current = &window_[pos - window_base_];
+    const size_t limit = std::min(kMaxMatch, end - pos);
+    size_t best = 0;
+    int64_t candidate = head_[HashBytes3(current)];
+    for (int chain = 0; chain < kMaxChain && candidate >= 0; chain++) {
+        const size_t match_pos = static_cast<size_t>(candidate);
+        if (match_pos >= pos || pos - match_pos > kMaxDistance) break;
+        const uint8_t* match = &window_[match_pos - window_base_];
+        // Only a longer match matters, so check the byte that would extend the best one first.
+        if (best == 0 || match[best] == current[best]) {
+            size_t length = 0;
+            while (length + 8 <= limit) {
+                uint64_t a, b;
+                std::memcpy(&a, match + length, 8);
+                std::memcpy(&b, current + length, 8);
+                if (a != b) break;
+                length += 8;
+            }
+            while (length < limit && match[length] == current[length]) length++;
+            if (length > best) {
+                best = length;
+                *distance = pos - match_pos;
+                if (length == limit) break;
+            }
+        }
+        // A link that does not point further back was overwritten by a position 32 KB later.
+        const int64_t next = prev_[match_pos & (kWindowSize - 1)];
+        if (next >= candidate) break;
+        candidate = next;
+    }
+    return best >= kMinMatch ? best : 0;
+}
+
+void PngStreamEncoder::PutBits(std::string& out, uint32_t bits, int count) {
+    bit_buffer_ |= static_cast<uint64_t>(bits) << bit_count_;
+    bit_count_ += count;
+    while (bit_count_ >= 8) {
+        out += static_cast<char>(bit_buffer_ & 0xff);
+        bit_buffer_ >>= 8;
+        bit_count_ -= 8;
+    }
+}
+
+// Fixed Huffman code of a literal/length symbol. Deflate sends Huffman codes most significant bit
+// first, so the table holds them bit-reversed.
+void PngStreamEncoder::PutSymbol(std::string& out, int symbol) {
+    struct Code {
+        uint16_t bits;
+        uint8_t count;
+    };
+    static const std::vector<Code> kCodes = [] {
+        std::vector<Code> codes(288);
+        for (int n = 0; n < 288; n++) {
+            const int count = n <= 143 ? 8 : n <= 255 ? 9 : n <= 279 ? 7 : 8;
+            const int code = n <= 143 ? 0x30 + n : n <= 255 ? 0x190 + n - 144 : n <= 279 ? n - 256 : 0xc0 + n - 280;
+            codes[n] = {static_cast<uint16_t>(ReverseBits(code, count)), static_cast<uint8_t>(count)};
+        }
+        return codes;
+    }();
+    PutBits(out, kCodes[symbol].bits, kCodes[symbol].count);
+}
+
+bool ResizeRGBA(const void* rgba_data, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height,
+                std::vector<uint8_t>& out) {
+    metrics::ScopedTimer timer(g_resize_time);
+    OX_TRACE_SCOPE("encode", "stbir_resize_uint8");
+    out.resize(out_width * out_height * 4);
+    return stbir_resize_uint8(static_cast<const uint8_t*>(rgba_data), width, height, 0, out.data(), out_width,
+                              out_height, 0,
+                              4  // RGBA channels
+                              ) != 0;
+}
+
+}  // namespace ox_sim
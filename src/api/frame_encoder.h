@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ox_sim {
+
+// Encode RGBA pixel data as PNG into a byte vector.
+// The raw pixel data is stored bottom-row-first (OpenGL convention); the PNG is written top-row-first.
+// Alpha is forced to 255 because OpenXR apps frequently leave alpha at 0.
+// Returns an empty vector if encoding fails.
+std::vector<uint8_t> EncodeRGBAToPng(const void* rgba_data, uint32_t width, uint32_t height);
+
+// Bytes kept alive by a shared owner, so an HTTP response can send them without copying them first.
+struct SharedBytes {
+    std::shared_ptr<const void> owner;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Same as EncodeRGBAToPng(), but hands out the encoder's output buffer instead of copying it into a
+// vector. Empty (size 0) if encoding fails.
+SharedBytes EncodeRGBAToPngShared(const void* rgba_data, uint32_t width, uint32_t height);
+
+// Encodes a PNG a strip of rows at a time, so the start of the file can be sent while the rest is
+// still being compressed. Uses the same row filters and fixed-Huffman deflate as EncodeRGBAToPng();
+// each strip ends with a deflate sync flush and becomes one IDAT chunk, so a client can decode every
+// strip it has received. Besides the source image, the encoder holds only the 32 KB deflate window,
+// its hash chains and the current strip.
+class PngStreamEncoder {
+   public:
+    // `pixels`: width x height RGBA8 pixels, top row first, with alpha already opaque. They must stay
+    // valid until the last Next() call.
+    PngStreamEncoder(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t strip_rows);
+
+    // Append the next part of the file to `out`: the signature, header and first strip, then one strip
+    // per call, with the IEND chunk after the last one. Returns false once the file is complete.
+    bool Next(std::string& out);
+
+   private:
+    void Deflate(std::string& out, bool last);
+    void InsertHashes(size_t limit, size_t end);
+    size_t LongestMatch(size_t pos, size_t end, size_t* distance) const;
+    void PutBits(std::string& out, uint32_t bits, int count);
+    void PutSymbol(std::string& out, int symbol);
+
+    const uint8_t* pixels_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t strip_rows_;
+    uint32_t next_row_ = 0;
+
+    // Filtered bytes from window_base_ on: the 32 KB before the current strip, then the strip.
+    std::vector<uint8_t> window_;
+    size_t window_base_ = 0;
+    size_t pos_ = 0;       // next byte to compress, counted from the start of the filtered data
+    size_t inserted_ = 0;  // bytes before this are in the hash chains
+    std::vector<int64_t> head_;
+    std::vector<int64_t> prev_;
+    std::vector<int8_t> line_;
+    uint64_t bit_buffer_ = 0;
+    int bit_count_ = 0;
+    uint32_t adler_a_ = 1;
+    uint32_t adler_b_ = 0;
+    std::chrono::nanoseconds encode_time_{0};
+};
+
+// Resize RGBA pixel data into `out` (resized to out_width * out_height * 4 bytes).
+// Returns false if resizing fails.
+bool ResizeRGBA(const void* rgba_data, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height,
+                std::vector<uint8_t>& out);
+
+}  // namespace ox_sim
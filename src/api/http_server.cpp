@@ -1,75 +1,152 @@
 #include "http_server.h"
 
-#include <iostream>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <vector>
 
-#define STB_IMAGE_WRITE_STATIC
-#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "api_handlers.h"
 #include "crow/app.h"
 #include "crow/json.h"
-#include "device_profiles.h"
-#include "frame_data.h"
-#include "stb_image_write.h"
-
-#define STB_IMAGE_RESIZE_STATIC
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-#include "stb_image_resize.h"
+#include "flight_recorder.h"
+#include "frame_monitor.h"
+#include "latency_probe.h"
+#include "log.h"
+#include "metrics.h"
+#include "pixel_watch.h"
+#include "profiled_mutex.h"
+#include "request_arena.h"
+#include "scenario.h"
+#include "task_pool.h"
+#include "thread_placement.h"
+#include "trace.h"
 
 namespace ox_sim {
 
-// Map OxSessionState enum to a human-readable string
-static const char* SessionStateName(OxSessionState s) {
-    switch (s) {
-        case OX_SESSION_STATE_UNKNOWN:
-            return "unknown";
-        case OX_SESSION_STATE_IDLE:
-            return "idle";
-        case OX_SESSION_STATE_READY:
-            return "ready";
-        case OX_SESSION_STATE_SYNCHRONIZED:
-            return "synchronized";
-        case OX_SESSION_STATE_VISIBLE:
-            return "visible";
-        case OX_SESSION_STATE_FOCUSED:
-            return "focused";
-        case OX_SESSION_STATE_STOPPING:
-            return "stopping";
-        case OX_SESSION_STATE_EXITING:
-            return "exiting";
-        default:
-            return "unknown";
+// Per-route request metrics. Routes are matched by method and URL prefix; the first match wins.
+struct RouteStats {
+    crow::HTTPMethod method;
+    const char* prefix;
+    const char* trace_name;
+    metrics::Histogram duration;
+    metrics::Counter request_bytes;
+    metrics::Counter response_bytes;
+
+    RouteStats(crow::HTTPMethod m, const char* p, const char* t, const char* labels)
+        : method(m),
+          prefix(p),
+          trace_name(t),
+          duration("ox_http_request_duration_seconds", "Time spent handling API requests", labels),
+          request_bytes("ox_http_request_bytes_total", "API request body bytes received", labels),
+          response_bytes("ox_http_response_bytes_total", "API response body bytes sent", labels) {}
+};
+
+static RouteStats g_route_stats[] = {
+    {crow::HTTPMethod::Get, "/v1/devices/", "GET /v1/devices", "route=\"/v1/devices\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/devices/", "PUT /v1/devices", "route=\"/v1/devices\",method=\"PUT\""},
+    {crow::HTTPMethod::Get, "/v1/inputs/", "GET /v1/inputs", "route=\"/v1/inputs\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/inputs/", "PUT /v1/inputs", "route=\"/v1/inputs\",method=\"PUT\""},
+    {crow::HTTPMethod::Get, "/v1/status", "GET /v1/status", "route=\"/v1/status\",method=\"GET\""},
+    {crow::HTTPMethod::Get, "/v1/views/", "GET /v1/views", "route=\"/v1/views\",method=\"GET\""},
+    {crow::HTTPMethod::Get, "/v1/profile", "GET /v1/profile", "route=\"/v1/profile\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/profile", "PUT /v1/profile", "route=\"/v1/profile\",method=\"PUT\""},
+    {crow::HTTPMethod::Get, "/v1/generators", "GET /v1/generators", "route=\"/v1/generators\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/generators/", "PUT /v1/generators", "route=\"/v1/generators\",method=\"PUT\""},
+    {crow::HTTPMethod::Delete, "/v1/generators", "DELETE /v1/generators",
+     "route=\"/v1/generators\",method=\"DELETE\""},
+    {crow::HTTPMethod::Get, "/v1/scenario", "GET /v1/scenario", "route=\"/v1/scenario\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/scenario", "PUT /v1/scenario", "route=\"/v1/scenario\",method=\"PUT\""},
+    {crow::HTTPMethod::Delete, "/v1/scenario", "DELETE /v1/scenario", "route=\"/v1/scenario\",method=\"DELETE\""},
+    {crow::HTTPMethod::Get, "/v1/commit", "GET /v1/commit", "route=\"/v1/commit\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/commit", "PUT /v1/commit", "route=\"/v1/commit\",method=\"PUT\""},
+    {crow::HTTPMethod::Post, "/v1/commit", "POST /v1/commit", "route=\"/v1/commit\",method=\"POST\""},
+    {crow::HTTPMethod::Get, "/v1/latency", "GET /v1/latency", "route=\"/v1/latency\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/latency", "PUT /v1/latency", "route=\"/v1/latency\",method=\"PUT\""},
+    {crow::HTTPMethod::Delete, "/v1/latency", "DELETE /v1/latency", "route=\"/v1/latency\",method=\"DELETE\""},
+    {crow::HTTPMethod::Get, "/v1/probes", "GET /v1/probes", "route=\"/v1/probes\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/probes/", "PUT /v1/probes", "route=\"/v1/probes\",method=\"PUT\""},
+    {crow::HTTPMethod::Delete, "/v1/probes", "DELETE /v1/probes", "route=\"/v1/probes\",method=\"DELETE\""},
+    {crow::HTTPMethod::Get, "/v1/recorder", "GET /v1/recorder", "route=\"/v1/recorder\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/recorder", "PUT /v1/recorder", "route=\"/v1/recorder\",method=\"PUT\""},
+    {crow::HTTPMethod::Post, "/v1/recorder/dump", "POST /v1/recorder/dump",
+     "route=\"/v1/recorder/dump\",method=\"POST\""},
+    {crow::HTTPMethod::Get, "/v1/monitor", "GET /v1/monitor", "route=\"/v1/monitor\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/monitor", "PUT /v1/monitor", "route=\"/v1/monitor\",method=\"PUT\""},
+    {crow::HTTPMethod::Delete, "/v1/monitor", "DELETE /v1/monitor", "route=\"/v1/monitor\",method=\"DELETE\""},
+    {crow::HTTPMethod::Get, "/metrics", "GET /metrics", "route=\"/metrics\",method=\"GET\""},
+    {crow::HTTPMethod::Post, "/v1/trace/", "POST /v1/trace", "route=\"/v1/trace\",method=\"POST\""},
+    {crow::HTTPMethod::Get, "/v1/locks", "GET /v1/locks", "route=\"/v1/locks\",method=\"GET\""},
+    {crow::HTTPMethod::Put, "/v1/locks", "PUT /v1/locks", "route=\"/v1/locks\",method=\"PUT\""},
+};
+static RouteStats g_other_route_stats{crow::HTTPMethod::Get, "", "other", "route=\"other\",method=\"any\""};
+
+static RouteStats& FindRouteStats(const crow::request& req) {
+    for (RouteStats& stats : g_route_stats) {
+        if (stats.method == req.method && req.url.compare(0, std::strlen(stats.prefix), stats.prefix) == 0) {
+            return stats;
+        }
     }
+    return g_other_route_stats;
 }
 
-// Encode RGBA pixel data as PNG into a byte vector.
-// The raw pixel data is stored bottom-row-first (OpenGL convention), so we flip
-// vertically by starting at the last row and using a negative stride.
-// Alpha is forced to 255 because OpenXR apps frequently leave alpha at 0
-static std::vector<uint8_t> EncodeRGBAToPng(const void* rgba_data, uint32_t width, uint32_t height) {
-    std::vector<uint8_t> out;
-    out.reserve(width * height);  // rough reserve
-    const int stride = static_cast<int>(width * 4);
-    // Copy pixels and force alpha to fully opaque.
-    std::vector<uint8_t> opaque(static_cast<const uint8_t*>(rgba_data),
-                                static_cast<const uint8_t*>(rgba_data) + width * height * 4);
-    for (uint32_t i = 0; i < width * height; ++i) opaque[i * 4 + 3] = 255;
-    // Point to the first byte of the last row, then walk backwards row by row.
-    const uint8_t* last_row = opaque.data() + (height - 1) * stride;
-    stbi_write_png_to_func(
-        [](void* context, void* data, int size) {
-            auto* buf = static_cast<std::vector<uint8_t>*>(context);
-            const uint8_t* bytes = static_cast<const uint8_t*>(data);
-            buf->insert(buf->end(), bytes, bytes + size);
-        },
-        &out, static_cast<int>(width), static_cast<int>(height),
-        4,  // 4 channels: RGBA
-        last_row,
-        -stride  // negative stride flips the image vertically
-    );
-    return out;
-}
+// Crow middleware that times every request and counts its body bytes per route.
+// Also records each request as a trace slice while tracing is enabled.
+struct RequestMetrics {
+    struct context {
+        metrics::Clock::time_point start;
+    };
+
+    void before_handle(crow::request& /*req*/, crow::response& /*res*/, context& ctx) {
+        trace::SetThreadName("http worker");
+        // Crow's handler threads inherit the server thread's placement on Linux but not elsewhere.
+        static thread_local bool placed = false;
+        if (!placed) {
+            ApplyThreadPlacement(ThreadClass::kHttp);
+            placed = true;
+        }
+        ctx.start = metrics::Clock::now();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        RouteStats& stats = FindRouteStats(req);
+        const metrics::Clock::time_point end = metrics::Clock::now();
+        stats.duration.Observe(end - ctx.start);
+        if (trace::IsCompiledIn() && trace::IsEnabled()) {
+            trace::Record("api", stats.trace_name,
+                          std::chrono::duration_cast<std::chrono::nanoseconds>(ctx.start.time_since_epoch()).count(),
+                          std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count());
+        }
+        stats.request_bytes.Add(req.body.size());
+        // Streamed views count their strips as the connection takes them (see ViewStreaming), and their
+        // duration ends here, once the headers are ready.
+        stats.response_bytes.Add(res.body_size());
+        // Handlers copy their response bodies out of the arena, so it can be reused before Crow
+        // writes the response.
+        RequestArena::ForThread().Reset();
+    }
+};
+
+// Forwards Crow's log output to the simulator logger, so it honours log_level/log_file and never
+// blocks an HTTP worker on console I/O.
+class CrowLogForwarder : public crow::ILogHandler {
+   public:
+    void log(const std::string& message, crow::LogLevel level) override {
+        switch (level) {
+            case crow::LogLevel::Debug:
+                OX_LOG_DEBUG("[crow] %s", message.c_str());
+                break;
+            case crow::LogLevel::Info:
+                OX_LOG_INFO("[crow] %s", message.c_str());
+                break;
+            case crow::LogLevel::Warning:
+                OX_LOG_WARN("[crow] %s", message.c_str());
+                break;
+            default:
+                OX_LOG_ERROR("[crow] %s", message.c_str());
+                break;
+        }
+    }
+};
 
 HttpServer::HttpServer()
     : simulator_(nullptr), device_profile_ptr_(nullptr), port_(8765), running_(false), should_stop_(false) {}
@@ -85,7 +162,7 @@ bool HttpServer::Start(SimulatorCore* simulator, const DeviceProfile** device_pr
         return false;  // Already running
     }
 
-    std::cout << "Starting HTTP API server on port " << port << "..." << std::endl;
+    OX_LOG_INFO("Starting HTTP API server on port %d...", port);
 
     simulator_ = simulator;
     device_profile_ptr_ = device_profile_ptr;
@@ -101,16 +178,17 @@ bool HttpServer::Start(SimulatorCore* simulator, const DeviceProfile** device_pr
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
     if (running_.load()) {
-        std::cout << "HTTP API server started successfully" << std::endl;
-        std::cout << "Use API endpoints to control the simulator:" << std::endl;
-        std::cout << "  GET/PUT  http://localhost:" << port << "/v1/profile" << std::endl;
-        std::cout << "  GET      http://localhost:" << port << "/v1/status" << std::endl;
-        std::cout << "  GET/PUT  http://localhost:" << port << "/v1/devices/user/head" << std::endl;
-        std::cout << "  GET/PUT  http://localhost:" << port << "/v1/devices/user/hand/right" << std::endl;
-        std::cout << "  GET/PUT  http://localhost:" << port << "/v1/inputs/user/hand/right/input/trigger/value"
-                  << std::endl;
-        std::cout << "  GET      http://localhost:" << port << "/v1/views/0" << std::endl;
-        std::cout << "  GET      http://localhost:" << port << "/v1/views/1" << std::endl;
+        OX_LOG_INFO("HTTP API server started successfully");
+        OX_LOG_INFO("Use API endpoints to control the simulator:");
+        OX_LOG_INFO("  GET/PUT  http://localhost:%d/v1/profile", port);
+        OX_LOG_INFO("  GET      http://localhost:%d/v1/status", port);
+        OX_LOG_INFO("  GET/PUT  http://localhost:%d/v1/devices/user/head", port);
+        OX_LOG_INFO("  GET/PUT  http://localhost:%d/v1/devices/user/hand/right", port);
+        OX_LOG_INFO("  GET/PUT  http://localhost:%d/v1/inputs/user/hand/right/input/trigger/value", port);
+        OX_LOG_INFO("  GET      http://localhost:%d/v1/views/0", port);
+        OX_LOG_INFO("  GET      http://localhost:%d/v1/views/1", port);
+        OX_LOG_INFO("  GET/PUT  http://localhost:%d/v1/scenario", port);
+        OX_LOG_INFO("  GET      http://localhost:%d/metrics", port);
     }
 
     return running_.load();
@@ -126,367 +204,227 @@ void HttpServer::Stop() {
     }
 }
 
-std::pair<std::string, std::string> SplitBindingPath(const std::string& binding_path) {
-    size_t pos = binding_path.find("/input/");
-    if (pos == std::string::npos) {
-        return {"", ""};  // Invalid path
-    }
-    std::string user_path = binding_path.substr(0, pos);
-    std::string component_path = binding_path.substr(pos);
-    return {user_path, component_path};
-}
-
 void HttpServer::ServerThread() {
-    std::cout << "HTTP Server starting on port " << port_ << "..." << std::endl;
-    std::cout.flush();
+    ApplyThreadPlacement(ThreadClass::kHttp);
+    OX_LOG_DEBUG("HTTP Server starting on port %d...", port_);
 
     running_.store(true);
 
-    app_ = std::make_unique<crow::SimpleApp>();
-    crow::SimpleApp& app = *app_;
+    app_ = std::make_unique<ApiApp>();
+    ApiApp& app = *app_;
 
     CROW_ROUTE(app, "/v1/devices/<path>").methods("GET"_method)([this](const std::string& user_path) {
-        // prepend '/' to user_path since it'll be missing
-        std::string full_user_path = "/" + user_path;
-
-        OxPose pose;
-        bool is_active;
-        if (!simulator_->GetDevicePose(full_user_path.c_str(), &pose, &is_active)) {
-            return crow::response(404, "Device not found");
-        }
-
-        crow::json::wvalue response;
-        response["active"] = is_active;
-        response["position"]["x"] = pose.position.x;
-        response["position"]["y"] = pose.position.y;
-        response["position"]["z"] = pose.position.z;
-        response["orientation"]["x"] = pose.orientation.x;
-        response["orientation"]["y"] = pose.orientation.y;
-        response["orientation"]["z"] = pose.orientation.z;
-        response["orientation"]["w"] = pose.orientation.w;
-        return crow::response(response);
+        return HandleGetDevice(*simulator_, user_path);
     });
 
     CROW_ROUTE(app, "/v1/devices/<path>")
         .methods("PUT"_method)([this](const crow::request& req, const std::string& user_path) {
-            auto json = crow::json::load(req.body);
-            if (!json) {
-                return crow::response(400, "Invalid JSON");
-            }
-
-            if (!json.has("position") || !json.has("orientation") || !json["position"].has("x") ||
-                !json["position"].has("y") || !json["position"].has("z") || !json["orientation"].has("x") ||
-                !json["orientation"].has("y") || !json["orientation"].has("z") || !json["orientation"].has("w")) {
-                return crow::response(400, "Missing required fields: position{x,y,z}, orientation{x,y,z,w}");
-            }
+            return HandlePutDevice(*simulator_, req, user_path);
+        });
 
-            // prepend '/' to user_path since it'll be missing
-            std::string full_user_path = "/" + user_path;
+    CROW_ROUTE(app, "/v1/inputs/<path>").methods("GET"_method)([this](const std::string& binding_path) {
+        return HandleGetInput(*simulator_, binding_path);
+    });
 
-            bool is_active = json.has("active") ? json["active"].b() : true;
+    CROW_ROUTE(app, "/v1/inputs/<path>")
+        .methods("PUT"_method)([this](const crow::request& req, const std::string& binding_path) {
+            return HandlePutInput(*simulator_, req, binding_path);
+        });
 
-            OxPose pose;
-            pose.position.x = json["position"]["x"].d();
-            pose.position.y = json["position"]["y"].d();
-            pose.position.z = json["position"]["z"].d();
-            pose.orientation.x = json["orientation"]["x"].d();
-            pose.orientation.y = json["orientation"]["y"].d();
-            pose.orientation.z = json["orientation"]["z"].d();
-            pose.orientation.w = json["orientation"]["w"].d();
+    // Session status: state + FPS
+    CROW_ROUTE(app, "/v1/status").methods("GET"_method)([]() { return HandleGetStatus(); });
 
-            simulator_->SetDevicePose(full_user_path.c_str(), pose, is_active);
-            return crow::response(200, "OK");
-        });
+    // Eye texture endpoints — return PNG images, encoded on the task pool
+    CROW_ROUTE(app, "/v1/views/0").methods("GET"_method)([this](const crow::request& req, crow::response& res) {
+        SubmitView(req, res, 0);
+    });
 
-    CROW_ROUTE(app, "/v1/inputs/<path>").methods("GET"_method)([this](const std::string& binding_path) {
-        // prepend '/' to binding_path since it'll be missing
-        std::string full_binding_path = "/" + binding_path;
+    CROW_ROUTE(app, "/v1/views/1").methods("GET"_method)([this](const crow::request& req, crow::response& res) {
+        SubmitView(req, res, 1);
+    });
 
-        auto [user_path, component_path] = SplitBindingPath(full_binding_path);
-        if (user_path.empty() || component_path.empty()) {
-            return crow::response(400, "Invalid binding path");
-        }
+    // Get current device profile
+    CROW_ROUTE(app, "/v1/profile").methods("GET"_method)([this]() {
+        return HandleGetProfile(*device_profile_ptr_);
+    });
 
-        // Determine component type from device profile
-        const DeviceDef* device_def = simulator_->FindDeviceDefByUserPath(user_path.c_str());
-        if (!device_def) {
-            return crow::response(404, "Device not found");
-        }
-        auto [comp_index, comp_type] = simulator_->FindComponentInfo(device_def, component_path.c_str());
-        if (comp_index == -1) {
-            return crow::response(404, "Component not found in device profile");
-        }
+    // Switch device profile
+    CROW_ROUTE(app, "/v1/profile").methods("PUT"_method)([this](const crow::request& req) {
+        return HandlePutProfile(*simulator_, device_profile_ptr_, req);
+    });
 
-        crow::json::wvalue response;
-        OxComponentResult result;
-
-        // Call the appropriate type-specific function
-        if (comp_type == ComponentType::BOOLEAN) {
-            bool value = false;
-            result = simulator_->GetInputStateBoolean(user_path.c_str(), component_path.c_str(), &value);
-            if (result != OX_COMPONENT_AVAILABLE) {
-                return crow::response(404, "Component not available");
-            }
-            response["type"] = "boolean";
-            response["value"] = value;
-        } else if (comp_type == ComponentType::FLOAT) {
-            float value = 0.0f;
-            result = simulator_->GetInputStateFloat(user_path.c_str(), component_path.c_str(), &value);
-            if (result != OX_COMPONENT_AVAILABLE) {
-                return crow::response(404, "Component not available");
-            }
-            response["type"] = "float";
-            response["value"] = value;
-        } else {  // VEC2
-            OxVector2f vec;
-            result = simulator_->GetInputStateVec2(user_path.c_str(), component_path.c_str(), &vec);
-            if (result != OX_COMPONENT_AVAILABLE) {
-                return crow::response(404, "Component not available");
-            }
-            response["type"] = "vec2";
-            response["x"] = vec.x;
-            response["y"] = vec.y;
-        }
+    // Input generators: waveforms evaluated at the predicted_time the runtime samples the input at
+    CROW_ROUTE(app, "/v1/generators").methods("GET"_method)([this]() { return HandleGetGenerators(*simulator_); });
 
-        return crow::response(response);
+    CROW_ROUTE(app, "/v1/generators").methods("DELETE"_method)([this]() {
+        return HandleDeleteGenerators(*simulator_);
     });
 
-    CROW_ROUTE(app, "/v1/inputs/<path>")
+    CROW_ROUTE(app, "/v1/generators/<path>")
         .methods("PUT"_method)([this](const crow::request& req, const std::string& binding_path) {
-            auto json = crow::json::load(req.body);
-            if (!json) {
-                return crow::response(400, "Invalid JSON");
-            }
+            return HandlePutGenerator(*simulator_, req, binding_path);
+        });
 
-            // prepend '/' to binding_path since it'll be missing
-            std::string full_binding_path = "/" + binding_path;
+    CROW_ROUTE(app, "/v1/generators/<path>").methods("DELETE"_method)([this](const std::string& binding_path) {
+        return HandleDeleteGenerator(*simulator_, binding_path);
+    });
 
-            auto [user_path, component_path] = SplitBindingPath(full_binding_path);
-            if (user_path.empty() || component_path.empty()) {
-                return crow::response(400, "Invalid binding path");
-            }
+    // Scenario timelines: upload to start a run, poll for its progress, delete to stop it
+    CROW_ROUTE(app, "/v1/scenario").methods("GET"_method)([]() { return HandleGetScenario(*GetScenarioRunner()); });
 
-            // Determine component type from device profile
-            const DeviceDef* device_def = simulator_->FindDeviceDefByUserPath(user_path.c_str());
-            if (!device_def) {
-                return crow::response(404, "Device not found");
-            }
-            auto [comp_index, comp_type] = simulator_->FindComponentInfo(device_def, component_path.c_str());
-            if (comp_index == -1) {
-                return crow::response(404, "Component not found in device profile");
-            }
+    CROW_ROUTE(app, "/v1/scenario").methods("PUT"_method)([this](const crow::request& req) {
+        return HandlePutScenario(*simulator_, device_profile_ptr_, *GetScenarioRunner(), req);
+    });
 
-            // Handle different component types
-            switch (comp_type) {
-                case ComponentType::BOOLEAN: {
-                    if (!json.has("value")) {
-                        return crow::response(400, "Missing required field: value");
-                    }
-                    bool bool_value = false;
-                    if (json["value"].t() == crow::json::type::True || json["value"].t() == crow::json::type::False) {
-                        bool_value = json["value"].b();
-                    } else if (json["value"].t() == crow::json::type::Number) {
-                        bool_value = json["value"].d() >= 0.5;
-                    } else {
-                        return crow::response(400, "Invalid value for boolean component");
-                    }
-                    simulator_->SetInputStateBoolean(user_path.c_str(), component_path.c_str(), bool_value);
-                    break;
-                }
-                case ComponentType::FLOAT: {
-                    if (!json.has("value")) {
-                        return crow::response(400, "Missing required field: value");
-                    }
-                    float float_value = 0.0f;
-                    if (json["value"].t() == crow::json::type::Number) {
-                        float_value = json["value"].d();
-                    } else if (json["value"].t() == crow::json::type::True ||
-                               json["value"].t() == crow::json::type::False) {
-                        float_value = json["value"].b() ? 1.0f : 0.0f;
-                    } else {
-                        return crow::response(400, "Invalid value for float component");
-                    }
-                    simulator_->SetInputStateFloat(user_path.c_str(), component_path.c_str(), float_value);
-                    break;
-                }
-                case ComponentType::VEC2: {
-                    OxVector2f vec = {0.0f, 0.0f};
-
-                    // Check if it's an object with x,y fields
-                    if (json.has("x") && json.has("y")) {
-                        if (json["x"].t() == crow::json::type::Number && json["y"].t() == crow::json::type::Number) {
-                            vec.x = json["x"].d();
-                            vec.y = json["y"].d();
-                        } else {
-                            return crow::response(400, "Invalid x,y values for vec2 component");
-                        }
-                    } else {
-                        return crow::response(400, "Missing required fields: x,y for vec2 component");
-                    }
-
-                    simulator_->SetInputStateVec2(user_path.c_str(), component_path.c_str(), vec);
-                    break;
-                }
-            }
+    CROW_ROUTE(app, "/v1/scenario").methods("DELETE"_method)([]() {
+        return HandleDeleteScenario(*GetScenarioRunner());
+    });
 
-            return crow::response(200, "OK");
-        });
+    // Frame-boundary commit mode: staged writes are published on the next frame or on POST
+    CROW_ROUTE(app, "/v1/commit").methods("GET"_method)([this]() { return HandleGetCommit(*simulator_); });
 
-    // Session status: state + FPS
-    CROW_ROUTE(app, "/v1/status").methods("GET"_method)([]() {
-        FrameData* fd = GetFrameData();
-        OxSessionState state = fd ? static_cast<OxSessionState>(fd->session_state.load(std::memory_order_relaxed))
-                                  : OX_SESSION_STATE_UNKNOWN;
-        uint32_t fps = (fd && fd->IsSessionActive()) ? fd->app_fps.load(std::memory_order_relaxed) : 0u;
+    CROW_ROUTE(app, "/v1/commit").methods("PUT"_method)([this](const crow::request& req) {
+        return HandlePutCommit(*simulator_, req);
+    });
 
-        crow::json::wvalue response;
-        response["session_state"] = SessionStateName(state);
-        response["session_state_id"] = static_cast<int>(state);
-        response["session_active"] = fd ? fd->IsSessionActive() : false;
-        response["fps"] = fps;
-        return crow::response(response);
+    CROW_ROUTE(app, "/v1/commit").methods("POST"_method)([this]() { return HandlePostCommit(*simulator_); });
+
+    // Input-to-photon latency: start a measurement, poll for its samples, delete to stop it
+    CROW_ROUTE(app, "/v1/latency").methods("GET"_method)([]() { return HandleGetLatency(*GetLatencyProbe()); });
+
+    CROW_ROUTE(app, "/v1/latency").methods("PUT"_method)([this](const crow::request& req) {
+        return HandlePutLatency(*simulator_, *GetLatencyProbe(), req);
     });
 
-    // Eye texture endpoints — return PNG images
-    auto eye_frame_handler = [](const crow::request& req, int eye_index) -> crow::response {
-        FrameData* fd = GetFrameData();
-        if (!fd) {
-            return crow::response(503, "Frame data unavailable");
-        }
+    CROW_ROUTE(app, "/v1/latency").methods("DELETE"_method)([]() { return HandleDeleteLatency(*GetLatencyProbe()); });
 
-        std::lock_guard<std::mutex> lock(fd->mutex);
+    // Pixel probes: register assertions on submitted frames, then poll them or wait for a state
+    CROW_ROUTE(app, "/v1/probes").methods("GET"_method)([](const crow::request& req) {
+        return HandleGetProbes(*GetPixelWatch(), req);
+    });
 
-        if (!fd->pixel_data[eye_index] || fd->width == 0 || fd->height == 0) {
-            return crow::response(404, "No frame available");
-        }
+    CROW_ROUTE(app, "/v1/probes").methods("DELETE"_method)([]() { return HandleDeleteProbes(*GetPixelWatch()); });
 
-        uint32_t output_width = fd->width;
-        uint32_t output_height = fd->height;
+    CROW_ROUTE(app, "/v1/probes/<string>").methods("GET"_method)([](const std::string& id) {
+        return HandleGetProbe(*GetPixelWatch(), id);
+    });
 
-        // Check for optional "size" query parameter (target width)
-        if (auto size_param = req.url_params.get("size")) {
-            try {
-                int requested_width = std::stoi(size_param);
-                if (requested_width > 0) {
-                    float aspect_ratio = static_cast<float>(fd->width) / static_cast<float>(fd->height);
-                    output_width = static_cast<uint32_t>(requested_width);
-                    output_height = static_cast<uint32_t>(requested_width / aspect_ratio);
-                }
-            } catch (...) {
-                // Invalid size parameter, ignore and use original size
-            }
-        }
+    CROW_ROUTE(app, "/v1/probes/<string>")
+        .methods("PUT"_method)([](const crow::request& req, const std::string& id) {
+            return HandlePutProbe(*GetPixelWatch(), req, id);
+        });
 
-        std::vector<uint8_t> png;
-        if (output_width == fd->width && output_height == fd->height) {
-            // No resizing needed
-            png = EncodeRGBAToPng(fd->pixel_data[eye_index], fd->width, fd->height);
-        } else {
-            // Resize the image
-            std::vector<uint8_t> resized_pixels(output_width * output_height * 4);
-            int resize_result = stbir_resize_uint8(static_cast<const uint8_t*>(fd->pixel_data[eye_index]), fd->width,
-                                                   fd->height, 0, resized_pixels.data(), output_width, output_height, 0,
-                                                   4  // RGBA channels
-            );
-
-            if (resize_result == 0) {
-                return crow::response(500, "Image resizing failed");
-            }
+    CROW_ROUTE(app, "/v1/probes/<string>").methods("DELETE"_method)([](const std::string& id) {
+        return HandleDeleteProbe(*GetPixelWatch(), id);
+    });
 
-            png = EncodeRGBAToPng(resized_pixels.data(), output_width, output_height);
-        }
+    CROW_ROUTE(app, "/v1/probes/<string>/wait")
+        .methods("GET"_method)([](const crow::request& req, crow::response& res, const std::string& id) {
+            HandleWaitProbe(*GetPixelWatch(), req, res, id);
+        });
 
-        if (png.empty()) {
-            return crow::response(500, "PNG encoding failed");
-        }
+    // Flight recorder: settings and state, and a background dump of the recorded frames
+    CROW_ROUTE(app, "/v1/recorder").methods("GET"_method)([]() { return HandleGetRecorder(*GetFlightRecorder()); });
 
-        crow::response resp;
-        resp.code = 200;
-        resp.set_header("Content-Type", "image/png");
-        resp.body = std::string(reinterpret_cast<const char*>(png.data()), png.size());
-        return resp;
-    };
+    CROW_ROUTE(app, "/v1/recorder").methods("PUT"_method)([](const crow::request& req) {
+        return HandlePutRecorder(*GetFlightRecorder(), req);
+    });
 
-    CROW_ROUTE(app, "/v1/views/0").methods("GET"_method)([&eye_frame_handler](const crow::request& req) {
-        return eye_frame_handler(req, 0);
+    CROW_ROUTE(app, "/v1/recorder/dump").methods("POST"_method)([](const crow::request& req) {
+        return HandlePostRecorderDump(*GetFlightRecorder(), req);
     });
 
-    CROW_ROUTE(app, "/v1/views/1").methods("GET"_method)([&eye_frame_handler](const crow::request& req) {
-        return eye_frame_handler(req, 1);
+    // Frame monitor: per-eye statistics and black/frozen/mismatch detectors
+    CROW_ROUTE(app, "/v1/monitor").methods("GET"_method)([]() { return HandleGetMonitor(*GetFrameMonitor()); });
+
+    CROW_ROUTE(app, "/v1/monitor").methods("PUT"_method)([](const crow::request& req) {
+        return HandlePutMonitor(*GetFrameMonitor(), req);
     });
 
-    // Get current device profile
-    CROW_ROUTE(app, "/v1/profile").methods("GET"_method)([this]() {
-        const DeviceProfile* profile = *device_profile_ptr_;
-        if (!profile) {
-            return crow::response(500, "No device profile loaded");
+    CROW_ROUTE(app, "/v1/monitor").methods("DELETE"_method)([]() { return HandleDeleteMonitor(*GetFrameMonitor()); });
+
+    // Trace capture: start recording, then stop to receive Chrome trace-event JSON
+    // (open in chrome://tracing or https://ui.perfetto.dev)
+    CROW_ROUTE(app, "/v1/trace/start").methods("POST"_method)([]() {
+        if (!trace::IsCompiledIn()) {
+            return crow::response(501, "Tracing not compiled in (OX_SIM_ENABLE_TRACING=OFF)");
         }
+        trace::Start();
+        return crow::response(200, "OK");
+    });
 
-        crow::json::wvalue response;
-        response["type"] = profile->name;
-        response["manufacturer"] = profile->manufacturer;
-        response["interaction_profile"] = profile->interaction_profile;
-
-        // List devices
-        crow::json::wvalue devices_array(crow::json::type::List);
-        for (size_t i = 0; i < profile->devices.size(); ++i) {
-            const auto& dev = profile->devices[i];
-            crow::json::wvalue dev_obj;
-            dev_obj["user_path"] = dev.user_path;
-            dev_obj["role"] = dev.role;
-            dev_obj["always_active"] = dev.always_active;
-
-            // List components
-            crow::json::wvalue components_array(crow::json::type::List);
-            for (size_t j = 0; j < dev.components.size(); ++j) {
-                const auto& comp = dev.components[j];
-                crow::json::wvalue comp_obj;
-                comp_obj["path"] = comp.path;
-                comp_obj["type"] = (comp.type == ComponentType::FLOAT     ? "float"
-                                    : comp.type == ComponentType::BOOLEAN ? "boolean"
-                                                                          : "vec2");
-                comp_obj["description"] = comp.description;
-                components_array[j] = std::move(comp_obj);
-            }
-            dev_obj["components"] = std::move(components_array);
+    CROW_ROUTE(app, "/v1/trace/stop").methods("POST"_method)([]() {
+        if (!trace::IsCompiledIn()) {
+            return crow::response(501, "Tracing not compiled in (OX_SIM_ENABLE_TRACING=OFF)");
+        }
+        crow::response resp(200, trace::Stop());
+        resp.set_header("Content-Type", "application/json");
+        return resp;
+    });
 
-            devices_array[i] = std::move(dev_obj);
+    // Lock contention report: top-N call sites by total wait time
+    CROW_ROUTE(app, "/v1/locks").methods("GET"_method)([](const crow::request& req) {
+        size_t top = 10;
+        if (auto top_param = req.url_params.get("top")) {
+            try {
+                int requested = std::stoi(top_param);
+                if (requested > 0) top = static_cast<size_t>(requested);
+            } catch (...) {
+                // Invalid top parameter, keep the default
+            }
         }
-        response["devices"] = std::move(devices_array);
 
+        crow::json::wvalue response;
+        response["compiled_in"] = lock_profiler::IsCompiledIn();
+        response["enabled"] = lock_profiler::IsEnabled();
+
+        std::vector<LockSiteStats> sites = lock_profiler::TopContendedSites(top);
+        crow::json::wvalue sites_array(crow::json::type::List);
+        for (size_t i = 0; i < sites.size(); ++i) {
+            const LockSiteStats& s = sites[i];
+            crow::json::wvalue site;
+            site["lock"] = s.lock_name;
+            site["site"] = std::string(s.file) + ":" + std::to_string(s.line);
+            site["function"] = s.function;
+            site["acquisitions"] = s.acquisitions;
+            site["contended"] = s.contended;
+            site["wait_us_total"] = static_cast<double>(s.wait_ns_total) / 1000.0;
+            site["wait_us_max"] = static_cast<double>(s.wait_ns_max) / 1000.0;
+            site["hold_us_total"] = static_cast<double>(s.hold_ns_total) / 1000.0;
+            site["hold_us_max"] = static_cast<double>(s.hold_ns_max) / 1000.0;
+            sites_array[i] = std::move(site);
+        }
+        response["sites"] = std::move(sites_array);
         return crow::response(response);
     });
 
-    // Switch device profile
-    CROW_ROUTE(app, "/v1/profile").methods("PUT"_method)([this](const crow::request& req) {
+    // Enable/disable lock profiling and optionally clear the collected statistics
+    CROW_ROUTE(app, "/v1/locks").methods("PUT"_method)([](const crow::request& req) {
         auto json = crow::json::load(req.body);
         if (!json) {
             return crow::response(400, "Invalid JSON");
         }
-
-        if (!json.has("device") || json["device"].t() != crow::json::type::String) {
-            return crow::response(400, "Missing required field: device (string)");
+        if (!lock_profiler::IsCompiledIn()) {
+            return crow::response(501, "Lock profiling not compiled in (OX_SIM_LOCK_PROFILING=OFF)");
         }
 
-        std::string device_name = json["device"].s();
-        const DeviceProfile* new_profile = GetDeviceProfileByName(device_name);
-        if (!new_profile) {
-            return crow::response(404, "Unknown device: " + device_name);
+        if (json.has("enabled")) {
+            if (json["enabled"].t() != crow::json::type::True && json["enabled"].t() != crow::json::type::False) {
+                return crow::response(400, "Invalid value for enabled (boolean)");
+            }
+            lock_profiler::SetEnabled(json["enabled"].b());
         }
-
-        // Switch the device
-        if (!simulator_->SwitchDevice(new_profile)) {
-            return crow::response(500, "Failed to switch device");
+        if (json.has("reset") && json["reset"].t() == crow::json::type::True) {
+            lock_profiler::Reset();
         }
+        return crow::response(200, "OK");
+    });
 
-        // Update the global pointer
-        *device_profile_ptr_ = new_profile;
-
-        crow::json::wvalue response;
-        response["status"] = "ok";
-        response["device"] = new_profile->name;
-        response["interaction_profile"] = new_profile->interaction_profile;
-        return crow::response(response);
+    // Prometheus scrape endpoint
+    CROW_ROUTE(app, "/metrics").methods("GET"_method)([]() {
+        crow::response resp(200, metrics::RenderPrometheus());
+        resp.set_header("Content-Type", "text/plain; version=0.0.4");
+        return resp;
     });
 
     CROW_ROUTE(app, "/")
@@ -497,11 +435,33 @@ void HttpServer::ServerThread() {
                "  GET/PUT  /v1/devices/<user_path>    - Get/set device pose\n"
                "  GET/PUT  /v1/inputs/<binding_path>  - Get/set input component state\n"
                "  GET      /v1/views/0                - Left eye texture (PNG)\n"
-               "  GET      /v1/views/1                - Right eye texture (PNG)\n";
+               "  GET      /v1/views/1                - Right eye texture (PNG)\n"
+               "  GET      /v1/generators             - List input generators (DELETE removes all)\n"
+               "  PUT      /v1/generators/<path>      - Attach an input generator (DELETE removes it)\n"
+               "  GET/PUT  /v1/scenario               - Scenario status / upload and start a scenario\n"
+               "  DELETE   /v1/scenario               - Stop the running scenario\n"
+               "  GET/PUT  /v1/commit                 - Frame-boundary commit mode / enable it\n"
+               "  POST     /v1/commit                 - Publish staged writes now\n"
+               "  GET/PUT  /v1/latency                - Input-to-photon results / start a measurement\n"
+               "  DELETE   /v1/latency                - Stop the running measurement\n"
+               "  GET      /v1/probes                 - Pixel probes and their events (DELETE removes all)\n"
+               "  PUT      /v1/probes/<id>            - Register a pixel probe (GET/DELETE one)\n"
+               "  GET      /v1/probes/<id>/wait       - Wait until a probe matches (or ?matched=false)\n"
+               "  GET/PUT  /v1/recorder               - Flight recorder state / enable and configure it\n"
+               "  POST     /v1/recorder/dump          - Write the recorded frames to disk in the background\n"
+               "  GET/PUT  /v1/monitor                - Frame statistics and black/frozen/mismatch detectors\n"
+               "  DELETE   /v1/monitor                - Clear the frame monitor's measurements and counters\n"
+               "  POST     /v1/trace/start            - Start a trace capture\n"
+               "  POST     /v1/trace/stop             - Stop the capture and return Chrome trace JSON\n"
+               "  GET/PUT  /v1/locks                  - Lock contention report / enable profiling\n"
+               "  GET      /metrics                   - Prometheus metrics\n";
     });
 
-    std::cout << "Starting HTTP server on port " << port_ << "..." << std::endl;
-    std::cout.flush();
+    OX_LOG_DEBUG("Starting HTTP server on port %d...", port_);
+
+    // Route Crow's own messages (per-request lines, errors) through the simulator logger.
+    static CrowLogForwarder crow_log_forwarder;
+    crow::logger::setHandler(&crow_log_forwarder);
 
     try {
         app.loglevel(crow::LogLevel::Info);
@@ -510,15 +470,66 @@ void HttpServer::ServerThread() {
         app.port(port_);
         app.run();
     } catch (const std::exception& e) {
-        std::cerr << "Exception starting server: " << e.what() << std::endl;
+        OX_LOG_ERROR("Exception starting server: %s", e.what());
     } catch (...) {
-        std::cerr << "Unknown exception starting server" << std::endl;
+        OX_LOG_ERROR("Unknown exception starting server");
     }
 
+    // Pending probe waits refer to connections that are destroyed with the app, and running view
+    // tasks post their responses and streamed strips to its event loop.
+    GetPixelWatch()->DropWaiters();
+    {
+        std::unique_lock<std::mutex> lock(tasks_mutex_);
+        tasks_cv_.wait(lock, [this] { return tasks_in_flight_ == 0; });
+    }
     app_.reset();
     running_.store(false);
-    std::cout << "HTTP Server stopped" << std::endl;
-    std::cout.flush();
+    OX_LOG_INFO("HTTP Server stopped");
+}
+
+void HttpServer::SubmitView(const crow::request& req, crow::response& res, int eye) {
+    // The connection (and so `res`) stays alive until res.end(), which has to run on the event loop.
+    asio::io_context* io_context = req.io_context;
+    crow::response* pending = &res;
+    auto task = [this, request = req, io_context, pending, eye]() {
+        // Streamed bodies are encoded by further tasks after this one has posted the headers.
+        ViewStreaming streaming;
+        streaming.submit = [this](std::function<void()> strip_task) { return SubmitTask(std::move(strip_task)); };
+        streaming.bytes_sent = &FindRouteStats(request).response_bytes;
+        crow::response result = HandleGetView(request, eye, &streaming);
+        asio::post(*io_context, [pending, result = std::move(result)]() mutable {
+            *pending = std::move(result);
+            pending->end();
+        });
+    };
+    if (!SubmitTask(std::move(task))) {
+        res = HandleGetView(req, eye);
+        res.end();
+    }
+}
+
+bool HttpServer::SubmitTask(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks_in_flight_++;
+    }
+    // Counted out when the task is destroyed rather than when it returns, so one the pool refuses or
+    // drops unrun on shutdown does not keep ServerThread() waiting.
+    struct Finisher {
+        explicit Finisher(HttpServer* s) : server(s) {}
+        ~Finisher() { server->FinishTask(); }
+        HttpServer* server;
+    };
+    auto counted = [finisher = std::make_shared<Finisher>(this), task = std::move(task)]() { task(); };
+    return GetTaskPool()->Submit(TaskPriority::kControl, std::move(counted));
+}
+
+void HttpServer::FinishTask() {
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks_in_flight_--;
+    }
+    tasks_cv_.notify_all();
 }
 
 }  // namespace ox_sim
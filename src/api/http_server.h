@@ -1,7 +1,11 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 #include "simulator_core.h"
@@ -10,11 +14,15 @@
 namespace crow {
 template <typename... Middlewares>
 class Crow;
-using SimpleApp = Crow<>;
+struct request;
+struct response;
 }  // namespace crow
 
 namespace ox_sim {
 
+struct RequestMetrics;  // Crow middleware recording per-route metrics (http_server.cpp)
+using ApiApp = crow::Crow<RequestMetrics>;
+
 class HttpServer {
    public:
     HttpServer();
@@ -32,13 +40,25 @@ class HttpServer {
    private:
     void ServerThread();
 
+    // Answer a view request from the task pool instead of the server's single worker thread.
+    void SubmitView(const crow::request& req, crow::response& res, int eye);
+    // Run `task` on the task pool, counted in tasks_in_flight_; false if the pool refused it.
+    bool SubmitTask(std::function<void()> task);
+    void FinishTask();
+
     SimulatorCore* simulator_;
     const DeviceProfile** device_profile_ptr_;  // Pointer to device profile pointer (for switching)
     int port_;
     std::thread server_thread_;
     std::atomic<bool> running_;
     std::atomic<bool> should_stop_;
-    std::unique_ptr<crow::SimpleApp> app_;
+    std::unique_ptr<ApiApp> app_;
+
+    // View and strip encoding tasks still running; the app (and with it the event loop they post
+    // to) is only destroyed once this drops to zero.
+    std::mutex tasks_mutex_;
+    std::condition_variable tasks_cv_;
+    uint32_t tasks_in_flight_ = 0;
 };
 
 }  // namespace ox_sim
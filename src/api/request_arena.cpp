@@ -0,0 +1,85 @@
+#include "request_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "metrics.h"
+
+namespace ox_sim {
+
+static metrics::Counter g_arena_blocks("ox_request_arena_blocks_allocated_total",
+                                       "Request arena blocks allocated beyond each worker's first block");
+
+// Blocks are malloc'ed with their header in front, so the data is max_align_t aligned.
+RequestArena::Block* RequestArena::NewBlock(size_t size) {
+    void* memory = std::malloc(sizeof(Block) + size);
+    if (!memory) throw std::bad_alloc();
+    return new (memory) Block{nullptr, size};
+}
+
+RequestArena::RequestArena(size_t block_size)
+    : block_size_(block_size), first_(NewBlock(block_size)), current_(first_) {}
+
+RequestArena::~RequestArena() {
+    for (Block* block = first_; block;) {
+        Block* next = block->next;
+        std::free(block);
+        block = next;
+    }
+}
+
+void* RequestArena::Allocate(size_t size, size_t align) {
+    const size_t start = (offset_ + align - 1) & ~(align - 1);
+    if (start + size <= current_->size) {
+        offset_ = start + size;
+        return Data(current_) + start;
+    }
+    return AllocateSlow(size, align);
+}
+
+void* RequestArena::AllocateSlow(size_t size, size_t align) {
+    // Blocks are only chained at the end, so the current block is always the last one.
+    Block* block = NewBlock(std::max(block_size_, size + align));
+    g_arena_blocks.Add();
+    current_->next = block;
+    used_ += offset_;
+    current_ = block;
+    offset_ = 0;
+    return Allocate(size, align);
+}
+
+std::string_view RequestArena::Copy(std::string_view text) {
+    char* out = static_cast<char*>(Allocate(text.size() + 1, 1));
+    std::memcpy(out, text.data(), text.size());
+    out[text.size()] = '\0';
+    return std::string_view(out, text.size());
+}
+
+std::string_view RequestArena::Concat(std::string_view a, std::string_view b) {
+    char* out = static_cast<char*>(Allocate(a.size() + b.size() + 1, 1));
+    std::memcpy(out, a.data(), a.size());
+    std::memcpy(out + a.size(), b.data(), b.size());
+    out[a.size() + b.size()] = '\0';
+    return std::string_view(out, a.size() + b.size());
+}
+
+void RequestArena::Reset() {
+    for (Block* block = first_->next; block;) {
+        Block* next = block->next;
+        std::free(block);
+        block = next;
+    }
+    first_->next = nullptr;
+    current_ = first_;
+    offset_ = 0;
+    used_ = 0;
+}
+
+RequestArena& RequestArena::ForThread() {
+    thread_local RequestArena arena;
+    return arena;
+}
+
+}  // namespace ox_sim
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ox_sim {
+
+// Monotonic allocator for the short-lived data of one API request: the parsed JSON body, path
+// strings and the response being built. Allocation bumps a pointer in the current block and
+// nothing is freed individually; Reset() after the request makes all of it reusable at once.
+// The first block is kept across resets, so a typical request allocates nothing from the heap;
+// larger requests chain extra blocks, which Reset() frees.
+//
+// Each HTTP worker thread has its own arena (ForThread()); the server's middleware resets it after
+// every request. Memory from the arena must not outlive the request, so response bodies are
+// copied out of it.
+class RequestArena {
+   public:
+    explicit RequestArena(size_t block_size = kDefaultBlockSize);
+    ~RequestArena();
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    // `size` bytes aligned to `align` (a power of two, at most alignof(std::max_align_t)).
+    void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template <typename T>
+    T* AllocateArray(size_t count) {
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // NUL-terminated copy of `text`, so it can be passed on as a C string.
+    std::string_view Copy(std::string_view text);
+
+    // NUL-terminated concatenation of `a` and `b`.
+    std::string_view Concat(std::string_view a, std::string_view b);
+
+    // Make everything allocated so far reusable. Frees all blocks but the first.
+    void Reset();
+
+    size_t BytesUsed() const { return used_ + offset_; }
+
+    // The calling thread's arena.
+    static RequestArena& ForThread();
+
+    static constexpr size_t kDefaultBlockSize = 16 * 1024;
+
+   private:
+    struct Block {
+        Block* next;
+        size_t size;  // usable bytes after the header
+    };
+
+    static Block* NewBlock(size_t size);
+    static char* Data(Block* block) { return reinterpret_cast<char*>(block + 1); }
+
+    void* AllocateSlow(size_t size, size_t align);
+
+    size_t block_size_;
+    Block* first_;
+    Block* current_;
+    size_t offset_ = 0;  // into current_
+    size_t used_ = 0;    // in the blocks before current_
+};
+
+}  // namespace ox_sim
@@ -0,0 +1,453 @@
+#include "scenario_loader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "crow/json.h"
+
+namespace ox_sim {
+
+namespace {
+
+using crow::json::rvalue;
+using crow::json::type;
+
+struct SessionStateEntry {
+    const char* name;
+    OxSessionState state;
+};
+
+const SessionStateEntry kSessionStates[] = {
+    {"idle", OX_SESSION_STATE_IDLE},
+    {"ready", OX_SESSION_STATE_READY},
+    {"synchronized", OX_SESSION_STATE_SYNCHRONIZED},
+    {"visible", OX_SESSION_STATE_VISIBLE},
+    {"focused", OX_SESSION_STATE_FOCUSED},
+    {"stopping", OX_SESSION_STATE_STOPPING},
+    {"exiting", OX_SESSION_STATE_EXITING},
+};
+
+// Events that must happen before others at the same time: switch profiles before touching the
+// new devices, and hold at a wait before anything scheduled right after it.
+int SortRank(ScenarioEvent::Type type) {
+    switch (type) {
+        case ScenarioEvent::Type::kSwitchProfile:
+            return 0;
+        case ScenarioEvent::Type::kWaitSession:
+        case ScenarioEvent::Type::kWaitFrames:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+class Compiler {
+   public:
+    Compiler(const DeviceProfile* profile, Scenario* out, std::string* error)
+        : initial_profile_(profile), out_(out), error_(error) {}
+
+    bool Compile(const rvalue& root) {
+        if (root.t() != type::Object) return Fail("scenario", "expected an object");
+
+        if (root.has("clock")) {
+            const rvalue& clock = root["clock"];
+            if (clock.t() != type::String) return Fail("clock", "expected \"predicted_time\" or \"frames\"");
+            const std::string name = clock.s();
+            if (name == "frames") {
+                out_->clock = Scenario::Clock::kFrames;
+            } else if (name != "predicted_time") {
+                return Fail("clock", "expected \"predicted_time\" or \"frames\"");
+            }
+        }
+        if (out_->clock == Scenario::Clock::kFrames) {
+            double frame_rate = 90.0;
+            if (root.has("frame_rate") && (!ReadNumber(root["frame_rate"], &frame_rate) || frame_rate <= 0.0)) {
+                return Fail("frame_rate", "expected a positive number");
+            }
+            out_->frame_step_ns = static_cast<int64_t>(std::llround(1e9 / frame_rate));
+        }
+
+        const rvalue* events = nullptr;
+        const rvalue* tracks = nullptr;
+        if (root.has("events")) {
+            events = &root["events"];
+            if (events->t() != type::List) return Fail("events", "expected a list");
+        }
+        if (root.has("tracks")) {
+            tracks = &root["tracks"];
+            if (tracks->t() != type::List) return Fail("tracks", "expected a list");
+        }
+
+        // Profile switches first: they decide which paths are valid when.
+        if (events) {
+            for (size_t i = 0; i < events->size(); i++) {
+                if (!CompileProfileSwitch((*events)[i], "events[" + std::to_string(i) + "]")) return false;
+            }
+            std::stable_sort(profile_switches_.begin(), profile_switches_.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (size_t i = 0; i < events->size(); i++) {
+                if (!CompileEvent((*events)[i], "events[" + std::to_string(i) + "]")) return false;
+            }
+        }
+        if (tracks) {
+            for (size_t i = 0; i < tracks->size(); i++) {
+                if (!CompileTrack((*tracks)[i], "tracks[" + std::to_string(i) + "]")) return false;
+            }
+        }
+
+        std::stable_sort(out_->events.begin(), out_->events.end(), [](const ScenarioEvent& a, const ScenarioEvent& b) {
+            if (a.time_ns != b.time_ns) return a.time_ns < b.time_ns;
+            return SortRank(a.type) < SortRank(b.type);
+        });
+        for (const ScenarioEvent& event : out_->events) {
+            out_->duration_ns = std::max(out_->duration_ns, std::max(event.time_ns, event.end_ns));
+        }
+        return true;
+    }
+
+   private:
+    bool Fail(const std::string& where, const std::string& message) {
+        *error_ = where + ": " + message;
+        return false;
+    }
+
+    static bool ReadNumber(const rvalue& value, double* out) {
+        if (value.t() != type::Number) return false;
+        *out = value.d();
+        return std::isfinite(*out);
+    }
+
+    bool ReadTime(const rvalue& obj, const std::string& where, int64_t* out) {
+        double seconds = 0.0;
+        if (!obj.has("t") || !ReadNumber(obj["t"], &seconds) || seconds < 0.0) {
+            return Fail(where, "missing or invalid t (seconds >= 0)");
+        }
+        *out = static_cast<int64_t>(std::llround(seconds * 1e9));
+        return true;
+    }
+
+    bool ReadPose(const rvalue& obj, const std::string& where, OxPose* pose, bool* active) {
+        static const char* const kPositionKeys[] = {"x", "y", "z"};
+        static const char* const kOrientationKeys[] = {"x", "y", "z", "w"};
+        if (!obj.has("position") || !obj.has("orientation")) {
+            return Fail(where, "missing required fields: position{x,y,z}, orientation{x,y,z,w}");
+        }
+        double v[7];
+        for (int i = 0; i < 3; i++) {
+            if (!obj["position"].has(kPositionKeys[i]) || !ReadNumber(obj["position"][kPositionKeys[i]], &v[i])) {
+                return Fail(where, "invalid position{x,y,z}");
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            if (!obj["orientation"].has(kOrientationKeys[i]) ||
+                !ReadNumber(obj["orientation"][kOrientationKeys[i]], &v[3 + i])) {
+                return Fail(where, "invalid orientation{x,y,z,w}");
+            }
+        }
+        pose->position = {static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2])};
+        pose->orientation = {static_cast<float>(v[3]), static_cast<float>(v[4]), static_cast<float>(v[5]),
+                             static_cast<float>(v[6])};
+
+        *active = true;
+        if (obj.has("active")) {
+            if (obj["active"].t() != type::True && obj["active"].t() != type::False) {
+                return Fail(where, "invalid value for active (boolean)");
+            }
+            *active = obj["active"].b();
+        }
+        return true;
+    }
+
+    // Same conversions as PUT /v1/inputs.
+    bool ReadInputValue(const rvalue& obj, ComponentType component_type, const std::string& where, InputValue* out) {
+        if (component_type == ComponentType::VEC2) {
+            double x = 0.0, y = 0.0;
+            const rvalue* v = obj.has("value") ? &obj["value"] : &obj;
+            if (!v->has("x") || !v->has("y") || !ReadNumber((*v)["x"], &x) || !ReadNumber((*v)["y"], &y)) {
+                return Fail(where, "missing or invalid x,y for vec2 component");
+            }
+            *out = OxVector2f{static_cast<float>(x), static_cast<float>(y)};
+            return true;
+        }
+
+        if (!obj.has("value")) return Fail(where, "missing required field: value");
+        const rvalue& value = obj["value"];
+        double number = 0.0;
+        if (value.t() == type::True || value.t() == type::False) {
+            number = value.b() ? 1.0 : 0.0;
+        } else if (!ReadNumber(value, &number)) {
+            return Fail(where, "invalid value");
+        }
+        if (component_type == ComponentType::BOOLEAN) {
+            *out = number >= 0.5;
+        } else {
+            *out = static_cast<float>(number);
+        }
+        return true;
+    }
+
+    const DeviceProfile* ProfileAt(int64_t time_ns) const {
+        const DeviceProfile* profile = initial_profile_;
+        for (const auto& [switch_time, switch_profile] : profile_switches_) {
+            if (switch_time > time_ns) break;
+            profile = switch_profile;
+        }
+        return profile;
+    }
+
+    static std::string WithLeadingSlash(const std::string& path) {
+        return !path.empty() && path[0] == '/' ? path : "/" + path;
+    }
+
+    // Resolve a device ("/user/head") or input binding ("/user/hand/right/input/trigger/value")
+    // against the profile in effect at `time_ns` and return its index in out_->targets.
+    bool ResolveTarget(const rvalue& path_value, bool is_input, int64_t time_ns, const std::string& where,
+                       uint32_t* index) {
+        if (path_value.t() != type::String) return Fail(where, is_input ? "invalid input path" : "invalid device path");
+        const std::string path = WithLeadingSlash(path_value.s());
+
+        ScenarioTarget target;
+        if (is_input) {
+            const size_t pos = path.find("/input/");
+            if (pos == std::string::npos) return Fail(where, "invalid binding path " + path);
+            target.user_path = path.substr(0, pos);
+            target.component_path = path.substr(pos);
+        } else {
+            target.user_path = path;
+        }
+
+        const DeviceProfile* profile = ProfileAt(time_ns);
+        const DeviceDef* device_def = nullptr;
+        for (const DeviceDef& dev : profile->devices) {
+            if (target.user_path == dev.user_path) device_def = &dev;
+        }
+        if (!device_def) return Fail(where, "device " + target.user_path + " not in profile " + profile->name);
+        if (is_input) {
+            const ComponentDef* component = nullptr;
+            for (const ComponentDef& comp : device_def->components) {
+                if (target.component_path == comp.path) component = &comp;
+            }
+            if (!component) return Fail(where, "component " + path + " not in profile " + profile->name);
+            target.type = component->type;
+        }
+
+        // Keyed by path and type: the same path may change type across a profile switch.
+        const std::string key = path + '#' + std::to_string(static_cast<int>(target.type));
+        auto it = target_indices_.find(key);
+        if (it == target_indices_.end()) {
+            it = target_indices_.emplace(key, static_cast<uint32_t>(out_->targets.size())).first;
+            out_->targets.push_back(std::move(target));
+        }
+        *index = it->second;
+        return true;
+    }
+
+    ScenarioEvent& AddEvent(ScenarioEvent::Type event_type, int64_t time_ns) {
+        ScenarioEvent event{};
+        event.type = event_type;
+        event.time_ns = time_ns;
+        event.end_ns = time_ns;
+        out_->events.push_back(event);
+        return out_->events.back();
+    }
+
+    bool CompileProfileSwitch(const rvalue& obj, const std::string& where) {
+        if (obj.t() != type::Object) return Fail(where, "expected an object");
+        if (!obj.has("profile")) return true;
+
+        int64_t time_ns = 0;
+        if (!ReadTime(obj, where, &time_ns)) return false;
+        if (obj["profile"].t() != type::String) return Fail(where, "invalid profile (string)");
+        const std::string name = obj["profile"].s();
+        const DeviceProfile* profile = GetDeviceProfileByName(name);
+        if (!profile) return Fail(where, "unknown device: " + name);
+
+        profile_switches_.emplace_back(time_ns, profile);
+        AddEvent(ScenarioEvent::Type::kSwitchProfile, time_ns).profile = profile;
+        return true;
+    }
+
+    bool CompileEvent(const rvalue& obj, const std::string& where) {
+        if (obj.has("profile")) return true;  // done by CompileProfileSwitch()
+
+        int64_t time_ns = 0;
+        if (!ReadTime(obj, where, &time_ns)) return false;
+
+        if (obj.has("wait_session")) {
+            const rvalue& state = obj["wait_session"];
+            const SessionStateEntry* entry = nullptr;
+            if (state.t() == type::String) {
+                const std::string name = state.s();
+                for (const SessionStateEntry& e : kSessionStates) {
+                    if (name == e.name) entry = &e;
+                }
+            }
+            if (!entry) return Fail(where, "invalid wait_session (e.g. \"focused\")");
+
+            double timeout = 0.0;
+            if (obj.has("timeout") && (!ReadNumber(obj["timeout"], &timeout) || timeout < 0.0)) {
+                return Fail(where, "invalid timeout (seconds >= 0)");
+            }
+            ScenarioEvent& event = AddEvent(ScenarioEvent::Type::kWaitSession, time_ns);
+            event.session_state = static_cast<uint32_t>(entry->state);
+            event.timeout_ns = static_cast<int64_t>(std::llround(timeout * 1e9));
+            return true;
+        }
+
+        if (obj.has("wait_frames")) {
+            double frames = 0.0;
+            if (!ReadNumber(obj["wait_frames"], &frames) || frames < 0.0) {
+                return Fail(where, "invalid wait_frames (count >= 0)");
+            }
+            AddEvent(ScenarioEvent::Type::kWaitFrames, time_ns).frames = static_cast<uint64_t>(frames);
+            return true;
+        }
+
+        if (obj.has("device")) {
+            uint32_t target = 0;
+            OxPose pose;
+            bool active = true;
+            if (!ResolveTarget(obj["device"], false, time_ns, where, &target) ||
+                !ReadPose(obj, where, &pose, &active)) {
+                return false;
+            }
+            ScenarioEvent& event = AddEvent(ScenarioEvent::Type::kSetPose, time_ns);
+            event.target = target;
+            event.pose = pose;
+            event.active = active;
+            return true;
+        }
+
+        if (obj.has("input")) {
+            uint32_t target = 0;
+            InputValue value;
+            if (!ResolveTarget(obj["input"], true, time_ns, where, &target) ||
+                !ReadInputValue(obj, out_->targets[target].type, where, &value)) {
+                return false;
+            }
+            ScenarioEvent& event = AddEvent(ScenarioEvent::Type::kSetInput, time_ns);
+            event.target = target;
+            event.value = value;
+            return true;
+        }
+
+        return Fail(where, "expected one of profile, wait_session, wait_frames, device, input");
+    }
+
+    bool CompileTrack(const rvalue& obj, const std::string& where) {
+        if (obj.t() != type::Object) return Fail(where, "expected an object");
+        if (!obj.has("keyframes") || obj["keyframes"].t() != type::List || obj["keyframes"].size() == 0) {
+            return Fail(where, "missing or empty keyframes");
+        }
+        const rvalue& list = obj["keyframes"];
+
+        struct Keyframe {
+            int64_t time_ns;
+            OxPose pose;
+            bool active;
+            InputValue value;
+        };
+        std::vector<int64_t> times(list.size());
+        for (size_t i = 0; i < list.size(); i++) {
+            if (!ReadTime(list[i], where + ".keyframes[" + std::to_string(i) + "]", &times[i])) return false;
+        }
+        std::vector<size_t> order(list.size());  // keyframe indices by time
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return times[a] < times[b]; });
+
+        const bool is_input = obj.has("input");
+        if (!is_input && !obj.has("device")) return Fail(where, "expected device or input");
+        uint32_t target = 0;
+        if (!ResolveTarget(is_input ? obj["input"] : obj["device"], is_input, times[order.front()], where, &target)) {
+            return false;
+        }
+        const ComponentType component_type = out_->targets[target].type;
+
+        bool step = !is_input ? false : component_type == ComponentType::BOOLEAN;
+        if (obj.has("interpolation")) {
+            const std::string interpolation =
+                obj["interpolation"].t() == type::String ? std::string(obj["interpolation"].s()) : "";
+            if (interpolation == "step") {
+                step = true;
+            } else if (interpolation != "linear") {
+                return Fail(where, "invalid interpolation (\"linear\" or \"step\")");
+            }
+        }
+
+        std::vector<Keyframe> keyframes(order.size());
+        for (size_t k = 0; k < order.size(); k++) {
+            const std::string key_where = where + ".keyframes[" + std::to_string(order[k]) + "]";
+            const rvalue& key = list[order[k]];
+            keyframes[k].time_ns = times[order[k]];
+            if (is_input ? !ReadInputValue(key, component_type, key_where, &keyframes[k].value)
+                         : !ReadPose(key, key_where, &keyframes[k].pose, &keyframes[k].active)) {
+                return false;
+            }
+        }
+
+        if (step || keyframes.size() == 1) {
+            for (const Keyframe& key : keyframes) {
+                ScenarioEvent& event =
+                    AddEvent(is_input ? ScenarioEvent::Type::kSetInput : ScenarioEvent::Type::kSetPose, key.time_ns);
+                event.target = target;
+                event.pose = key.pose;
+                event.active = key.active;
+                event.value = key.value;
+            }
+            return true;
+        }
+
+        for (size_t k = 0; k + 1 < keyframes.size(); k++) {
+            const Keyframe& from = keyframes[k];
+            const Keyframe& to = keyframes[k + 1];
+            ScenarioEvent& event = AddEvent(
+                is_input ? ScenarioEvent::Type::kInputSegment : ScenarioEvent::Type::kPoseSegment, from.time_ns);
+            event.end_ns = to.time_ns;
+            event.target = target;
+            event.pose = from.pose;
+            event.pose_end = to.pose;
+            event.active = from.active;
+            event.active_end = to.active;
+            event.value = from.value;
+            event.value_end = to.value;
+        }
+        return true;
+    }
+
+    const DeviceProfile* initial_profile_;
+    Scenario* out_;
+    std::string* error_;
+    std::vector<std::pair<int64_t, const DeviceProfile*>> profile_switches_;
+    std::map<std::string, uint32_t> target_indices_;
+};
+
+}  // namespace
+
+bool CompileScenario(const std::string& json_text, const DeviceProfile* profile, Scenario* out, std::string* error) {
+    if (!profile) {
+        *error = "no device profile loaded";
+        return false;
+    }
+    const rvalue root = crow::json::load(json_text);
+    if (!root) {
+        *error = "invalid JSON";
+        return false;
+    }
+
+    Scenario scenario;
+    try {
+        if (!Compiler(profile, &scenario, error).Compile(root)) return false;
+    } catch (const std::exception& e) {
+        // crow::json throws on type mismatches the checks above didn't anticipate
+        *error = std::string("invalid scenario: ") + e.what();
+        return false;
+    }
+    *out = std::move(scenario);
+    return true;
+}
+
+}  // namespace ox_sim
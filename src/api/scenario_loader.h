@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "device_profiles.h"
+#include "scenario.h"
+
+namespace ox_sim {
+
+// Compile a JSON scenario into a flat, time-sorted Scenario. `profile` is the profile active when
+// the scenario starts; pose and input paths are checked against the profile in effect at their
+// time. Returns false with a message naming the offending entry in *error.
+//
+// {
+//   "clock": "predicted_time" | "frames",   // optional, default "predicted_time"
+//   "frame_rate": 90,                        // "frames" clock: scenario seconds per frame = 1 / frame_rate
+//   "tracks": [                              // keyframed poses and inputs, times in seconds
+//     {"device": "/user/hand/right",
+//      "keyframes": [{"t": 0, "position": {x,y,z}, "orientation": {x,y,z,w}, "active": true}, ...]},
+//     {"input": "/user/hand/right/input/trigger/value", "interpolation": "linear" | "step",
+//      "keyframes": [{"t": 0, "value": 0.0}, {"t": 1, "value": 1.0}]}
+//   ],
+//   "events": [                              // one-shot events, one kind per entry
+//     {"t": 0, "profile": "valve_index"},
+//     {"t": 0, "wait_session": "focused", "timeout": 10},
+//     {"t": 2, "wait_frames": 30},
+//     {"t": 1, "device": "/user/head", "position": {x,y,z}, "orientation": {x,y,z,w}},
+//     {"t": 1, "input": "/user/hand/right/input/a/click", "value": true}
+//   ]
+// }
+//
+// Input values are numbers or booleans for BOOLEAN and FLOAT components and {x,y} for VEC2.
+// BOOLEAN tracks always step.
+bool CompileScenario(const std::string& json_text, const DeviceProfile* profile, Scenario* out, std::string* error);
+
+}  // namespace ox_sim
@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <memory>
 #include <vector>
 
@@ -220,6 +221,10 @@ namespace crow
         /// Call the after handle middleware and send the write the response to the connection.
         void complete_request()
         {
+            // Asynchronous handlers end the response after handle() has returned, when the only
+            // reference to this connection is the one captured by complete_request_handler_, which
+            // prepare_buffers() resets.
+            auto self = this->shared_from_this();
             CROW_LOG_INFO << "Response: " << this << ' ' << req_.raw_url << ' ' << res.code << ' ' << close_connection_;
             res.is_alive_helper_ = nullptr;
 
@@ -328,10 +333,23 @@ namespace crow
         void do_write_general()
         {
             error_code ec;
-            if (res.body.length() < res_stream_threshold_)
+            if (res.has_chunked_body())
+            {
+                do_write_chunked();
+            }
+            else if (res.has_shared_body() || res.body.length() < res_stream_threshold_)
             {
-                res_body_copy_.swap(res.body);
-                buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                // A shared body goes out with the headers in one gather write and is released by the
+                // res.clear() in do_write_sync() once the write has finished.
+                if (res.has_shared_body())
+                {
+                    buffers_.emplace_back(res.shared_body_);
+                }
+                else
+                {
+                    res_body_copy_.swap(res.body);
+                    buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                }
 
                 ec = do_write_sync(buffers_);
                 if (ec) {
@@ -382,6 +400,92 @@ namespace crow
             }
         }
 
+        /// Writes a chunked body without ever blocking this thread: the headers and every chunk go out
+        /// with async_write, and the source is only asked for the next chunk once the previous write has
+        /// finished, so at most one chunk per connection is buffered here. Reading stays paused until
+        /// the terminating chunk is written (see do_read()).
+        void do_write_chunked()
+        {
+            streaming_ = true;
+            auto self = this->shared_from_this();
+            asio::async_write(
+              adaptor_.socket(), buffers_,
+              [self](const error_code& ec, std::size_t /*bytes_transferred*/) {
+                  self->buffers_.clear();
+                  if (ec)
+                      self->finish_chunked(ec);
+                  else
+                      self->request_chunk();
+              });
+        }
+
+        void request_chunk()
+        {
+            // The callback keeps the connection alive until the source answers; the source in turn is
+            // owned by res, so it must answer (or be dropped by a failed write) for the connection to go.
+            auto self = this->shared_from_this();
+            res.body_source_([self](std::string chunk, bool more) {
+                asio::post(self->adaptor_.get_io_context(), [self, chunk = std::move(chunk), more]() mutable {
+                    self->write_chunk(std::move(chunk), more);
+                });
+            });
+        }
+
+        void write_chunk(std::string chunk, bool more)
+        {
+            static const std::string last_chunk = "0\r\n\r\n";
+            if (chunk.empty() && more)
+            {
+                request_chunk();
+                return;
+            }
+            chunk_ = std::move(chunk);
+            if (!chunk_.empty())
+            {
+                int size_length = snprintf(chunk_size_line_, sizeof(chunk_size_line_), "%zx\r\n", chunk_.size());
+                buffers_.emplace_back(chunk_size_line_, size_length);
+                buffers_.emplace_back(chunk_.data(), chunk_.size());
+                buffers_.emplace_back(crlf.data(), crlf.size());
+            }
+            if (!more)
+                buffers_.emplace_back(last_chunk.data(), last_chunk.size());
+
+            auto self = this->shared_from_this();
+            asio::async_write(
+              adaptor_.socket(), buffers_,
+              [self, more](const error_code& ec, std::size_t /*bytes_transferred*/) {
+                  self->buffers_.clear();
+                  self->chunk_.clear();
+                  if (ec || !more)
+                      self->finish_chunked(ec);
+                  else
+                      self->request_chunk();
+              });
+        }
+
+        void finish_chunked(const error_code& ec)
+        {
+            streaming_ = false;
+            res.clear();
+            parser_.clear();
+            if (ec || close_connection_)
+            {
+                // A body cut short cannot be resumed, so the connection goes with it.
+                if (ec)
+                    CROW_LOG_ERROR << ec << " - buffer write error happened while sending chunked response. Writing stopped premature.";
+                adaptor_.shutdown_readwrite();
+                adaptor_.close();
+                CROW_LOG_DEBUG << this << " from write (chunked)";
+                return;
+            }
+            if (need_to_start_read_after_complete_)
+            {
+                need_to_start_read_after_complete_ = false;
+                start_deadline();
+                do_read();
+            }
+        }
+
         void do_read()
         {
             auto self = this->shared_from_this();
@@ -412,7 +516,7 @@ namespace crow
                       self->parser_.done();
                       // adaptor will close after write
                   }
-                  else if (!self->need_to_call_after_handlers_)
+                  else if (!self->need_to_call_after_handlers_ && !self->streaming_)
                   {
                       self->start_deadline();
                       self->do_read();
@@ -523,6 +627,8 @@ namespace crow
         std::string content_length_;
         std::string date_str_;
         std::string res_body_copy_;
+        std::string chunk_;
+        char chunk_size_line_[24];
 
         detail::task_timer::identifier_type task_id_{};
 
@@ -530,6 +636,7 @@ namespace crow
         bool need_to_call_after_handlers_{};
         bool need_to_start_read_after_complete_{};
         bool add_keep_alive_{};
+        bool streaming_{};
 
         std::tuple<Middlewares...>* middlewares_;
         detail::context<Middlewares...> ctx_;
@@ -1,4 +1,6 @@
 #pragma once
+#include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <ios>
@@ -175,6 +177,9 @@ namespace crow
         response& operator=(response&& r) noexcept
         {
             body = std::move(r.body);
+            shared_body_owner_ = std::move(r.shared_body_owner_);
+            shared_body_ = r.shared_body_;
+            body_source_ = std::move(r.body_source_);
             code = r.code;
             headers = std::move(r.headers);
             completed_ = r.completed_;
@@ -191,6 +196,9 @@ namespace crow
         void clear()
         {
             body.clear();
+            shared_body_owner_.reset();
+            shared_body_ = asio::const_buffer();
+            body_source_ = nullptr;
             code = 200;
             headers.clear();
             completed_ = false;
@@ -250,13 +258,22 @@ namespace crow
                 completed_ = true;
                 if (skip_body)
                 {
-                    set_header("Content-Length", std::to_string(body.size()));
+                    if (has_chunked_body())
+                        set_header("Transfer-Encoding", "chunked");
+                    else
+                        set_header("Content-Length", std::to_string(body_size()));
                     body = "";
+                    shared_body_owner_.reset();
+                    shared_body_ = asio::const_buffer();
+                    body_source_ = nullptr;
                     manual_length_header = true;
                 }
                 if (complete_request_handler_)
                 {
-                    complete_request_handler_();
+                    // The handler holds a reference to the connection that owns this response, which may be
+                    // the last one once the connection has reset it; keep it until this function is done.
+                    auto complete = complete_request_handler_;
+                    complete();
                     manual_length_header = false;
                     skip_body = false;
                 }
@@ -270,6 +287,49 @@ namespace crow
             end();
         }
 
+        /// Send `size` bytes at `data` as the body instead of `body`, without copying them. `owner` keeps
+        /// the bytes alive until the response has been written; the connection sends them in the same
+        /// gather write as the headers.
+        void set_shared_body(std::shared_ptr<const void> owner, const void* data, size_t size)
+        {
+            body.clear();
+            shared_body_owner_ = std::move(owner);
+            shared_body_ = asio::const_buffer(data, size);
+        }
+
+        bool has_shared_body() const noexcept
+        {
+            return shared_body_owner_ != nullptr;
+        }
+
+        /// Hands the next piece of a chunked body to the connection: `chunk` is sent as one chunk (an
+        /// empty one is skipped) and `more` says whether the source is asked again. Callable from any
+        /// thread; the write itself is posted to the connection's io_context.
+        using chunk_callback = std::function<void(std::string chunk, bool more)>;
+
+        /// Send the body with chunked transfer encoding instead of `body`, so the client receives the
+        /// start of the body while the rest is still being generated. The connection calls `source` on
+        /// its own thread after writing the headers and again after each chunk has been written, and the
+        /// source answers each call exactly once through the callback, from whichever thread produced
+        /// the chunk; it must not block. The source is destroyed when the response is done, early if
+        /// the write fails.
+        void set_chunked_body(std::function<void(chunk_callback next)> source)
+        {
+            body.clear();
+            body_source_ = std::move(source);
+        }
+
+        bool has_chunked_body() const noexcept
+        {
+            return body_source_ != nullptr;
+        }
+
+        /// Size of the body that will be sent, shared or not.
+        size_t body_size() const noexcept
+        {
+            return has_shared_body() ? shared_body_.size() : body.size();
+        }
+
         /// Check if the connection is still alive (usually by checking the socket status).
         bool is_alive()
         {
@@ -402,7 +462,7 @@ namespace crow
             auto& status = statusCodes.find(code)->second;
             buffers.emplace_back(status.data(), status.size());
 
-            if (code >= 400 && body.empty())
+            if (code >= 400 && body_size() == 0)
                 body = statusCodes[code].substr(9);
 
             for (auto& kv : headers)
@@ -413,9 +473,15 @@ namespace crow
                 buffers.emplace_back(crlf.data(), crlf.size());
             }
 
-            if (!manual_length_header && !headers.count("content-length"))
+            if (has_chunked_body())
+            {
+                static std::string transfer_encoding_tag = "Transfer-Encoding: chunked";
+                buffers.emplace_back(transfer_encoding_tag.data(), transfer_encoding_tag.size());
+                buffers.emplace_back(crlf.data(), crlf.size());
+            }
+            else if (!manual_length_header && !headers.count("content-length"))
             {
-                content_length_buffer = std::to_string(body.size());
+                content_length_buffer = std::to_string(body_size());
                 static std::string content_length_tag = "Content-Length: ";
                 buffers.emplace_back(content_length_tag.data(), content_length_tag.size());
                 buffers.emplace_back(content_length_buffer.data(), content_length_buffer.size());
@@ -447,6 +513,9 @@ namespace crow
         }
 
         bool completed_{};
+        std::shared_ptr<const void> shared_body_owner_;
+        asio::const_buffer shared_body_;
+        std::function<void(chunk_callback)> body_source_;
         std::function<void()> complete_request_handler_;
         std::function<bool()> is_alive_helper_;
         static_file_info file_info;
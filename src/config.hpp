@@ -2,11 +2,13 @@
 
 #include <filesystem>
 #include <fstream>
-#include <iostream>
 #include <sstream>
 #include <string>
 
 #include "crow/json.h"
+#include "log.h"
+#include "simulator_core.h"
+#include "thread_placement.h"
 
 #ifdef _WIN32
 #define NOMINMAX
@@ -21,6 +23,28 @@ struct SimulatorConfig {
     bool headless = false;
     bool api = true;
     int api_port = 8765;
+    bool lock_profiling = false;     // per-call-site lock statistics (GET /v1/locks)
+    std::string log_level = "info";  // debug, info, warn, error, off
+    std::string log_file;            // empty/"stdout", "stderr", or a file path (relative to the driver folder)
+    bool preview_downsample = true;  // GUI: downsample eye previews to their on-screen size before upload
+    int preview_fps = 30;            // GUI: eye preview refresh limit, 0 = every app frame
+    // Input latching per component type: "latch" holds every change until a frame samples it,
+    // "level" shows whatever value is current when the frame samples
+    std::string input_latch_boolean = "latch";
+    std::string input_latch_float = "level";
+    std::string input_latch_vec2 = "level";
+    bool frame_commit = false;  // publish API/GUI writes together at the next frame boundary
+    // Flight recorder: keep the last submitted frames in memory for POST /v1/recorder/dump
+    bool flight_recorder = false;
+    int flight_recorder_mb = 64;                     // memory budget for both eyes
+    int flight_recorder_width = 480;                 // downsample wider frames, 0 = full size
+    int flight_recorder_decimation = 1;              // record every Nth frame
+    std::string flight_recorder_dir = "recordings";  // dump directory (relative to the driver folder)
+    // Frame monitor: black, frozen and left/right mismatch detection on submitted frames (GET /v1/monitor)
+    bool frame_monitor = false;
+    int task_pool_workers = 2;  // threads for background work (view encoding, frame monitor, flight recorder)
+    // CPU affinity, scheduling and names per thread class ("threads": {"http": {...}, ...}), indexed by ThreadClass
+    ox_sim::ThreadPlacement threads[ox_sim::kThreadClassCount];
 };
 
 // Global simulator state (defined in driver.cpp)
@@ -30,8 +54,8 @@ extern SimulatorConfig g_config;
 inline bool LoadConfig(const std::string& config_path) {
     std::ifstream file(config_path);
     if (!file.is_open()) {
-        std::cout << "Config file not found at: " << config_path << std::endl;
-        std::cout << "Using defaults: device=oculus_quest_2, headless=false, api=true, port=8765" << std::endl;
+        OX_LOG_INFO("Config file not found at: %s", config_path.c_str());
+        OX_LOG_INFO("Using defaults: device=oculus_quest_2, headless=false, api=true, port=8765");
         return false;
     }
 
@@ -44,8 +68,8 @@ inline bool LoadConfig(const std::string& config_path) {
     // Parse JSON using CROW
     auto json = crow::json::load(config_str);
     if (!json) {
-        std::cerr << "ERROR: Invalid JSON in config file: " << config_path << std::endl;
-        std::cerr << "Using default configuration" << std::endl;
+        OX_LOG_ERROR("Invalid JSON in config file: %s", config_path.c_str());
+        OX_LOG_ERROR("Using default configuration");
         return false;
     }
 
@@ -71,13 +95,130 @@ inline bool LoadConfig(const std::string& config_path) {
         g_config.api_port = static_cast<int>(json["api_port"].d());
         // Validate port range
         if (g_config.api_port < 1024 || g_config.api_port > 65535) {
-            std::cerr << "WARNING: Invalid port " << g_config.api_port << ", using default 8765" << std::endl;
+            OX_LOG_WARN("Invalid port %d, using default 8765", g_config.api_port);
             g_config.api_port = 8765;
         }
     }
 
-    std::cout << "Loaded config: device=" << g_config.device << ", headless=" << (g_config.headless ? "true" : "false")
-              << ", api=" << (g_config.api ? "true" : "false") << ", port=" << g_config.api_port << std::endl;
+    if (json.has("lock_profiling") && json["lock_profiling"].t() == crow::json::type::True) {
+        g_config.lock_profiling = true;
+    } else if (json.has("lock_profiling") && json["lock_profiling"].t() == crow::json::type::False) {
+        g_config.lock_profiling = false;
+    }
+
+    if (json.has("frame_commit") && json["frame_commit"].t() == crow::json::type::True) {
+        g_config.frame_commit = true;
+    } else if (json.has("frame_commit") && json["frame_commit"].t() == crow::json::type::False) {
+        g_config.frame_commit = false;
+    }
+
+    if (json.has("frame_monitor") && json["frame_monitor"].t() == crow::json::type::True) {
+        g_config.frame_monitor = true;
+    } else if (json.has("frame_monitor") && json["frame_monitor"].t() == crow::json::type::False) {
+        g_config.frame_monitor = false;
+    }
+
+    if (json.has("flight_recorder") && json["flight_recorder"].t() == crow::json::type::True) {
+        g_config.flight_recorder = true;
+    } else if (json.has("flight_recorder") && json["flight_recorder"].t() == crow::json::type::False) {
+        g_config.flight_recorder = false;
+    }
+
+    struct IntKey {
+        const char* key;
+        int* value;
+        int min;
+        int max;
+    };
+    const IntKey int_keys[] = {{"flight_recorder_mb", &g_config.flight_recorder_mb, 1, 4096},
+                               {"flight_recorder_width", &g_config.flight_recorder_width, 0, 16384},
+                               {"flight_recorder_decimation", &g_config.flight_recorder_decimation, 1, 1000},
+                               {"task_pool_workers", &g_config.task_pool_workers, 1, 64}};
+    for (const IntKey& key : int_keys) {
+        if (!json.has(key.key) || json[key.key].t() != crow::json::type::Number) continue;
+        const double value = json[key.key].d();
+        if (value >= key.min && value <= key.max) {
+            *key.value = static_cast<int>(value);
+        } else {
+            OX_LOG_WARN("Invalid %s %g, using %d", key.key, value, *key.value);
+        }
+    }
+
+    if (json.has("flight_recorder_dir") && json["flight_recorder_dir"].t() == crow::json::type::String) {
+        g_config.flight_recorder_dir = json["flight_recorder_dir"].s();
+    }
+
+    if (json.has("threads") && json["threads"].t() == crow::json::type::Object) {
+        const auto& threads = json["threads"];
+        for (int i = 0; i < ox_sim::kThreadClassCount; i++) {
+            const char* class_name = ox_sim::ThreadClassName(static_cast<ox_sim::ThreadClass>(i));
+            if (!threads.has(class_name) || threads[class_name].t() != crow::json::type::Object) continue;
+            const auto& entry = threads[class_name];
+            ox_sim::ThreadPlacement placement;
+            if (entry.has("name") && entry["name"].t() == crow::json::type::String) placement.name = entry["name"].s();
+            if (entry.has("cpus") && entry["cpus"].t() == crow::json::type::String) placement.cpus = entry["cpus"].s();
+            if (entry.has("policy") && entry["policy"].t() == crow::json::type::String) {
+                placement.policy = entry["policy"].s();
+            }
+            if (entry.has("priority") && entry["priority"].t() == crow::json::type::Number) {
+                placement.priority = static_cast<int>(entry["priority"].d());
+            }
+            if (entry.has("nice") && entry["nice"].t() == crow::json::type::Number) {
+                placement.has_nice = true;
+                placement.nice = static_cast<int>(entry["nice"].d());
+            }
+            std::string error;
+            if (ox_sim::ValidateThreadPlacement(placement, &error)) {
+                g_config.threads[i] = placement;
+            } else {
+                OX_LOG_WARN("Invalid threads.%s (%s), using defaults", class_name, error.c_str());
+            }
+        }
+    }
+
+    if (json.has("preview_downsample") && json["preview_downsample"].t() == crow::json::type::True) {
+        g_config.preview_downsample = true;
+    } else if (json.has("preview_downsample") && json["preview_downsample"].t() == crow::json::type::False) {
+        g_config.preview_downsample = false;
+    }
+
+    if (json.has("preview_fps") && json["preview_fps"].t() == crow::json::type::Number) {
+        g_config.preview_fps = static_cast<int>(json["preview_fps"].d());
+        if (g_config.preview_fps < 0 || g_config.preview_fps > 240) {
+            OX_LOG_WARN("Invalid preview_fps %d, using default 30", g_config.preview_fps);
+            g_config.preview_fps = 30;
+        }
+    }
+
+    if (json.has("log_level") && json["log_level"].t() == crow::json::type::String) {
+        ox_sim::logging::LogLevel level;
+        if (ox_sim::logging::ParseLevel(json["log_level"].s(), &level)) {
+            g_config.log_level = json["log_level"].s();
+        } else {
+            OX_LOG_WARN("Invalid log_level \"%s\", using \"%s\"", std::string(json["log_level"].s()).c_str(),
+                        g_config.log_level.c_str());
+        }
+    }
+
+    if (json.has("log_file") && json["log_file"].t() == crow::json::type::String) {
+        g_config.log_file = json["log_file"].s();
+    }
+
+    const std::pair<const char*, std::string*> latch_keys[] = {{"input_latch_boolean", &g_config.input_latch_boolean},
+                                                               {"input_latch_float", &g_config.input_latch_float},
+                                                               {"input_latch_vec2", &g_config.input_latch_vec2}};
+    for (const auto& [key, value] : latch_keys) {
+        if (!json.has(key) || json[key].t() != crow::json::type::String) continue;
+        ox_sim::InputLatchPolicy policy;
+        if (ox_sim::ParseInputLatchPolicy(json[key].s(), &policy)) {
+            *value = json[key].s();
+        } else {
+            OX_LOG_WARN("Invalid %s \"%s\", using \"%s\"", key, std::string(json[key].s()).c_str(), value->c_str());
+        }
+    }
+
+    OX_LOG_INFO("Loaded config: device=%s, headless=%s, api=%s, port=%d", g_config.device.c_str(),
+                g_config.headless ? "true" : "false", g_config.api ? "true" : "false", g_config.api_port);
 
     return true;
 }
@@ -102,22 +243,78 @@ inline std::filesystem::path get_module_path() {
 // Get the config file path (same directory as driver)
 inline std::string GetConfigPath() { return (get_module_path() / "config.json").string(); }
 
+// Apply g_config.log_level / log_file to the logger. Relative log file paths are resolved against
+// the driver folder, like config.json.
+inline void ConfigureLogging() {
+    ox_sim::logging::LogLevel level = ox_sim::logging::LogLevel::INFO;
+    ox_sim::logging::ParseLevel(g_config.log_level, &level);
+
+    std::string destination = g_config.log_file;
+    if (!destination.empty() && destination != "stdout" && destination != "stderr" &&
+        std::filesystem::path(destination).is_relative()) {
+        destination = (get_module_path() / destination).string();
+    }
+    ox_sim::logging::Configure(level, destination);
+}
+
+// Resolve g_config.flight_recorder_dir against the driver folder, like log_file.
+inline std::string GetFlightRecorderDirectory() {
+    std::filesystem::path directory = g_config.flight_recorder_dir;
+    if (directory.is_relative()) directory = get_module_path() / directory;
+    return directory.string();
+}
+
 // Save the current g_config back to the config file
 inline bool SaveConfig(const std::string& config_path) {
     std::ofstream file(config_path);
     if (!file.is_open()) {
-        std::cerr << "SaveConfig: Failed to open config file for writing: " << config_path << std::endl;
+        OX_LOG_ERROR("SaveConfig: Failed to open config file for writing: %s", config_path.c_str());
         return false;
     }
 
     crow::json::wvalue json_config = {{"device", g_config.device},
                                       {"headless", g_config.headless},
                                       {"api", g_config.api},
-                                      {"api_port", g_config.api_port}};
+                                      {"api_port", g_config.api_port},
+                                      {"lock_profiling", g_config.lock_profiling},
+                                      {"log_level", g_config.log_level},
+                                      {"log_file", g_config.log_file},
+                                      {"preview_downsample", g_config.preview_downsample},
+                                      {"preview_fps", g_config.preview_fps},
+                                      {"input_latch_boolean", g_config.input_latch_boolean},
+                                      {"input_latch_float", g_config.input_latch_float},
+                                      {"input_latch_vec2", g_config.input_latch_vec2},
+                                      {"frame_commit", g_config.frame_commit},
+                                      {"flight_recorder", g_config.flight_recorder},
+                                      {"flight_recorder_mb", g_config.flight_recorder_mb},
+                                      {"flight_recorder_width", g_config.flight_recorder_width},
+                                      {"flight_recorder_decimation", g_config.flight_recorder_decimation},
+                                      {"flight_recorder_dir", g_config.flight_recorder_dir},
+                                      {"frame_monitor", g_config.frame_monitor},
+                                      {"task_pool_workers", g_config.task_pool_workers}};
+
+    // Only classes with settings are written back, with only the fields that are set.
+    crow::json::wvalue threads = crow::json::wvalue::object();
+    bool any_threads = false;
+    for (int i = 0; i < ox_sim::kThreadClassCount; i++) {
+        const ox_sim::ThreadPlacement& placement = g_config.threads[i];
+        if (placement.name.empty() && placement.cpus.empty() && placement.policy.empty() && !placement.has_nice) {
+            continue;
+        }
+        crow::json::wvalue& entry = threads[ox_sim::ThreadClassName(static_cast<ox_sim::ThreadClass>(i))];
+        entry = crow::json::wvalue::object();
+        if (!placement.name.empty()) entry["name"] = placement.name;
+        if (!placement.cpus.empty()) entry["cpus"] = placement.cpus;
+        if (!placement.policy.empty()) entry["policy"] = placement.policy;
+        if (placement.policy == "fifo" || placement.policy == "rr") entry["priority"] = placement.priority;
+        if (placement.has_nice) entry["nice"] = placement.nice;
+        any_threads = true;
+    }
+    if (any_threads) json_config["threads"] = std::move(threads);
 
     file << json_config.dump(2);  // Pretty print with 2-space indentation
     file.close();
 
-    std::cout << "SaveConfig: Saved config to " << config_path << std::endl;
+    OX_LOG_INFO("SaveConfig: Saved config to %s", config_path.c_str());
     return true;
 }
@@ -1,15 +1,25 @@
 #include <ox_driver.h>
 
 #include <cstring>
-#include <iostream>
 #include <string>
 
 #include "config.hpp"
 #include "device_profiles.h"
+#include "flight_recorder.h"
+#include "frame_monitor.h"
 #include "frame_data.h"
 #include "gui_window.h"
 #include "http_server.h"
+#include "latency_probe.h"
+#include "log.h"
+#include "metrics.h"
+#include "pixel_watch.h"
+#include "profiled_mutex.h"
+#include "scenario.h"
 #include "simulator_core.h"
+#include "task_pool.h"
+#include "thread_placement.h"
+#include "trace.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -27,40 +37,121 @@ SimulatorConfig g_config;
 const ox_sim::DeviceProfile* g_device_profile = nullptr;
 static bool g_api_enabled = true;  // API enabled state (shared between GUI and driver)
 
+// Worker threads for background work; declared before the modules below so it outlives them
+static TaskPool g_task_pool;
+
 // Global frame data for preview
 static FrameData g_frame_data;
 
-// Implementation of GetFrameData() declared in frame_data.h
+// Scenario uploaded through PUT /v1/scenario, played from the frame callbacks
+static ScenarioRunner g_scenario;
+
+// Input-to-photon measurement started through PUT /v1/latency, fed from submit_frame_pixels
+static LatencyProbe g_latency_probe;
+
+// Pixel probes registered through PUT /v1/probes, fed from submit_frame_pixels
+static PixelWatch g_pixel_watch;
+
+// Ring of recent frames for POST /v1/recorder/dump, fed from submit_frame_pixels
+static FlightRecorder g_flight_recorder(&g_task_pool);
+
+// Black/frozen/mismatch detection for GET /v1/monitor, fed from submit_frame_pixels
+static FrameMonitor g_frame_monitor(&g_task_pool);
+
+// Implementation of GetFrameData() declared in frame_data.h, GetScenarioRunner() declared in scenario.h,
+// GetLatencyProbe() declared in latency_probe.h, GetPixelWatch() declared in pixel_watch.h,
+// GetFlightRecorder() declared in flight_recorder.h, GetFrameMonitor() declared in frame_monitor.h and
+// GetTaskPool() declared in task_pool.h
 namespace ox_sim {
 FrameData* GetFrameData() { return &g_frame_data; }
+ScenarioRunner* GetScenarioRunner() { return &g_scenario; }
+LatencyProbe* GetLatencyProbe() { return &g_latency_probe; }
+PixelWatch* GetPixelWatch() { return &g_pixel_watch; }
+FlightRecorder* GetFlightRecorder() { return &g_flight_recorder; }
+FrameMonitor* GetFrameMonitor() { return &g_frame_monitor; }
+TaskPool* GetTaskPool() { return &g_task_pool; }
 }  // namespace ox_sim
 
 static OxVector3f rotate_vector_by_quat(const OxQuaternion& q, const OxVector3f& v);
 
+// Instruments the enclosing driver callback: times it into
+// ox_driver_callback_duration_seconds{callback="<name>"} (whose _count is the call count) and
+// records a trace slice while tracing is enabled.
+#define CALLBACK_SCOPE(name)                                                                                           \
+    static metrics::Histogram callback_histogram("ox_driver_callback_duration_seconds",                                \
+                                                 "Time spent inside OxDriverCallbacks entries",                        \
+                                                 "callback=\"" #name "\"");                                            \
+    metrics::ScopedTimer callback_timer(callback_histogram);                                                           \
+    OX_TRACE_SCOPE("driver", #name)
+
+// Moves a running scenario to the frame being sampled. Every callback that receives a predicted_time
+// calls it, since runtimes differ in which of them comes first in a frame; repeats are nearly free.
+static void AdvanceScenario(int64_t predicted_time) {
+    g_scenario.Advance(predicted_time, g_frame_data.session_state.load(std::memory_order_relaxed));
+}
+
+static metrics::Counter g_frames_submitted[2] = {
+    {"ox_frames_submitted_total", "Eye images submitted by the runtime", "eye=\"0\""},
+    {"ox_frames_submitted_total", "Eye images submitted by the runtime", "eye=\"1\""},
+};
+
 // ===== Driver Callbacks =====
 
 static int simulator_initialize(void) {
-    std::cout << "=== ox Simulator Driver ===" << std::endl;
+    CALLBACK_SCOPE(initialize);
+    OX_LOG_INFO("=== ox Simulator Driver ===");
 
     // Load configuration
     std::string config_path = GetConfigPath();
     LoadConfig(config_path);
+    ConfigureLogging();
+
+    if (!g_config.headless && !GuiWindow::kAvailable) {
+        OX_LOG_WARN("This driver was built without the GUI (OX_SIM_HEADLESS), running headless");
+        g_config.headless = true;
+        g_config.api = true;  // as for "headless": true in config.json
+    }
 
     // Set device profile based on config
     g_device_profile = GetDeviceProfileByName(g_config.device);
     if (!g_device_profile) {
-        std::cout << "Unknown device: " << g_config.device << ", defaulting to Quest 2" << std::endl;
+        OX_LOG_WARN("Unknown device: %s, defaulting to Quest 2", g_config.device.c_str());
         g_device_profile = &GetDeviceProfile(DeviceType::OCULUS_QUEST_2);
         g_config.device = "oculus_quest_2";
     }
 
-    std::cout << "Simulating device: " << g_device_profile->name << std::endl;
+    OX_LOG_INFO("Simulating device: %s", g_device_profile->name);
+
+    lock_profiler::SetEnabled(g_config.lock_profiling);
 
     // Initialize simulator core
+    const std::pair<ComponentType, const std::string*> latch_policies[] = {
+        {ComponentType::BOOLEAN, &g_config.input_latch_boolean},
+        {ComponentType::FLOAT, &g_config.input_latch_float},
+        {ComponentType::VEC2, &g_config.input_latch_vec2}};
+    for (const auto& [type, name] : latch_policies) {
+        InputLatchPolicy policy;
+        if (ParseInputLatchPolicy(*name, &policy)) g_simulator.SetInputLatchPolicy(type, policy);
+    }
+
     if (!g_simulator.Initialize(g_device_profile)) {
-        std::cerr << "Failed to initialize simulator core" << std::endl;
+        OX_LOG_ERROR("Failed to initialize simulator core");
         return 0;
     }
+    g_simulator.SetCommitMode(g_config.frame_commit);
+
+    // Threads started from here on (task pool, HTTP server, GUI) place themselves as configured.
+    for (int i = 0; i < kThreadClassCount; i++) SetThreadPlacement(static_cast<ThreadClass>(i), g_config.threads[i]);
+    g_task_pool.Start(static_cast<uint32_t>(g_config.task_pool_workers));
+
+    FlightRecorderConfig recorder_config;
+    recorder_config.budget_bytes = static_cast<size_t>(g_config.flight_recorder_mb) << 20;
+    recorder_config.max_width = static_cast<uint32_t>(g_config.flight_recorder_width);
+    recorder_config.decimation = static_cast<uint32_t>(g_config.flight_recorder_decimation);
+    g_flight_recorder.Configure(recorder_config);
+    g_flight_recorder.SetDumpDirectory(GetFlightRecorderDirectory());
+    g_flight_recorder.SetEnabled(g_config.flight_recorder);
+    g_frame_monitor.SetEnabled(g_config.frame_monitor);
 
     // Initialize API enabled state from config
     g_api_enabled = g_config.api;
@@ -68,39 +159,49 @@ static int simulator_initialize(void) {
     // Start interfaces based on configuration
     if (g_api_enabled) {
         if (!g_http_server.Start(&g_simulator, &g_device_profile, g_config.api_port)) {
-            std::cerr << "Failed to start HTTP server" << std::endl;
+            OX_LOG_ERROR("Failed to start HTTP server");
             return 0;
         }
     }
 
     if (!g_config.headless) {
         if (!g_gui_window.Start(&g_simulator, &g_device_profile, &g_api_enabled, &g_http_server, g_config.api_port)) {
-            std::cerr << "Failed to start GUI window" << std::endl;
+            OX_LOG_ERROR("Failed to start GUI window");
             g_http_server.Stop();
             return 0;
         }
     }
 
-    std::cout << "Simulator driver initialized successfully" << std::endl;
+    OX_LOG_INFO("Simulator driver initialized successfully");
     return 1;
 }
 
 static void simulator_shutdown(void) {
-    std::cout << "Shutting down simulator driver..." << std::endl;
+    CALLBACK_SCOPE(shutdown);
+    OX_LOG_INFO("Shutting down simulator driver...");
 
     g_http_server.Stop();
     g_gui_window.Stop();
+    g_scenario.Stop();
+    g_latency_probe.Stop();
+    g_pixel_watch.Stop();
+    g_flight_recorder.Stop();
+    g_frame_monitor.Stop();
+    g_task_pool.Stop();
     g_simulator.Shutdown();
 
-    std::cout << "Simulator driver shut down" << std::endl;
+    OX_LOG_INFO("Simulator driver shut down");
+    logging::Shutdown();
 }
 
 static int simulator_is_device_connected(void) {
+    CALLBACK_SCOPE(is_device_connected);
     // Simulator is always "connected"
     return 1;
 }
 
 static void simulator_get_device_info(OxDeviceInfo* info) {
+    CALLBACK_SCOPE(get_device_info);
     if (!g_device_profile) {
         return;
     }
@@ -121,6 +222,7 @@ static void simulator_get_device_info(OxDeviceInfo* info) {
 }
 
 static void simulator_get_display_properties(OxDisplayProperties* props) {
+    CALLBACK_SCOPE(get_display_properties);
     if (!g_device_profile) {
         return;
     }
@@ -138,6 +240,7 @@ static void simulator_get_display_properties(OxDisplayProperties* props) {
 }
 
 static void simulator_get_tracking_capabilities(OxTrackingCapabilities* caps) {
+    CALLBACK_SCOPE(get_tracking_capabilities);
     if (!g_device_profile) {
         return;
     }
@@ -147,6 +250,9 @@ static void simulator_get_tracking_capabilities(OxTrackingCapabilities* caps) {
 }
 
 static void simulator_update_view_pose(int64_t predicted_time, uint32_t eye_index, OxPose* out_pose) {
+    CALLBACK_SCOPE(update_view_pose);
+    AdvanceScenario(predicted_time);
+    g_simulator.OnFrameBoundary(predicted_time);
     // Get HMD pose from device list (HMD is at /user/head)
     OxDeviceState devices[OX_MAX_DEVICES];
     uint32_t device_count;
@@ -178,6 +284,9 @@ static void simulator_update_view_pose(int64_t predicted_time, uint32_t eye_inde
 }
 
 static void simulator_update_devices(int64_t predicted_time, OxDeviceState* out_states, uint32_t* out_count) {
+    CALLBACK_SCOPE(update_devices);
+    AdvanceScenario(predicted_time);
+    g_simulator.OnFrameBoundary(predicted_time);
     if (!g_device_profile) {
         *out_count = 0;
         return;
@@ -188,38 +297,45 @@ static void simulator_update_devices(int64_t predicted_time, OxDeviceState* out_
 
 static OxComponentResult simulator_get_input_state_boolean(int64_t predicted_time, const char* user_path,
                                                            const char* component_path, uint32_t* out_value) {
+    CALLBACK_SCOPE(get_input_state_boolean);
+    AdvanceScenario(predicted_time);
     if (!g_device_profile) {
         return OX_COMPONENT_UNAVAILABLE;
     }
 
     bool value;
-    OxComponentResult result = g_simulator.GetInputStateBoolean(user_path, component_path, &value);
+    OxComponentResult result = g_simulator.GetInputStateBoolean(user_path, component_path, predicted_time, &value);
     *out_value = value ? 1 : 0;
     return result;
 }
 
 static OxComponentResult simulator_get_input_state_float(int64_t predicted_time, const char* user_path,
                                                          const char* component_path, float* out_value) {
+    CALLBACK_SCOPE(get_input_state_float);
+    AdvanceScenario(predicted_time);
     if (!g_device_profile) {
         return OX_COMPONENT_UNAVAILABLE;
     }
 
-    return g_simulator.GetInputStateFloat(user_path, component_path, out_value);
+    return g_simulator.GetInputStateFloat(user_path, component_path, predicted_time, out_value);
 }
 
 static OxComponentResult simulator_get_input_state_vector2f(int64_t predicted_time, const char* user_path,
                                                             const char* component_path, OxVector2f* out_value) {
+    CALLBACK_SCOPE(get_input_state_vector2f);
+    AdvanceScenario(predicted_time);
     if (!g_device_profile) {
         return OX_COMPONENT_UNAVAILABLE;
     }
 
     OxVector2f vec;
-    OxComponentResult result = g_simulator.GetInputStateVec2(user_path, component_path, &vec);
+    OxComponentResult result = g_simulator.GetInputStateVec2(user_path, component_path, predicted_time, &vec);
     *out_value = vec;
     return result;
 }
 
 static uint32_t simulator_get_interaction_profiles(const char** out_profiles, uint32_t max_count) {
+    CALLBACK_SCOPE(get_interaction_profiles);
     if (!g_device_profile || max_count == 0) {
         return 0;
     }
@@ -229,26 +345,28 @@ static uint32_t simulator_get_interaction_profiles(const char** out_profiles, ui
 }
 
 static void simulator_on_session_state_changed(OxSessionState new_state) {
+    CALLBACK_SCOPE(on_session_state_changed);
     g_frame_data.session_state.store(static_cast<uint32_t>(new_state), std::memory_order_relaxed);
 }
 
 static void simulator_submit_frame_pixels(uint32_t eye_index, uint32_t width, uint32_t height, uint32_t format,
                                           const void* pixel_data, uint32_t data_size) {
+    CALLBACK_SCOPE(submit_frame_pixels);
     if (eye_index >= 2 || width == 0 || height == 0 || !pixel_data || data_size == 0) {
-        std::cout << "[Driver] submit_frame_pixels: Invalid parameters (eye=" << eye_index << " size=" << width << "x"
-                  << height << " data_size=" << data_size << ")" << std::endl;
+        OX_LOG_WARN("[Driver] submit_frame_pixels: Invalid parameters (eye=%u size=%ux%u data_size=%u)", eye_index,
+                    width, height, data_size);
         return;
     }
 
     // Store frame data pointers for GUI preview (zero-copy - use shared memory directly)
     {
-        std::lock_guard<std::mutex> lock(g_frame_data.mutex);
+        ProfiledLock lock(g_frame_data.mutex);
 
         // Update dimensions on first frame or size change
         if (g_frame_data.width != width || g_frame_data.height != height) {
             g_frame_data.width = width;
             g_frame_data.height = height;
-            std::cout << "[Driver] Frame dimensions set to " << width << "x" << height << std::endl;
+            OX_LOG_INFO("[Driver] Frame dimensions set to %ux%u", width, height);
         }
 
         // Store the shared memory pointer
@@ -263,6 +381,14 @@ static void simulator_submit_frame_pixels(uint32_t eye_index, uint32_t width, ui
         // Mark that new frame is available
         g_frame_data.has_new_frame.store(true, std::memory_order_release);
     }
+
+    g_latency_probe.OnFrameSubmitted(eye_index, width, height, pixel_data, data_size);
+    g_pixel_watch.OnFrameSubmitted(eye_index, width, height, pixel_data, data_size);
+    g_flight_recorder.OnFrameSubmitted(eye_index, width, height, pixel_data, data_size);
+    g_frame_monitor.OnFrameSubmitted(eye_index, width, height, pixel_data, data_size);
+
+    g_frames_submitted[eye_index].Add();
+    g_gui_window.NotifyFrameSubmitted();
 }
 
 // ===== Driver Registration =====
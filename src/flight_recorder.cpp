@@ -0,0 +1,234 @@
+#include "flight_recorder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#include "log.h"
+#include "metrics.h"
+#include "pixel_ops.h"
+#include "qoi.h"
+#include "task_pool.h"
+#include "trace.h"
+
+namespace ox_sim {
+
+static metrics::Counter g_frames_recorded("ox_flight_recorder_frames_total", "Frames added to the flight recorder");
+static metrics::Counter g_frames_skipped("ox_flight_recorder_frames_skipped_total",
+                                         "Frames replaced by a newer one before the flight recorder encoded them");
+static metrics::Histogram g_encode_duration("ox_flight_recorder_encode_seconds",
+                                            "Time spent encoding one flight recorder frame");
+static metrics::Histogram g_downsample_duration("ox_flight_recorder_downsample_seconds",
+                                                "Submit-path time spent downsampling a frame for the flight recorder");
+
+const char* FlightRecorder::DumpStateName(DumpState state) {
+    switch (state) {
+        case DumpState::kIdle:
+            return "idle";
+        case DumpState::kRunning:
+            return "running";
+        case DumpState::kFinished:
+            return "finished";
+        case DumpState::kFailed:
+            return "failed";
+    }
+    return "unknown";
+}
+
+void FlightRecorder::Configure(const FlightRecorderConfig& config) {
+    ProfiledLock lock(mutex_);
+    config_ = config;
+    if (config_.decimation == 0) config_.decimation = 1;
+    Evict();
+}
+
+void FlightRecorder::SetEnabled(bool enabled) {
+    ProfiledLock lock(mutex_);
+    if (enabled) {
+        stopping_ = false;
+        enabled_.store(true, std::memory_order_release);
+        return;
+    }
+    enabled_.store(false, std::memory_order_release);
+    stopping_ = true;
+    latest_.Clear();
+    // The task pool outlives the recorder's users, so a queued task always runs and finishes.
+    cv_.wait(lock, [this] { return !latest_.scheduled(); });
+    ring_.clear();
+    ring_bytes_ = 0;
+}
+
+void FlightRecorder::SetDumpDirectory(const std::string& directory) {
+    ProfiledLock lock(mutex_);
+    dump_directory_ = directory;
+}
+
+bool FlightRecorder::Dump(const std::string& path, std::string* resolved_path, std::string* error) {
+    ProfiledLock lock(mutex_);
+    if (dump_state_ == DumpState::kRunning) {
+        *error = "a dump is already running";
+        return false;
+    }
+    if (ring_.empty()) {
+        *error = "no frames recorded";
+        return false;
+    }
+    std::filesystem::path directory = path;
+    if (directory.empty()) {
+        const int64_t unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    std::chrono::system_clock::now().time_since_epoch())
+                                    .count();
+        directory = std::filesystem::path(dump_directory_) / ("flight-" + std::to_string(unix_ms));
+    }
+    *resolved_path = directory.string();
+
+    dump_state_ = DumpState::kRunning;
+    dump_path_ = *resolved_path;
+    dump_written_ = 0;
+    dump_total_ = ring_.size();
+    dump_error_.clear();
+    auto task = [this, frames = std::vector<Frame>(ring_.begin(), ring_.end()), path = *resolved_path]() {
+        DumpTask(frames, path);
+    };
+    if (!pool_->Submit(TaskPriority::kCapture, std::move(task))) {
+        dump_state_ = DumpState::kFailed;
+        dump_error_ = *error = "the task pool is not running";
+        return false;
+    }
+    return true;
+}
+
+FlightRecorder::Status FlightRecorder::GetStatus() const {
+    ProfiledLock lock(mutex_);
+    Status status;
+    status.enabled = enabled_.load(std::memory_order_relaxed);
+    status.config = config_;
+    status.frames = ring_.size();
+    status.bytes = ring_bytes_;
+    if (!ring_.empty()) {
+        status.oldest_ns = ring_.front().time_ns;
+        status.newest_ns = ring_.back().time_ns;
+        status.width = ring_.back().width;
+        status.height = ring_.back().height;
+    }
+    status.dump_state = dump_state_;
+    status.dump_path = dump_path_;
+    status.dump_written = dump_written_;
+    status.dump_total = dump_total_;
+    status.dump_error = dump_error_;
+    return status;
+}
+
+void FlightRecorder::Stop() {
+    SetEnabled(false);
+    ProfiledLock lock(mutex_);
+    cv_.wait(lock, [this] { return dump_state_ != DumpState::kRunning; });
+}
+
+void FlightRecorder::QueueFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels) {
+    OX_TRACE_SCOPE("flight_recorder", "QueueFrame");
+    const int64_t now_ns = trace::NowNs();
+    ProfiledLock lock(mutex_);
+    const uint64_t frame = ++frames_[eye];
+    if ((frame - 1) % config_.decimation != 0) return;
+
+    const uint32_t factor =
+        config_.max_width == 0 || width <= config_.max_width ? 1 : (width + config_.max_width - 1) / config_.max_width;
+    if (latest_.pending(eye)) g_frames_skipped.Add();
+    PendingFrame& slot = latest_.Refill(eye);
+    slot.frame = frame;
+    slot.time_ns = now_ns;
+    slot.width = width / factor;
+    slot.height = height / factor;
+    if (slot.width == 0 || slot.height == 0) return;
+    {
+        metrics::ScopedTimer timer(g_downsample_duration);
+        slot.pixels.resize(static_cast<size_t>(slot.width) * slot.height * 4);
+        DownsampleRGBA(pixels, width, height, factor, slot.pixels.data());
+    }
+    latest_.Publish(eye, stopping_);
+}
+
+void FlightRecorder::Evict() {
+    while (!ring_.empty() && ring_bytes_ > config_.budget_bytes) {
+        ring_bytes_ -= ring_.front().qoi->size();
+        ring_.pop_front();
+    }
+}
+
+void FlightRecorder::EncodeTask() {
+    ProfiledLock lock(mutex_);
+    const int eye = stopping_ ? -1 : latest_.Take();
+    if (eye >= 0) {
+        const PendingFrame& frame = latest_.taken();
+        lock.unlock();
+        auto qoi = std::make_shared<std::vector<uint8_t>>();
+        {
+            OX_TRACE_SCOPE("flight_recorder", "EncodeQoi");
+            metrics::ScopedTimer timer(g_encode_duration);
+            EncodeQoi(frame.pixels.data(), frame.width, frame.height, qoi.get());
+        }
+        qoi->shrink_to_fit();
+        lock.lock();
+
+        if (!stopping_) {
+            ring_bytes_ += qoi->size();
+            ring_.push_back(
+                {static_cast<uint32_t>(eye), frame.frame, frame.time_ns, frame.width, frame.height, std::move(qoi)});
+            Evict();
+            g_frames_recorded.Add();
+        }
+    }
+    if (!latest_.TaskDone(stopping_)) cv_.notify_all();
+}
+
+void FlightRecorder::FinishDump(DumpState state, std::string error) {
+    {
+        ProfiledLock lock(mutex_);
+        dump_state_ = state;
+        dump_error_ = std::move(error);
+    }
+    cv_.notify_all();
+}
+
+void FlightRecorder::DumpTask(const std::vector<Frame>& frames, const std::string& path) {
+    OX_TRACE_SCOPE("flight_recorder", "Dump");
+    auto fail = [this](std::string error) {
+        OX_LOG_ERROR("Flight recorder dump failed: %s", error.c_str());
+        FinishDump(DumpState::kFailed, std::move(error));
+    };
+
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) return fail("cannot create " + path + ": " + ec.message());
+
+    std::ofstream index(std::filesystem::path(path) / "frames.csv");
+    if (!index) return fail("cannot write frames.csv in " + path);
+    index << "file,eye,frame,time_ns,width,height\n";
+
+    uint64_t written[2] = {0, 0};
+    for (size_t i = 0; i < frames.size(); i++) {
+        const Frame& frame = frames[i];
+        char name[32];
+        std::snprintf(name, sizeof(name), "eye%u_%06llu.qoi", frame.eye,
+                      static_cast<unsigned long long>(++written[frame.eye]));
+        std::ofstream file(std::filesystem::path(path) / name, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(frame.qoi->data()), static_cast<std::streamsize>(frame.qoi->size()));
+        if (!file) return fail(std::string("cannot write ") + name);
+        index << name << ',' << frame.eye << ',' << frame.frame << ',' << frame.time_ns << ',' << frame.width << ','
+              << frame.height << '\n';
+
+        ProfiledLock lock(mutex_);
+        dump_written_ = i + 1;
+    }
+    index.flush();
+    if (!index) return fail("cannot write frames.csv in " + path);
+
+    OX_LOG_INFO("Flight recorder: wrote %zu frames to %s", frames.size(), path.c_str());
+    FinishDump(DumpState::kFinished, std::string());
+}
+
+}  // namespace ox_sim
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "latest_frames.h"
+#include "profiled_mutex.h"
+
+namespace ox_sim {
+
+struct FlightRecorderConfig {
+    size_t budget_bytes = size_t{64} << 20;  // encoded frames kept, both eyes together
+    uint32_t max_width = 480;                // downsample wider frames by an integer factor; 0 = full size
+    uint32_t decimation = 1;                 // record every Nth frame of each eye
+};
+
+// Keeps the most recent submitted frames in memory so they can be written out after something went
+// wrong. The submit hook downsamples the frame into the eye's pending slot and queues a capture
+// task on the driver's task pool, which encodes it as QOI and appends it to a ring that drops its
+// oldest frames to stay within the memory budget. If the pool falls behind, a pending frame is
+// replaced by the next one.
+//
+// Dump() writes the ring as it was at the time of the call, in another capture task, to a directory
+// of numbered QOI images (eye0_000001.qoi, ...) plus frames.csv with each image's frame number and
+// submit time. Recording continues meanwhile.
+class FlightRecorder {
+   public:
+    enum class DumpState { kIdle, kRunning, kFinished, kFailed };
+
+    struct Status {
+        bool enabled = false;
+        FlightRecorderConfig config;
+        size_t frames = 0;  // in the ring
+        size_t bytes = 0;
+        int64_t oldest_ns = 0;  // submit time of the oldest and newest recorded frame
+        int64_t newest_ns = 0;
+        uint32_t width = 0;  // size of the newest recorded frame
+        uint32_t height = 0;
+
+        DumpState dump_state = DumpState::kIdle;
+        std::string dump_path;
+        size_t dump_written = 0;
+        size_t dump_total = 0;
+        std::string dump_error;  // kFailed
+    };
+
+    // Background work runs as capture tasks on `pool`, which must outlive this object.
+    explicit FlightRecorder(TaskPool* pool)
+        : pool_(pool), mutex_("flight_recorder"), latest_(pool, [this]() { EncodeTask(); }) {}
+    ~FlightRecorder() { Stop(); }
+
+    // Apply a new configuration. A lower budget evicts old frames right away.
+    void Configure(const FlightRecorderConfig& config);
+
+    // Start or stop recording. Stopping frees the ring.
+    void SetEnabled(bool enabled);
+
+    // Where Dump() creates its directories when it is not given a path.
+    void SetDumpDirectory(const std::string& directory);
+
+    // Write the current ring to `path` (created if missing; empty = a new flight-<time> directory
+    // under the dump directory) in the background. Fails if a dump is already running or the ring is
+    // empty. On success *resolved_path is the directory being written.
+    bool Dump(const std::string& path, std::string* resolved_path, std::string* error);
+
+    Status GetStatus() const;
+
+    // Stop recording and wait for the encode task and any running dump.
+    void Stop();
+
+    static const char* DumpStateName(DumpState state);
+
+    // Driver hook, called from submit_frame_pixels with RGBA8 pixels. A single atomic load unless
+    // recording is enabled.
+    void OnFrameSubmitted(uint32_t eye, uint32_t width, uint32_t height, const void* pixels, size_t size) {
+        if (!enabled_.load(std::memory_order_acquire) || eye > 1) return;
+        if (size < static_cast<size_t>(width) * height * 4) return;
+        QueueFrame(eye, width, height, static_cast<const uint8_t*>(pixels));
+    }
+
+   private:
+    struct Frame {
+        uint32_t eye;
+        uint64_t frame;
+        int64_t time_ns;
+        uint32_t width;
+        uint32_t height;
+        std::shared_ptr<const std::vector<uint8_t>> qoi;  // shared with a running dump
+    };
+
+    struct PendingFrame {
+        uint64_t frame = 0;
+        int64_t time_ns = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;  // top row first
+    };
+
+    void QueueFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels);
+    void EncodeTask();
+    void DumpTask(const std::vector<Frame>& frames, const std::string& path);
+    void FinishDump(DumpState state, std::string error);
+
+    void Evict();  // requires mutex_
+
+    TaskPool* pool_;
+
+    // Guards everything below except the taken frame. The submit hook holds it while it downsamples into
+    // the pending slot; the encode task works without it.
+    mutable ProfiledMutex mutex_;
+    std::condition_variable_any cv_;  // signalled when the encode task or a dump finishes
+    std::atomic<bool> enabled_{false};
+    bool stopping_ = false;
+
+    FlightRecorderConfig config_;
+    uint64_t frames_[2] = {0, 0};  // frames seen per eye
+    LatestFrames<PendingFrame> latest_;
+
+    std::deque<Frame> ring_;
+    size_t ring_bytes_ = 0;
+
+    std::string dump_directory_ = ".";
+    DumpState dump_state_ = DumpState::kIdle;
+    std::string dump_path_;
+    size_t dump_written_ = 0;
+    size_t dump_total_ = 0;
+    std::string dump_error_;
+};
+
+// Get the driver's flight recorder - implemented in driver.cpp
+FlightRecorder* GetFlightRecorder();
+
+}  // namespace ox_sim
@@ -8,6 +8,8 @@
 #include <deque>
 #include <mutex>
 
+#include "profiled_mutex.h"
+
 using namespace std::chrono;
 
 namespace ox_sim {
@@ -19,7 +21,7 @@ struct FrameData {
     uint32_t width = 0;
     uint32_t height = 0;
     std::atomic<bool> has_new_frame{false};
-    std::mutex mutex;
+    ProfiledMutex mutex{"frame_data"};
 
     // --- Session state ---
     std::atomic<uint32_t> session_state{OX_SESSION_STATE_UNKNOWN};
@@ -0,0 +1,190 @@
+#include "frame_monitor.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "log.h"
+#include "metrics.h"
+#include "trace.h"
+
+namespace ox_sim {
+
+static metrics::Counter g_frames_measured("ox_frame_monitor_frames_total", "Frames measured by the frame monitor");
+static metrics::Counter g_frames_skipped("ox_frame_monitor_frames_skipped_total",
+                                         "Frames replaced by a newer one before the frame monitor measured them");
+static metrics::Histogram g_copy_duration("ox_frame_monitor_copy_seconds",
+                                          "Submit-path time spent copying the sampled rows of a frame");
+static metrics::Histogram g_measure_duration("ox_frame_monitor_measure_seconds",
+                                             "Task time spent computing the statistics of one frame");
+static metrics::Counter g_black_episodes("ox_frame_monitor_episodes_total", "Frame monitor detector episodes",
+                                         "detector=\"black\"");
+static metrics::Counter g_frozen_episodes("ox_frame_monitor_episodes_total", "Frame monitor detector episodes",
+                                          "detector=\"frozen\"");
+static metrics::Counter g_mismatch_episodes("ox_frame_monitor_episodes_total", "Frame monitor detector episodes",
+                                            "detector=\"mismatch\"");
+
+// Advance `detector` by one frame (or left/right pair) and log episode boundaries. `eye` is -1 for
+// the mismatch detector.
+static void UpdateDetector(FrameDetectorStatus& detector, bool active, int64_t start_ns, int64_t time_ns,
+                           metrics::Counter& episodes, const char* name, int eye) {
+    if (active) {
+        detector.frames++;
+        detector.last_ns = time_ns;
+        if (detector.active) return;
+        detector.active = true;
+        detector.episodes++;
+        detector.since_ns = start_ns;
+        episodes.Add();
+        if (eye < 0) {
+            OX_LOG_WARN("Frame monitor: left and right eye images differ");
+        } else {
+            OX_LOG_WARN("Frame monitor: %s frames on eye %d", name, eye);
+        }
+    } else if (detector.active) {
+        detector.active = false;
+        if (eye < 0) {
+            OX_LOG_INFO("Frame monitor: left and right eye images match again");
+        } else {
+            OX_LOG_INFO("Frame monitor: %s frames on eye %d ended", name, eye);
+        }
+    }
+}
+
+void FrameMonitor::Configure(const FrameMonitorConfig& config) {
+    ProfiledLock lock(mutex_);
+    config_ = config;
+    if (config_.row_stride == 0) config_.row_stride = 1;
+}
+
+void FrameMonitor::SetEnabled(bool enabled) {
+    ProfiledLock lock(mutex_);
+    if (enabled) {
+        if (!enabled_.load(std::memory_order_relaxed)) {
+            stopping_ = false;
+            for (FrameEyeStatus& eye : eyes_) {
+                eye.measured = false;
+                eye.black_run = 0;
+                eye.black.active = eye.frozen.active = false;
+            }
+            mismatch_.active = false;
+        }
+        enabled_.store(true, std::memory_order_release);
+        return;
+    }
+    enabled_.store(false, std::memory_order_release);
+    stopping_ = true;
+    latest_.Clear();
+    // The task pool outlives the monitor's users, so a queued task always runs and finishes.
+    cv_.wait(lock, [this] { return !latest_.scheduled(); });
+}
+
+void FrameMonitor::Reset() {
+    ProfiledLock lock(mutex_);
+    for (FrameEyeStatus& eye : eyes_) eye = FrameEyeStatus();
+    mismatch_distance_ = 0.0f;
+    mismatch_ = FrameDetectorStatus();
+}
+
+FrameMonitor::Status FrameMonitor::GetStatus() const {
+    ProfiledLock lock(mutex_);
+    Status status;
+    status.enabled = enabled_.load(std::memory_order_relaxed);
+    status.config = config_;
+    status.eyes[0] = eyes_[0];
+    status.eyes[1] = eyes_[1];
+    status.mismatch_distance = mismatch_distance_;
+    status.mismatch = mismatch_;
+    return status;
+}
+
+void FrameMonitor::QueueFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels) {
+    OX_TRACE_SCOPE("frame_monitor", "QueueFrame");
+    const int64_t now_ns = trace::NowNs();
+    ProfiledLock lock(mutex_);
+    frames_[eye]++;
+
+    if (latest_.pending(eye)) g_frames_skipped.Add();
+    FrameJob& job = latest_.Refill(eye);
+    job.eye = eye;
+    job.frame = frames_[eye];
+    job.time_ns = now_ns;
+    job.width = width;
+    job.height = height;
+    {
+        metrics::ScopedTimer timer(g_copy_duration);
+        const size_t row_bytes = static_cast<size_t>(width) * 4;
+        const uint32_t stride = config_.row_stride;
+        job.rows.resize(((height + stride - 1) / stride) * row_bytes);
+        uint8_t* dst = job.rows.data();
+        for (uint32_t row = 0; row < height; row += stride, dst += row_bytes) {
+            std::memcpy(dst, pixels + row * row_bytes, row_bytes);
+        }
+    }
+    latest_.Publish(eye, stopping_);
+}
+
+void FrameMonitor::Measure(FrameJob& job) {
+    OX_TRACE_SCOPE("frame_monitor", "Measure");
+    metrics::ScopedTimer timer(g_measure_duration);
+    job.luma = LumaStats();
+    AccumulateLumaStats(job.rows.data(), job.rows.size() / 4, &job.luma);
+    job.hash = HashBytes(job.rows.data(), job.rows.size(), (static_cast<uint64_t>(job.width) << 32) | job.height);
+}
+
+void FrameMonitor::ApplyResults(const FrameJob& job) {
+    FrameEyeStatus& eye = eyes_[job.eye];
+    const bool repeated = eye.measured && job.hash == eye.hash;
+    eye.measured = true;
+    eye.frame = job.frame;
+    eye.time_ns = job.time_ns;
+    eye.width = job.width;
+    eye.height = job.height;
+    eye.luma = job.luma;
+    eye.hash = job.hash;
+    eye.repeats = repeated ? eye.repeats + 1 : 0;
+    if (!repeated) eye.changed_ns = job.time_ns;
+
+    // A black screen is reported as black, not also as frozen.
+    const bool black = job.luma.Mean() < config_.black_threshold;
+    eye.black_run = black ? eye.black_run + 1 : 0;
+    UpdateDetector(eye.black, black && eye.black_run >= config_.black_frames, job.time_ns, job.time_ns,
+                   g_black_episodes, "black", static_cast<int>(job.eye));
+    UpdateDetector(eye.frozen, !black && eye.repeats >= config_.frozen_frames, eye.changed_ns, job.time_ns,
+                   g_frozen_episodes, "frozen", static_cast<int>(job.eye));
+
+    // Compare the eyes once both have been measured for the same frame number. The distance is half
+    // the L1 distance between the normalized histograms: 0 for identical distributions, 1 for
+    // disjoint ones.
+    const FrameEyeStatus& left = eyes_[0];
+    const FrameEyeStatus& right = eyes_[1];
+    if (!left.measured || !right.measured || left.frame != right.frame || left.luma.count == 0 ||
+        right.luma.count == 0) {
+        return;
+    }
+    double distance = 0.0;
+    for (int bucket = 0; bucket < 16; bucket++) {
+        distance += std::abs(static_cast<double>(left.luma.histogram[bucket]) / left.luma.count -
+                             static_cast<double>(right.luma.histogram[bucket]) / right.luma.count);
+    }
+    mismatch_distance_ = static_cast<float>(distance / 2.0);
+    UpdateDetector(mismatch_, mismatch_distance_ > config_.mismatch_threshold, job.time_ns, job.time_ns,
+                   g_mismatch_episodes, "mismatch", -1);
+}
+
+void FrameMonitor::MeasureTask() {
+    ProfiledLock lock(mutex_);
+    if (!stopping_ && latest_.Take() >= 0) {
+        FrameJob& job = latest_.taken();
+        lock.unlock();
+        Measure(job);
+        lock.lock();
+
+        if (!stopping_) {
+            ApplyResults(job);
+            g_frames_measured.Add();
+        }
+    }
+    if (!latest_.TaskDone(stopping_)) cv_.notify_all();
+}
+
+}  // namespace ox_sim
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <vector>
+
+#include "latest_frames.h"
+#include "pixel_ops.h"
+#include "profiled_mutex.h"
+
+namespace ox_sim {
+
+struct FrameMonitorConfig {
+    uint32_t row_stride = 4;          // measure every Nth row of each frame
+    float black_threshold = 4.0f;     // a frame is black when its mean luma (0-255) is below this
+    uint32_t black_frames = 1;        // black frames in a row before an eye counts as black
+    uint32_t frozen_frames = 30;      // frames in a row identical to their predecessor before an eye counts as frozen
+    float mismatch_threshold = 0.5f;  // left/right histogram distance (0-1) above which a pair counts as mismatched
+};
+
+// One detector's findings. An episode starts when the detector's condition is first met and ends
+// with the first frame that does not meet it.
+struct FrameDetectorStatus {
+    bool active = false;
+    uint64_t frames = 0;    // frames (or left/right pairs) seen while active
+    uint64_t episodes = 0;  // times it became active
+    int64_t since_ns = 0;   // start of the current or last episode
+    int64_t last_ns = 0;    // submit time of the last frame seen while active
+};
+
+// Latest measurement of one eye.
+struct FrameEyeStatus {
+    bool measured = false;
+    uint64_t frame = 0;  // number of the measured frame of this eye
+    int64_t time_ns = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    LumaStats luma;          // over the measured rows
+    uint64_t hash = 0;       // of the measured rows
+    uint64_t repeats = 0;    // measured frames in a row identical to the one before them
+    int64_t changed_ns = 0;  // submit time of the last measured frame that differed from its predecessor
+    uint32_t black_run = 0;  // measured black frames in a row
+    FrameDetectorStatus black;
+    FrameDetectorStatus frozen;
+};
+
+// Computes image statistics of every submitted frame and flags black frames, frozen sequences and
+// left/right eye mismatches, so soak tests notice them without anyone watching the GUI. The submit
+// hook only copies every row_stride-th row of the frame into the eye's pending job and queues a
+// capture task on the driver's task pool, which computes the luma mean, variance and 16-bucket
+// histogram with SIMD, hashes the rows to compare the frame with the previous one and updates the
+// detectors. If the pool falls behind, the pending job is replaced by the newer frame; the frozen
+// detector then compares the frames it did measure.
+class FrameMonitor {
+   public:
+    struct Status {
+        bool enabled = false;
+        FrameMonitorConfig config;
+        FrameEyeStatus eyes[2];
+        float mismatch_distance = 0.0f;  // of the last left/right pair measured with the same frame number
+        FrameDetectorStatus mismatch;
+    };
+
+    // Background work runs as capture tasks on `pool`, which must outlive this object.
+    explicit FrameMonitor(TaskPool* pool) : mutex_("frame_monitor"), latest_(pool, [this]() { MeasureTask(); }) {}
+    ~FrameMonitor() { Stop(); }
+
+    void Configure(const FrameMonitorConfig& config);
+
+    // Start or stop measuring frames. Detector counters are kept; a restarted monitor does not
+    // compare its first frames with the ones measured before it was stopped.
+    void SetEnabled(bool enabled);
+
+    // Clear all measurements and detector counters.
+    void Reset();
+
+    Status GetStatus() const;
+
+    void Stop() { SetEnabled(false); }
+
+    // Driver hook, called from submit_frame_pixels with RGBA8 pixels. A single atomic load unless
+    // the monitor is enabled.
+    void OnFrameSubmitted(uint32_t eye, uint32_t width, uint32_t height, const void* pixels, size_t size) {
+        if (!enabled_.load(std::memory_order_acquire) || eye > 1) return;
+        if (size < static_cast<size_t>(width) * height * 4) return;
+        QueueFrame(eye, width, height, static_cast<const uint8_t*>(pixels));
+    }
+
+   private:
+    struct FrameJob {
+        uint32_t eye = 0;
+        uint64_t frame = 0;
+        int64_t time_ns = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> rows;  // the measured rows, tightly packed
+        LumaStats luma;             // task results
+        uint64_t hash = 0;
+    };
+
+    void QueueFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels);
+    void MeasureTask();
+
+    static void Measure(FrameJob& job);
+
+    void ApplyResults(const FrameJob& job);  // requires mutex_
+
+    // Guards everything below except the taken job. The submit hook holds it only to copy the
+    // sampled rows into the eye's pending job; the measure task works without it.
+    mutable ProfiledMutex mutex_;
+    std::condition_variable_any cv_;  // signalled when the measure task finishes
+    std::atomic<bool> enabled_{false};
+    bool stopping_ = false;
+
+    FrameMonitorConfig config_;
+    uint64_t frames_[2] = {0, 0};  // frames seen per eye
+    LatestFrames<FrameJob> latest_;
+
+    FrameEyeStatus eyes_[2];
+    float mismatch_distance_ = 0.0f;
+    FrameDetectorStatus mismatch_;
+};
+
+// Get the driver's frame monitor - implemented in driver.cpp
+FrameMonitor* GetFrameMonitor();
+
+}  // namespace ox_sim
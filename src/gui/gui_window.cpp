@@ -5,9 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
-#include <iostream>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "config.hpp"
@@ -15,6 +13,10 @@
 #include "frame_data.h"
 #include "http_server.h"
 #include "imgui_impl_opengl3.h"
+#include "log.h"
+#include "metrics.h"
+#include "thread_placement.h"
+#include "trace.h"
 #include "utils.hpp"
 #include "vog.h"
 
@@ -23,25 +25,28 @@ using ox_sim::utils::RadToDeg;
 
 namespace ox_sim {
 
+static metrics::Histogram g_gui_frame_duration("ox_gui_frame_duration_seconds",
+                                               "CPU time spent building a GUI frame (RenderFrame)");
+
 GuiWindow::GuiWindow() = default;
 GuiWindow::~GuiWindow() { Stop(); }
 
 bool GuiWindow::Start(SimulatorCore* simulator, const DeviceProfile** device_profile_ptr, bool* api_enabled,
                       HttpServer* http_server, int api_port) {
     if (!simulator) {
-        std::cerr << "GuiWindow::Start: Simulator is null" << std::endl;
+        OX_LOG_ERROR("GuiWindow::Start: Simulator is null");
         return false;
     }
     if (!device_profile_ptr) {
-        std::cerr << "GuiWindow::Start: Device profile pointer is null" << std::endl;
+        OX_LOG_ERROR("GuiWindow::Start: Device profile pointer is null");
         return false;
     }
     if (!api_enabled) {
-        std::cerr << "GuiWindow::Start: API enabled pointer is null" << std::endl;
+        OX_LOG_ERROR("GuiWindow::Start: API enabled pointer is null");
         return false;
     }
     if (window_.IsRunning()) {
-        std::cerr << "GuiWindow::Start: GUI already running" << std::endl;
+        OX_LOG_ERROR("GuiWindow::Start: GUI already running");
         return false;
     }
 
@@ -50,12 +55,19 @@ bool GuiWindow::Start(SimulatorCore* simulator, const DeviceProfile** device_pro
     api_enabled_ = api_enabled;
     http_server_ = http_server;
     api_port_ = api_port;
+    thread_placed_ = false;
+
+    // The GL objects of a previous run went away with its context; the new context gets fresh ones.
+    for (PreviewTexture& texture : preview_textures_) texture.Reset();
+    preview_stale_[0] = preview_stale_[1] = true;
+    preview_width_ = preview_height_ = 0;
+    preview_textures_valid_ = false;
 
     if (*device_profile_ptr_) {
         selected_device_type_ = static_cast<int>((*device_profile_ptr_)->type);
     }
 
-    std::cout << "Initializing GUI window..." << std::endl;
+    OX_LOG_INFO("Initializing GUI window...");
     vog::WindowConfig cfg{"ox simulator", 1280, 720};
 
     // No window padding
@@ -63,10 +75,75 @@ bool GuiWindow::Start(SimulatorCore* simulator, const DeviceProfile** device_pro
     theme.vars.window_padding = ImVec2(0, 0);
     cfg.theme = theme;
 
-    return window_.Start(cfg, [this]() { RenderFrame(); });
+    simulator_->SetChangeListener(&GuiWindow::OnSimulatorChanged, this);
+    if (!window_.Start(cfg, [this]() { RenderFrame(); })) {
+        simulator_->SetChangeListener(nullptr, nullptr);
+        return false;
+    }
+    return true;
 }
 
-void GuiWindow::Stop() { window_.Stop(); }
+void GuiWindow::Stop() {
+    if (simulator_) simulator_->SetChangeListener(nullptr, nullptr);
+    if (window_.IsRunning()) {
+        // Let the GUI thread see the close in its next frame and release the preview textures while
+        // its context is still current.
+        glfwSetWindowShouldClose(window_.GetNativeWindow(), GLFW_TRUE);
+        glfwPostEmptyEvent();
+    }
+    window_.Stop();
+}
+
+void GuiWindow::RequestRedraw() {
+    if (!window_.IsRunning()) return;
+    // Coalesce: one posted event is enough until the GUI thread picks it up.
+    if (!redraw_requested_.exchange(true, std::memory_order_acq_rel)) glfwPostEmptyEvent();
+}
+
+void GuiWindow::OnSimulatorChanged(void* context) { static_cast<GuiWindow*>(context)->RequestRedraw(); }
+
+bool GuiWindow::PreviewRefreshDue(double now) const {
+    return g_config.preview_fps <= 0 || now - last_preview_update_ >= 1.0 / g_config.preview_fps;
+}
+
+void GuiWindow::WaitForNextFrame() {
+    constexpr double kIdleTimeout = 1.0;           // keep the session/fps indicators roughly current
+    constexpr double kFramesFlowingWindow = 0.25;  // app frames seen this recently: the preview is live
+    constexpr int kFramesAfterInput = 3;           // let hover/click highlights settle after input
+
+    double now = glfwGetTime();
+    const ImGuiIO& io = ImGui::GetIO();
+    const bool interacting =
+        ImGui::IsAnyItemActive() || io.WantTextInput || ImGui::IsMouseDown(0) || ImGui::IsMouseDown(1);
+
+    if (interacting || active_frames_ > 0) {
+        if (active_frames_ > 0) active_frames_--;
+    } else if (!redraw_requested_.exchange(false, std::memory_order_acq_rel)) {
+        const bool preview_live = now - last_frame_seen_ < kFramesFlowingWindow;
+        double timeout = kIdleTimeout;
+        if (preview_live) {
+            timeout = g_config.preview_fps > 0 ? last_preview_update_ + 1.0 / g_config.preview_fps - now : 0.0;
+        }
+        if (timeout > 0.0) {
+            OX_TRACE_SCOPE("gui", "GuiWindow::WaitForNextFrame");
+            idle_.store(!preview_live, std::memory_order_relaxed);
+            glfwWaitEventsTimeout(timeout);
+            idle_.store(false, std::memory_order_relaxed);
+
+            const double woke = glfwGetTime();
+            const bool requested = redraw_requested_.exchange(false, std::memory_order_acq_rel);
+            // Returned well before the timeout without a request: woken by input. (Timer granularity
+            // can make a timed-out wait return slightly early.)
+            if (!requested && woke - now < timeout * 0.9) active_frames_ = kFramesAfterInput;
+            now = woke;
+        }
+    }
+
+    if (last_redraw_ > 0.0 && now > last_redraw_) {
+        redraw_rate_ += 0.1f * (static_cast<float>(1.0 / (now - last_redraw_)) - redraw_rate_);
+    }
+    last_redraw_ = now;
+}
 
 // ---------------------------------------------------------------------------
 // RenderFrame — pure ImGui widget calls, invoked once per frame by
@@ -74,6 +151,22 @@ void GuiWindow::Stop() { window_.Stop(); }
 // ---------------------------------------------------------------------------
 
 void GuiWindow::RenderFrame() {
+    trace::SetThreadName("gui");
+    if (!thread_placed_) {
+        // vog starts the GUI thread, so it is placed on its first frame.
+        ApplyThreadPlacement(ThreadClass::kGui);
+        thread_placed_ = true;
+    }
+    WaitForNextFrame();
+    if (glfwWindowShouldClose(window_.GetNativeWindow())) {
+        // Last frame before vog leaves the render loop and destroys the GL context.
+        for (PreviewTexture& texture : preview_textures_) texture.Release();
+        preview_textures_valid_ = false;
+        return;
+    }
+    OX_TRACE_SCOPE("gui", "GuiWindow::RenderFrame");
+    const metrics::Clock::time_point frame_start = metrics::Clock::now();
+
     const vog::ThemeColors& tc = vog::Window::GetTheme().colors;
 
     ImGuiIO& io = ImGui::GetIO();
@@ -215,13 +308,15 @@ void GuiWindow::RenderFrame() {
     ImGui::PushStyleColor(ImGuiCol_ChildBg, tc.panel1.value());
     ImGui::BeginChild("Sidebar", ImVec2(sidebar_w_, main_area_h), false);
     {
-        if (*device_profile_ptr_) {
-            const DeviceProfile* profile = *device_profile_ptr_;
+        // All device and input state shown in the panels comes from one snapshot (one lock acquisition).
+        const DeviceProfile* profile = simulator_->GetSnapshot(&snapshot_);
+        if (profile) {
+            if (profile != view_profile_ || ImGui::GetFontSize() != view_font_size_) RebuildViewModel(profile);
             // Use the actual usable width so the panel border always fills edge-to-edge.
             const float inner_w = ImGui::GetContentRegionAvail().x;
-            for (size_t i = 0; i < profile->devices.size(); i++) {
+            for (size_t i = 0; i < device_views_.size() && i < snapshot_.device_count; i++) {
                 if (i > 0) ImGui::Spacing();
-                RenderDevicePanel(profile->devices[i], static_cast<int>(i), inner_w);
+                RenderDevicePanel(device_views_[i], static_cast<int>(i), inner_w);
             }
         }
     }
@@ -239,14 +334,19 @@ void GuiWindow::RenderFrame() {
             FrameData* fd = GetFrameData();
             const bool session_ok = fd && fd->IsSessionActive();
             const uint32_t app_fps = session_ok ? fd->app_fps.load(std::memory_order_relaxed) : 0u;
-            ImGui::Text("Display: %dx%d @ %u fps  |  %s", p->display_width, p->display_height, app_fps,
-                        status_message_.c_str());
+            ImGui::Text("Display: %dx%d @ %u fps  |  GUI: %.1f ms @ %.0f fps  |  %s", p->display_width,
+                        p->display_height, app_fps, frame_time_ms_, redraw_rate_, status_message_.c_str());
         } else {
-            ImGui::Text("%s", status_message_.c_str());
+            ImGui::Text("GUI: %.1f ms @ %.0f fps  |  %s", frame_time_ms_, redraw_rate_, status_message_.c_str());
         }
         ImGui::Unindent(5.0f);
     }
     ImGui::EndChild();
+
+    const metrics::Clock::duration elapsed = metrics::Clock::now() - frame_start;
+    g_gui_frame_duration.Observe(elapsed);
+    const float elapsed_ms = std::chrono::duration<float, std::milli>(elapsed).count();
+    frame_time_ms_ += 0.1f * (elapsed_ms - frame_time_ms_);
 }
 
 void GuiWindow::RenderFramePreview() {
@@ -314,18 +414,20 @@ void GuiWindow::RenderFramePreview() {
                 w_each = h_each * aspect;
             }
             const float y_off = (avail.y - h_each) * 0.5f;
+            preview_display_w_ = w_each;
+            preview_display_h_ = h_each;
             const float left_x = std::max(0.0f, avail.x * 0.5f - w_each);
             const float right_x = left_x + w_each;
             ImGui::SetCursorPos(ImVec2(left_x, y_off));
-            if (preview_textures_[0]) {
-                ImGui::Image((ImTextureID)(intptr_t)preview_textures_[0], ImVec2(w_each, h_each), ImVec2(0, 1),
+            if (preview_textures_[0].id()) {
+                ImGui::Image((ImTextureID)(intptr_t)preview_textures_[0].id(), ImVec2(w_each, h_each), ImVec2(0, 1),
                              ImVec2(1, 0), ImVec4(1, 1, 1, 1), tc.border.value());
             } else {
                 ImGui::Dummy(ImVec2(w_each, h_each));
             }
             ImGui::SetCursorPos(ImVec2(right_x, y_off));
-            if (preview_textures_[1]) {
-                ImGui::Image((ImTextureID)(intptr_t)preview_textures_[1], ImVec2(w_each, h_each), ImVec2(0, 1),
+            if (preview_textures_[1].id()) {
+                ImGui::Image((ImTextureID)(intptr_t)preview_textures_[1].id(), ImVec2(w_each, h_each), ImVec2(0, 1),
                              ImVec2(1, 0), ImVec4(1, 1, 1, 1), tc.border.value());
             } else {
                 ImGui::Dummy(ImVec2(w_each, h_each));
@@ -333,7 +435,7 @@ void GuiWindow::RenderFramePreview() {
         } else {
             const int eye = (preview_eye_selection_ == 1) ? 1 : 0;
             const char* no_msg = (eye == 1) ? "No image received (right eye)" : "No image received (left eye)";
-            if (preview_textures_[eye]) {
+            if (preview_textures_[eye].id()) {
                 const float aspect = (float)preview_width_ / (float)preview_height_;
                 float img_w = avail.x;
                 float img_h = img_w / aspect;
@@ -341,10 +443,12 @@ void GuiWindow::RenderFramePreview() {
                     img_h = avail.y;
                     img_w = img_h * aspect;
                 }
+                preview_display_w_ = img_w;
+                preview_display_h_ = img_h;
                 const float x_off = (avail.x - img_w) * 0.5f;
                 const float y_off = (avail.y - img_h) * 0.5f;
                 ImGui::SetCursorPos(ImVec2(x_off, y_off));
-                ImGui::Image((ImTextureID)(intptr_t)preview_textures_[eye], ImVec2(img_w, img_h), ImVec2(0, 1),
+                ImGui::Image((ImTextureID)(intptr_t)preview_textures_[eye].id(), ImVec2(img_w, img_h), ImVec2(0, 1),
                              ImVec2(1, 0), ImVec4(1, 1, 1, 1), tc.border.value());
             } else {
                 ImVec2 ts = ImGui::CalcTextSize(no_msg);
@@ -358,40 +462,119 @@ void GuiWindow::RenderFramePreview() {
 }
 
 void GuiWindow::UpdateFrameTextures() {
+    OX_TRACE_SCOPE("gui", "GuiWindow::UpdateFrameTextures");
     FrameData* frame_data = GetFrameData();
     if (!frame_data) return;
-    if (!frame_data->has_new_frame.load(std::memory_order_acquire)) return;
 
-    std::lock_guard<std::mutex> lock(frame_data->mutex);
-    uint32_t w = frame_data->width;
-    uint32_t h = frame_data->height;
-    if (w == 0 || h == 0) return;
+    // New app frames are picked up at most preview_fps times per second.
+    const double now = glfwGetTime();
+    if (frame_data->has_new_frame.load(std::memory_order_acquire)) {
+        last_frame_seen_ = now;
+        if (PreviewRefreshDue(now)) {
+            frame_data->has_new_frame.store(false, std::memory_order_release);
+            last_preview_update_ = now;
+            preview_stale_[0] = preview_stale_[1] = true;
+        }
+    }
+    const uint32_t factor = PreviewDownsampleFactor();
+    if (factor != preview_factor_) {
+        preview_factor_ = factor;
+        preview_stale_[0] = preview_stale_[1] = true;
+    }
+    const bool shown[2] = {preview_eye_selection_ != 1, preview_eye_selection_ != 0};
+    if (!(shown[0] && preview_stale_[0]) && !(shown[1] && preview_stale_[1])) return;
+
+    // Only the copy into the upload buffers happens under the lock; the GL transfers are issued
+    // after releasing it so the app's next submit isn't held up.
+    bool uploading[2] = {false, false};
+    {
+        ProfiledLock lock(frame_data->mutex);
+        const uint32_t w = frame_data->width;
+        const uint32_t h = frame_data->height;
+        if (w == 0 || h == 0) return;
+
+        for (int eye = 0; eye < 2; ++eye) {
+            if (!shown[eye] || !preview_stale_[eye]) continue;
+            const size_t expected_size = static_cast<size_t>(w) * h * 4;
+            if (!frame_data->pixel_data[eye] || frame_data->data_size[eye] != expected_size) {
+                preview_stale_[eye] = false;  // nothing to show until the next frame
+                continue;
+            }
+
+            uint8_t* dst = preview_textures_[eye].BeginUpload(w, h, factor);
+            if (!dst) continue;  // all upload buffers busy; retried next frame
+            PreviewTexture::CopyDownsampled(frame_data->pixel_data[eye], w, h, factor, dst);
+            uploading[eye] = true;
+            preview_stale_[eye] = false;
+        }
+        preview_width_ = w;
+        preview_height_ = h;
+    }
 
     for (int eye = 0; eye < 2; ++eye) {
-        if (!frame_data->pixel_data[eye]) continue;
-        size_t expected_size = w * h * 4;
-        if (frame_data->data_size[eye] != expected_size) continue;
-
-        if (!preview_textures_[eye]) {
-            glGenTextures(1, &preview_textures_[eye]);
-            glBindTexture(GL_TEXTURE_2D, preview_textures_[eye]);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            std::cout << "[GUI] Created OpenGL texture " << preview_textures_[eye] << " for eye " << eye << std::endl;
+        if (!uploading[eye]) continue;
+        preview_textures_[eye].EndUpload();
+        preview_textures_valid_ = true;
+    }
+}
+
+// Largest power-of-two factor (up to 8) that keeps the texture at least as large as the image on
+// screen, or 1 when downsampling is disabled or nothing has been laid out yet.
+uint32_t GuiWindow::PreviewDownsampleFactor() const {
+    if (!g_config.preview_downsample || preview_width_ == 0 || preview_height_ == 0) return 1;
+    const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
+    const float display_w = preview_display_w_ * scale.x;
+    const float display_h = preview_display_h_ * scale.y;
+    if (display_w < 1.0f || display_h < 1.0f) return 1;
+
+    uint32_t factor = 1;
+    while (factor < 8 && preview_width_ / (factor * 2) >= display_w && preview_height_ / (factor * 2) >= display_h) {
+        factor *= 2;
+    }
+    return factor;
+}
+
+void GuiWindow::RebuildViewModel(const DeviceProfile* profile) {
+    OX_TRACE_SCOPE("gui", "GuiWindow::RebuildViewModel");
+    const float colon_w = ImGui::CalcTextSize(":").x;
+    device_views_.clear();
+    device_views_.reserve(profile->devices.size());
+    for (const DeviceDef& device : profile->devices) {
+        DeviceView view;
+        view.def = &device;
+        for (uint32_t index = 0; index < device.components.size(); index++) {
+            const ComponentDef& comp = device.components[index];
+            // Filter out hand-restricted components that don't match the device's user_path.
+            if (comp.hand_restriction != nullptr && std::strcmp(comp.hand_restriction, device.user_path) != 0) {
+                continue;
+            }
+            // Hide VEC2 "parent" components whose x/y axes are exposed as linked FLOATs (those are
+            // edited through the individual axis sliders, not as a 2D widget).
+            if (comp.type == ComponentType::VEC2) {
+                bool has_linked_axes = false;
+                for (const auto& c : device.components) {
+                    if (c.linked_vec2_path != nullptr && std::strcmp(c.linked_vec2_path, comp.path) == 0) {
+                        has_linked_axes = true;
+                        break;
+                    }
+                }
+                if (has_linked_axes) continue;
+            }
+            const float label_w = ImGui::CalcTextSize(comp.description).x + colon_w;
+            view.components.push_back({&comp, index, label_w});
+            view.label_col_w = std::max(view.label_col_w, label_w);
         }
-        glBindTexture(GL_TEXTURE_2D, preview_textures_[eye]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, frame_data->pixel_data[eye]);
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    preview_width_ = w;
-    preview_height_ = h;
-    preview_textures_valid_ = true;
-    frame_data->has_new_frame.store(false, std::memory_order_release);
+        view.label_col_w += 20.0f;  // gap between right edge of label and left edge of control
+        device_views_.push_back(std::move(view));
+    }
+    view_profile_ = profile;
+    view_font_size_ = ImGui::GetFontSize();
 }
 
-void GuiWindow::RenderDevicePanel(const DeviceDef& device, int device_index, float panel_width) {
+void GuiWindow::RenderDevicePanel(DeviceView& view, int device_index, float panel_width) {
     using vog::widgets::ShowItemTooltip;
     const vog::ThemeColors& tc = vog::Window::GetTheme().colors;
+    const DeviceDef& device = *view.def;
     ImGui::PushID(device_index);
 
     ImDrawList* draw_list = ImGui::GetWindowDrawList();
@@ -406,15 +589,14 @@ void GuiWindow::RenderDevicePanel(const DeviceDef& device, int device_index, flo
     // Capture window-relative X so all columns can be rooted consistently.
     const float content_start_x = ImGui::GetCursorPosX();
 
-    std::string device_label = std::string(device.role);
-    ImGui::TextColored(tc.accent.value(), "%s", device_label.c_str());
+    ImGui::TextColored(tc.accent.value(), "%s", device.role);
     ImGui::SameLine();
     ImGui::TextColored(tc.text_muted.value(), "(%s)", device.user_path);
     ImGui::Separator();
 
-    bool is_active = false;
-    OxPose pose = {{0, 0, 0}, {0, 0, 0, 1}};
-    simulator_->GetDevicePose(device.user_path, &pose, &is_active);
+    const OxDeviceState& state = snapshot_.devices[device_index];
+    bool is_active = state.is_active != 0;
+    OxPose pose = state.pose;
 
     if (!device.always_active) {
         bool active_toggle = is_active;
@@ -455,7 +637,7 @@ void GuiWindow::RenderDevicePanel(const DeviceDef& device, int device_index, flo
     ImGui::AlignTextToFramePadding();
     ImGui::Text("Rotation:");
     ImGui::SameLine(content_start_x + pos_lbl_col);
-    RenderRotationControl(device, device_index, pose, is_active);
+    RenderRotationControl(view, pose, is_active);
 
     ImGui::Spacing();
     if (ImGui::Button("Reset Pose", ImVec2(ImGui::GetContentRegionAvail().x - pad, 0))) {
@@ -463,40 +645,14 @@ void GuiWindow::RenderDevicePanel(const DeviceDef& device, int device_index, flo
     }
 
     // ---- Input Components ----
-    // Predicate: should this component be shown in the UI for this device?
-    //   - Filters out hand-restricted components that don't match the device's user_path.
-    //   - Hides VEC2 "parent" components whose x/y axes are exposed as linked FLOATs
-    //     (those should be edited through the individual axis sliders, not as a 2D widget).
-    auto ShouldShowComponent = [&](const ComponentDef& comp) -> bool {
-        // Hand restriction check
-        if (comp.hand_restriction != nullptr && std::strcmp(comp.hand_restriction, device.user_path) != 0) return false;
-        // Hide VEC2 components that have linked FLOAT axis children
-        if (comp.type == ComponentType::VEC2) {
-            for (const auto& c : device.components) {
-                if (c.linked_vec2_path != nullptr && std::strcmp(c.linked_vec2_path, comp.path) == 0) return false;
-            }
-        }
-        return true;
-    };
-
-    // Collect visible components and compute the label column width in one pass.
-    std::vector<const ComponentDef*> visible_comps;
-    float label_col_w = 0.0f;
-    for (const auto& comp : device.components) {
-        if (!ShouldShowComponent(comp)) continue;
-        visible_comps.push_back(&comp);
-        float lw = ImGui::CalcTextSize(comp.description).x + ImGui::CalcTextSize(":").x;
-        if (lw > label_col_w) label_col_w = lw;
-    }
-    label_col_w += 20.0f;  // gap between right edge of label and left edge of control
-
-    if (!visible_comps.empty()) {
+    if (!view.components.empty()) {
         ImGui::Spacing();
         ImGui::Separator();
         ImGui::TextColored(tc.warning.value(), "Input Components");
         ImGui::Spacing();
-        for (const ComponentDef* comp : visible_comps) {
-            RenderComponentControl(device, *comp, device_index, label_col_w, content_start_x);
+        const DeviceInputState& inputs = snapshot_.device_inputs[device_index];
+        for (const ComponentView& comp : view.components) {
+            RenderComponentControl(view, comp, inputs, view.label_col_w, content_start_x);
         }
     }
 
@@ -513,49 +669,53 @@ void GuiWindow::RenderDevicePanel(const DeviceDef& device, int device_index, flo
     ImGui::PopID();
 }
 
-void GuiWindow::RenderComponentControl(const DeviceDef& device, const ComponentDef& component, int device_index,
-                                       float label_col_w, float content_start_x) {
-    ImGui::PushID(component.path);
+void GuiWindow::RenderComponentControl(const DeviceView& view, const ComponentView& component,
+                                       const DeviceInputState& inputs, float label_col_w, float content_start_x) {
+    const DeviceDef& device = *view.def;
+    const ComponentDef& def = *component.def;
+    ImGui::PushID(def.path);
 
     // Right-align the label text within the label column.
-    const float lw = ImGui::CalcTextSize(component.description).x + ImGui::CalcTextSize(":").x;
-    ImGui::SetCursorPosX(content_start_x + label_col_w - lw);
+    ImGui::SetCursorPosX(content_start_x + label_col_w - component.label_w);
     ImGui::AlignTextToFramePadding();
-    ImGui::Text("%s:", component.description);
+    ImGui::Text("%s:", def.description);
     ImGui::SameLine(content_start_x + label_col_w);
 
-    switch (component.type) {
+    // Values in the snapshot always hold the component's own type (see SimulatorCore::Initialize).
+    const InputValue* state = component.index < inputs.values.size() ? &inputs.values[component.index] : nullptr;
+
+    switch (def.type) {
         case ComponentType::BOOLEAN: {
-            bool value = false;
-            simulator_->GetInputStateBoolean(device.user_path, component.path, &value);
+            const bool* stored = state ? std::get_if<bool>(state) : nullptr;
+            bool value = stored ? *stored : false;
             // Use empty label so no label text is rendered (we already drew the description above).
             if (vog::widgets::ToggleButton("", &value)) {
-                simulator_->SetInputStateBoolean(device.user_path, component.path, value);
+                simulator_->SetInputStateBoolean(device.user_path, def.path, value);
             }
             break;
         }
         case ComponentType::FLOAT: {
-            float value = 0.0f;
-            simulator_->GetInputStateFloat(device.user_path, component.path, &value);
+            const float* stored = state ? std::get_if<float>(state) : nullptr;
+            float value = stored ? *stored : 0.0f;
             // Linked axis components (thumbstick/trackpad x-y) have a -1..1 range;
             // all other FLOAT components (triggers, grips) use 0..1.
-            const float v_min = (component.linked_vec2_path != nullptr) ? -1.0f : 0.0f;
+            const float v_min = (def.linked_vec2_path != nullptr) ? -1.0f : 0.0f;
             ImGui::SetNextItemWidth(150.0f);
             if (ImGui::SliderFloat("##value", &value, v_min, 1.0f, "%.2f")) {
-                simulator_->SetInputStateFloat(device.user_path, component.path, value);
+                simulator_->SetInputStateFloat(device.user_path, def.path, value);
             }
             break;
         }
         case ComponentType::VEC2: {
             // Standalone VEC2 (no linked FLOAT axes); show as a double-width slider pair.
-            OxVector2f value = {0.0f, 0.0f};
-            simulator_->GetInputStateVec2(device.user_path, component.path, &value);
+            const OxVector2f* stored = state ? std::get_if<OxVector2f>(state) : nullptr;
+            OxVector2f value = stored ? *stored : OxVector2f{0.0f, 0.0f};
             float vec2[2] = {value.x, value.y};
             ImGui::SetNextItemWidth(100.0f * 2.0f + ImGui::GetStyle().ItemInnerSpacing.x);
             if (ImGui::SliderFloat2("##vec2", vec2, -1.0f, 1.0f, "%.2f")) {
                 value.x = vec2[0];
                 value.y = vec2[1];
-                simulator_->SetInputStateVec2(device.user_path, component.path, value);
+                simulator_->SetInputStateVec2(device.user_path, def.path, value);
             }
             break;
         }
@@ -566,16 +726,13 @@ void GuiWindow::RenderComponentControl(const DeviceDef& device, const ComponentD
 }
 
 // Rotation control with gimbal-lock-free incremental updates via cached Euler angles per device.
-void GuiWindow::RenderRotationControl(const DeviceDef& device, int device_index, OxPose& pose, bool is_active) {
-    const std::string key = std::string(device.user_path) + "_" + std::to_string(device_index);
-    auto it = euler_cache_.find(key);
-    if (it == euler_cache_.end()) {
-        EulerCache ec;
+void GuiWindow::RenderRotationControl(DeviceView& view, OxPose& pose, bool is_active) {
+    EulerCache& ec = view.euler;
+    if (!view.euler_valid) {
         ec.quat = pose.orientation;
         QuatToEuler(pose.orientation, ec.euler);
-        euler_cache_[key] = ec;
+        view.euler_valid = true;
     }
-    auto& ec = euler_cache_[key];
 
     // If the quaternion changed externally (Reset Pose / API), re-derive Euler.
     if (ec.quat.x != pose.orientation.x || ec.quat.y != pose.orientation.y || ec.quat.z != pose.orientation.z ||
@@ -603,7 +760,7 @@ void GuiWindow::RenderRotationControl(const DeviceDef& device, int device_index,
 
         ec.euler = {rot[0], rot[1], rot[2]};
         ec.quat = q;
-        simulator_->SetDevicePose(device.user_path, pose, is_active);
+        simulator_->SetDevicePose(view.def->user_path, pose, is_active);
     }
 }
 
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
+#include "preview_texture.h"
 #include "simulator_core.h"
 #include "vog.h"
 
@@ -13,6 +15,9 @@ class HttpServer;  // forward declaration
 
 class GuiWindow {
    public:
+    // False for the headless-only build's stub (src/gui/headless/gui_window.h).
+    static constexpr bool kAvailable = true;
+
     GuiWindow();
     ~GuiWindow();
 
@@ -28,28 +33,59 @@ class GuiWindow {
 
     bool IsRunning() const { return window_.IsRunning(); }
 
+    // Wake the GUI thread so it redraws soon. Safe to call from any thread.
+    void RequestRedraw();
+
+    // Called by the driver for every submitted frame. Only wakes the GUI when it is idle; while
+    // frames keep coming it refreshes the preview on its own schedule (preview_fps).
+    void NotifyFrameSubmitted() {
+        if (idle_.load(std::memory_order_relaxed)) RequestRedraw();
+    }
+
    private:
     // ImGui widget callback — called once per frame by vog::Window.
     void RenderFrame();
 
-    void RenderDevicePanel(const DeviceDef& device, int device_index, float panel_width);
-    void RenderComponentControl(const DeviceDef& device, const ComponentDef& component, int device_index,
+    // Block the GUI thread until there is something to draw: input, a simulator state change, the
+    // next preview refresh, or the idle status refresh. Called at the start of every frame.
+    void WaitForNextFrame();
+    bool PreviewRefreshDue(double now) const;
+    static void OnSimulatorChanged(void* context);
+
+    // Euler cache for rotation UI
+    struct EulerCache {
+        OxVector3f euler;  // x=roll, y=pitch, z=yaw in degrees
+        OxQuaternion quat;
+    };
+
+    // Per-profile UI model, built once when the device profile (or font size) changes so the panels
+    // don't re-filter components or re-measure labels every frame.
+    struct ComponentView {
+        const ComponentDef* def;
+        uint32_t index;  // into DeviceInputState::values
+        float label_w;   // width of "<description>:"
+    };
+    struct DeviceView {
+        const DeviceDef* def;
+        std::vector<ComponentView> components;  // visible components only
+        float label_col_w = 0.0f;
+        EulerCache euler{};
+        bool euler_valid = false;
+    };
+
+    void RebuildViewModel(const DeviceProfile* profile);
+    void RenderDevicePanel(DeviceView& view, int device_index, float panel_width);
+    void RenderComponentControl(const DeviceView& view, const ComponentView& component, const DeviceInputState& inputs,
                                 float label_col_w, float content_start_x);
-    void RenderRotationControl(const DeviceDef& device, int device_index, OxPose& pose, bool is_active);
+    void RenderRotationControl(DeviceView& view, OxPose& pose, bool is_active);
     void RenderFramePreview();
     void UpdateFrameTextures();
+    uint32_t PreviewDownsampleFactor() const;
 
     // Utility functions for rotation handling
     static void QuatToEuler(const OxQuaternion& q, OxVector3f& euler);
     static void ApplyRotation(OxQuaternion& q, const OxVector3f& axis, float angle);
 
-    // Euler cache for rotation UI
-    struct EulerCache {
-        OxVector3f euler;  // x=roll, y=pitch, z=yaw in degrees
-        OxQuaternion quat;
-    };
-    std::unordered_map<std::string, EulerCache> euler_cache_;
-
     vog::Window window_;
 
     SimulatorCore* simulator_ = nullptr;
@@ -58,18 +94,40 @@ class GuiWindow {
     HttpServer* http_server_ = nullptr;
     int api_port_ = 8765;
 
+    // Device panels: view model and the state snapshot read once per frame
+    std::vector<DeviceView> device_views_;
+    const DeviceProfile* view_profile_ = nullptr;
+    float view_font_size_ = 0.0f;
+    DeviceState snapshot_{};
+
     // UI state
     int selected_device_type_ = 0;
     int preview_eye_selection_ = 0;
     std::string status_message_{"Ready"};
     float sidebar_w_{360.0f};           // resizable via splitter drag
     bool last_splitter_active_{false};  // true if splitter was being dragged last frame
+    bool thread_placed_ = false;        // thread placement applied to the current GUI thread
 
-    // Frame preview textures (OpenGL texture IDs)
-    uint32_t preview_textures_[2] = {0, 0};
-    uint32_t preview_width_ = 0;
+    // Frame preview textures. Only the eye(s) on screen are uploaded; the other is marked stale and
+    // refreshed when it is selected.
+    PreviewTexture preview_textures_[2];
+    bool preview_stale_[2] = {true, true};
+    uint32_t preview_width_ = 0;  // source frame size
     uint32_t preview_height_ = 0;
+    uint32_t preview_factor_ = 1;     // CPU downsample factor of the textures
+    float preview_display_w_ = 0.0f;  // on-screen size of one eye image last frame, in pixels
+    float preview_display_h_ = 0.0f;
     bool preview_textures_valid_ = false;
+
+    // Redraw scheduling (see WaitForNextFrame)
+    std::atomic<bool> redraw_requested_{false};
+    std::atomic<bool> idle_{false};     // waiting with no app frames coming in
+    int active_frames_ = 0;             // frames still to draw without waiting, after input
+    double last_frame_seen_ = -1.0;     // glfwGetTime() when a new app frame was last seen
+    double last_preview_update_ = 0.0;  // glfwGetTime() of the last preview refresh
+    double last_redraw_ = 0.0;
+    float frame_time_ms_ = 0.0f;  // smoothed CPU time of RenderFrame
+    float redraw_rate_ = 0.0f;    // smoothed GUI redraws per second
 };
 
 }  // namespace ox_sim
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "simulator_core.h"
+
+namespace ox_sim {
+
+class HttpServer;  // forward declaration
+
+// Stand-in for GuiWindow in the headless-only build (OX_SIM_HEADLESS): the same interface without
+// OpenGL, GLFW or ImGui. Start() always fails; the driver runs headless instead.
+class GuiWindow {
+   public:
+    static constexpr bool kAvailable = false;
+
+    bool Start(SimulatorCore* /*simulator*/, const DeviceProfile** /*device_profile_ptr*/, bool* /*api_enabled*/,
+               HttpServer* /*http_server*/, int /*api_port*/) {
+        return false;
+    }
+    void Stop() {}
+    bool IsRunning() const { return false; }
+    void RequestRedraw() {}
+    void NotifyFrameSubmitted() {}
+};
+
+}  // namespace ox_sim
@@ -0,0 +1,284 @@
+#include "preview_texture.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "log.h"
+#include "trace.h"
+
+// The platform GL headers only guarantee OpenGL 1.1 (Windows), so the buffer and sync entry points
+// are loaded through GLFW and the few enums needed are defined here.
+#ifdef _WIN32
+#define OX_GL_APIENTRY __stdcall
+#else
+#define OX_GL_APIENTRY
+#endif
+
+namespace ox_sim {
+
+namespace {
+
+constexpr GLenum kPixelUnpackBuffer = 0x88EC;  // GL_PIXEL_UNPACK_BUFFER
+constexpr GLenum kStreamDraw = 0x88E0;         // GL_STREAM_DRAW
+constexpr GLenum kRGB8 = 0x8051;               // GL_RGB8
+constexpr GLbitfield kMapWriteBit = 0x0002;
+constexpr GLbitfield kMapInvalidateBufferBit = 0x0008;
+constexpr GLbitfield kMapPersistentBit = 0x0040;
+constexpr GLbitfield kMapCoherentBit = 0x0080;
+constexpr GLenum kSyncGpuCommandsComplete = 0x9117;
+constexpr GLenum kAlreadySignaled = 0x911A;
+constexpr GLenum kConditionSatisfied = 0x911C;
+
+// GLsync is an opaque pointer; GLsizeiptr/GLintptr are pointer-sized.
+struct GlFunctions {
+    void(OX_GL_APIENTRY* GenBuffers)(GLsizei, GLuint*) = nullptr;
+    void(OX_GL_APIENTRY* DeleteBuffers)(GLsizei, const GLuint*) = nullptr;
+    void(OX_GL_APIENTRY* BindBuffer)(GLenum, GLuint) = nullptr;
+    void(OX_GL_APIENTRY* BufferData)(GLenum, std::ptrdiff_t, const void*, GLenum) = nullptr;
+    void(OX_GL_APIENTRY* BufferStorage)(GLenum, std::ptrdiff_t, const void*, GLbitfield) = nullptr;
+    void*(OX_GL_APIENTRY* MapBufferRange)(GLenum, std::ptrdiff_t, std::ptrdiff_t, GLbitfield) = nullptr;
+    GLboolean(OX_GL_APIENTRY* UnmapBuffer)(GLenum) = nullptr;
+    void(OX_GL_APIENTRY* TexStorage2D)(GLenum, GLsizei, GLenum, GLsizei, GLsizei) = nullptr;
+    void*(OX_GL_APIENTRY* FenceSync)(GLenum, GLbitfield) = nullptr;
+    GLenum(OX_GL_APIENTRY* ClientWaitSync)(void*, GLbitfield, uint64_t) = nullptr;
+    void(OX_GL_APIENTRY* DeleteSync)(void*) = nullptr;
+
+    bool HasBuffers() const {
+        return GenBuffers && DeleteBuffers && BindBuffer && BufferData && MapBufferRange && UnmapBuffer;
+    }
+    bool HasPersistent() const { return HasBuffers() && BufferStorage && FenceSync && ClientWaitSync && DeleteSync; }
+};
+
+template <typename T>
+void Load(T& fn, const char* name) {
+    fn = reinterpret_cast<T>(glfwGetProcAddress(name));
+}
+
+// Loaded on first use; the GUI thread is the only caller.
+const GlFunctions& GL() {
+    static const GlFunctions fns = [] {
+        GlFunctions f;
+        Load(f.GenBuffers, "glGenBuffers");
+        Load(f.DeleteBuffers, "glDeleteBuffers");
+        Load(f.BindBuffer, "glBindBuffer");
+        Load(f.BufferData, "glBufferData");
+        Load(f.BufferStorage, "glBufferStorage");
+        Load(f.MapBufferRange, "glMapBufferRange");
+        Load(f.UnmapBuffer, "glUnmapBuffer");
+        Load(f.TexStorage2D, "glTexStorage2D");
+        Load(f.FenceSync, "glFenceSync");
+        Load(f.ClientWaitSync, "glClientWaitSync");
+        Load(f.DeleteSync, "glDeleteSync");
+
+        // Some platforms return entry points the context doesn't support, so gate on the version.
+        int major = 0, minor = 0;
+        if (const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION))) {
+            std::sscanf(version, "%d.%d", &major, &minor);
+        }
+        const int v = major * 10 + minor;
+        if (v < 44) f.BufferStorage = nullptr;
+        if (v < 42) f.TexStorage2D = nullptr;
+        if (v < 32) f.FenceSync = nullptr;
+        if (v < 30) f.MapBufferRange = nullptr;
+        return f;
+    }();
+    return fns;
+}
+
+}  // namespace
+
+uint8_t* PreviewTexture::BeginUpload(uint32_t src_width, uint32_t src_height, uint32_t factor) {
+    if (factor == 0) factor = 1;
+    const uint32_t width = src_width / factor;
+    const uint32_t height = src_height / factor;
+    if (width == 0 || height == 0) return nullptr;
+    if (width != width_ || height != height_ || !texture_) Allocate(width, height);
+
+    switch (mode_) {
+        case Mode::kPersistent: {
+            // The slot's previous transfer was issued kRingSize uploads ago and has almost always
+            // finished; if not, drop this frame rather than stall the GUI thread.
+            if (void* fence = fences_[slot_]) {
+                const GLenum status = GL().ClientWaitSync(fence, 0, 0);
+                if (status != kAlreadySignaled && status != kConditionSatisfied) return nullptr;
+                GL().DeleteSync(fence);
+                fences_[slot_] = nullptr;
+            }
+            uploading_ = true;
+            return persistent_ptr_ + static_cast<size_t>(slot_) * frame_bytes_;
+        }
+        case Mode::kMapped: {
+            // Invalidating the whole buffer lets the driver hand out fresh memory instead of waiting
+            // for a transfer still reading the old contents.
+            GL().BindBuffer(kPixelUnpackBuffer, buffers_[slot_]);
+            void* ptr = GL().MapBufferRange(kPixelUnpackBuffer, 0, static_cast<std::ptrdiff_t>(frame_bytes_),
+                                            kMapWriteBit | kMapInvalidateBufferBit);
+            GL().BindBuffer(kPixelUnpackBuffer, 0);
+            if (!ptr) return nullptr;
+            uploading_ = true;
+            return static_cast<uint8_t*>(ptr);
+        }
+        case Mode::kDirect:
+        default:
+            uploading_ = true;
+            return staging_.data();
+    }
+}
+
+void PreviewTexture::EndUpload() {
+    if (!uploading_) return;
+    uploading_ = false;
+    OX_TRACE_SCOPE("gui", "PreviewTexture::EndUpload");
+
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    switch (mode_) {
+        case Mode::kPersistent: {
+            // Coherent mapping: the writes are visible to the copy without an explicit flush.
+            GL().BindBuffer(kPixelUnpackBuffer, buffers_[0]);
+            const size_t offset = static_cast<size_t>(slot_) * frame_bytes_;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+                            reinterpret_cast<const void*>(offset));
+            GL().BindBuffer(kPixelUnpackBuffer, 0);
+            fences_[slot_] = GL().FenceSync(kSyncGpuCommandsComplete, 0);
+            break;
+        }
+        case Mode::kMapped:
+            GL().BindBuffer(kPixelUnpackBuffer, buffers_[slot_]);
+            GL().UnmapBuffer(kPixelUnpackBuffer);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            GL().BindBuffer(kPixelUnpackBuffer, 0);
+            break;
+        case Mode::kDirect:
+        default:
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, staging_.data());
+            break;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    slot_ = (slot_ + 1) % kRingSize;
+}
+
+void PreviewTexture::Allocate(uint32_t width, uint32_t height) {
+    Release();
+    const GlFunctions& gl = GL();
+    width_ = width;
+    height_ = height;
+    frame_bytes_ = static_cast<size_t>(width) * height * 4;
+
+    // The alpha channel of submitted frames is not meaningful, so the texture is RGB.
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (gl.TexStorage2D) {
+        gl.TexStorage2D(GL_TEXTURE_2D, 1, kRGB8, width, height);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    mode_ = Mode::kDirect;
+    if (gl.HasPersistent()) {
+        const GLbitfield flags = kMapWriteBit | kMapPersistentBit | kMapCoherentBit;
+        const std::ptrdiff_t ring_bytes = static_cast<std::ptrdiff_t>(frame_bytes_ * kRingSize);
+        gl.GenBuffers(1, &buffers_[0]);
+        gl.BindBuffer(kPixelUnpackBuffer, buffers_[0]);
+        gl.BufferStorage(kPixelUnpackBuffer, ring_bytes, nullptr, flags);
+        persistent_ptr_ = static_cast<uint8_t*>(gl.MapBufferRange(kPixelUnpackBuffer, 0, ring_bytes, flags));
+        gl.BindBuffer(kPixelUnpackBuffer, 0);
+        if (persistent_ptr_) {
+            mode_ = Mode::kPersistent;
+        } else {
+            gl.DeleteBuffers(1, &buffers_[0]);
+            buffers_[0] = 0;
+        }
+    }
+    if (mode_ == Mode::kDirect && gl.HasBuffers()) {
+        gl.GenBuffers(kRingSize, buffers_);
+        for (uint32_t buffer : buffers_) {
+            gl.BindBuffer(kPixelUnpackBuffer, buffer);
+            gl.BufferData(kPixelUnpackBuffer, static_cast<std::ptrdiff_t>(frame_bytes_), nullptr, kStreamDraw);
+        }
+        gl.BindBuffer(kPixelUnpackBuffer, 0);
+        mode_ = Mode::kMapped;
+    }
+    if (mode_ == Mode::kDirect) staging_.resize(frame_bytes_);
+
+    static const char* const kModeNames[] = {"persistent PBO", "mapped PBO", "direct"};
+    OX_LOG_DEBUG("[GUI] Allocated %ux%u preview texture %u (%s upload)", width, height, texture_,
+                 kModeNames[static_cast<int>(mode_)]);
+}
+
+void PreviewTexture::Release() {
+    const GlFunctions& gl = GL();
+    for (void*& fence : fences_) {
+        if (fence) gl.DeleteSync(fence);
+        fence = nullptr;
+    }
+    if (persistent_ptr_) {
+        gl.BindBuffer(kPixelUnpackBuffer, buffers_[0]);
+        gl.UnmapBuffer(kPixelUnpackBuffer);
+        gl.BindBuffer(kPixelUnpackBuffer, 0);
+        persistent_ptr_ = nullptr;
+    }
+    for (uint32_t& buffer : buffers_) {
+        if (buffer) gl.DeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    if (texture_) glDeleteTextures(1, &texture_);
+    Reset();
+}
+
+void PreviewTexture::Reset() {
+    mode_ = Mode::kDirect;
+    texture_ = 0;
+    width_ = height_ = 0;
+    frame_bytes_ = 0;
+    for (int i = 0; i < kRingSize; ++i) {
+        buffers_[i] = 0;
+        fences_[i] = nullptr;
+    }
+    persistent_ptr_ = nullptr;
+    staging_.clear();
+    staging_.shrink_to_fit();
+    slot_ = 0;
+    uploading_ = false;
+}
+
+void PreviewTexture::CopyDownsampled(const void* src, uint32_t src_width, uint32_t src_height, uint32_t factor,
+                                     uint8_t* dst) {
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    if (factor <= 1) {
+        std::memcpy(dst, in, static_cast<size_t>(src_width) * src_height * 4);
+        return;
+    }
+
+    const uint32_t width = src_width / factor;
+    const uint32_t height = src_height / factor;
+    const size_t src_stride = static_cast<size_t>(src_width) * 4;
+    const uint32_t area = factor * factor;
+    static thread_local std::vector<uint32_t> sums;
+    sums.resize(static_cast<size_t>(width) * 4);
+    for (uint32_t y = 0; y < height; y++) {
+        std::fill(sums.begin(), sums.end(), 0u);
+        for (uint32_t row = 0; row < factor; row++) {
+            const uint8_t* p = in + (static_cast<size_t>(y) * factor + row) * src_stride;
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t* s = &sums[static_cast<size_t>(x) * 4];
+                for (uint32_t i = 0; i < factor; i++, p += 4) {
+                    s[0] += p[0];
+                    s[1] += p[1];
+                    s[2] += p[2];
+                    s[3] += p[3];
+                }
+            }
+        }
+        uint8_t* out = dst + static_cast<size_t>(y) * width * 4;
+        for (size_t i = 0; i < sums.size(); i++) out[i] = static_cast<uint8_t>(sums[i] / area);
+    }
+}
+
+}  // namespace ox_sim
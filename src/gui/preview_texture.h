@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ox_sim {
+
+// An eye preview texture fed through a ring of pixel unpack buffers (PBOs).
+//
+// Texture storage is allocated once per size change (glTexStorage2D where available) and updated
+// with glTexSubImage2D from a PBO, so the copy to the GPU happens asynchronously and the caller
+// only pays for a memcpy into mapped memory. Depending on the GL version it uses persistently
+// mapped buffers (4.4), buffers mapped per upload (3.0), or a plain glTexSubImage2D from a CPU
+// staging buffer. All methods must be called on the GUI thread with its GL context current.
+//
+// An upload is split in two so the source can be copied while a lock is held and the GL work is
+// done after releasing it:
+//
+//     if (uint8_t* dst = texture.BeginUpload(w, h, factor)) {
+//         PreviewTexture::CopyDownsampled(src, src_w, src_h, factor, dst);  // under the lock
+//     }
+//     ...unlock...
+//     texture.EndUpload();
+class PreviewTexture {
+   public:
+    PreviewTexture() = default;
+    PreviewTexture(const PreviewTexture&) = delete;
+    PreviewTexture& operator=(const PreviewTexture&) = delete;
+
+    // GL texture name, 0 until the first upload.
+    uint32_t id() const { return texture_; }
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+
+    // Reserve a destination for a source image of src_width x src_height, downsampled by
+    // `factor` (1, 2, 4, ...). Reallocates the texture and buffers if the resulting size changed.
+    // Returns where to write the RGBA pixels (width() * height() * 4 bytes, rows tightly packed),
+    // or nullptr if every buffer is still in use by the GPU; skip the frame in that case.
+    uint8_t* BeginUpload(uint32_t src_width, uint32_t src_height, uint32_t factor);
+
+    // Start the transfer of the pixels written since BeginUpload() into the texture.
+    void EndUpload();
+
+    // Copy src_width x src_height RGBA pixels to dst, averaging factor x factor blocks. Trailing
+    // rows/columns that don't fill a whole block are dropped.
+    static void CopyDownsampled(const void* src, uint32_t src_width, uint32_t src_height, uint32_t factor,
+                                uint8_t* dst);
+
+    // Delete the texture and buffers (unmapping the persistent mapping). Call before the GL context
+    // is destroyed; the next BeginUpload() allocates new ones.
+    void Release();
+
+    // Forget the GL names without deleting them, for when the context that owned them is already
+    // gone. Needs no GL context.
+    void Reset();
+
+   private:
+    static constexpr int kRingSize = 3;
+
+    enum class Mode { kPersistent, kMapped, kDirect };
+
+    void Allocate(uint32_t width, uint32_t height);
+
+    Mode mode_ = Mode::kDirect;
+    uint32_t texture_ = 0;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    size_t frame_bytes_ = 0;
+
+    uint32_t buffers_[kRingSize] = {0, 0, 0};  // one buffer for kPersistent, all three for kMapped
+    uint8_t* persistent_ptr_ = nullptr;        // kPersistent: mapping of the whole ring
+    void* fences_[kRingSize] = {nullptr, nullptr, nullptr};
+    int slot_ = 0;  // ring slot of the upload in progress / the next upload
+    bool uploading_ = false;
+    std::vector<uint8_t> staging_;  // kDirect
+};
+
+}  // namespace ox_sim
@@ -0,0 +1,131 @@
+#include "input_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ox_sim {
+
+namespace {
+
+constexpr double kTwoPi = 6.283185307179586;
+
+// Random walks catch up at most this many steps per sample (e.g. after the app stalled).
+constexpr int64_t kMaxWalkCatchUp = 4096;
+
+// splitmix64: small, seedable and identical on every platform, unlike std:: distributions.
+uint64_t NextRandom(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [-1, 1].
+float RandomSigned(uint64_t* state) {
+    return static_cast<float>(static_cast<double>(NextRandom(state) >> 11) * (2.0 / 9007199254740992.0) - 1.0);
+}
+
+}  // namespace
+
+const char* InputGenerator::ShapeName(Shape shape) {
+    switch (shape) {
+        case Shape::kRamp:
+            return "ramp";
+        case Shape::kSine:
+            return "sine";
+        case Shape::kSquare:
+            return "square";
+        case Shape::kCircle:
+            return "circle";
+        case Shape::kFigureEight:
+            return "figure_eight";
+        case Shape::kRandomWalk:
+            return "random_walk";
+    }
+    return "unknown";
+}
+
+bool InputGenerator::ParseShape(const std::string& name, Shape* out) {
+    static const Shape kShapes[] = {Shape::kRamp,   Shape::kSine,        Shape::kSquare,
+                                    Shape::kCircle, Shape::kFigureEight, Shape::kRandomWalk};
+    for (Shape shape : kShapes) {
+        if (name == ShapeName(shape)) {
+            *out = shape;
+            return true;
+        }
+    }
+    return false;
+}
+
+double InputGenerator::SecondsSinceStart(int64_t predicted_time) {
+    if (start_time_ == INT64_MIN) {
+        start_time_ = predicted_time;
+        walk_steps_ = 0;
+        rng_state_ = seed;
+        walk_value_ = (min + max) * 0.5f;
+        walk_ = center;
+    }
+    return std::max<int64_t>(predicted_time - start_time_, 0) / 1e9;
+}
+
+void InputGenerator::StepWalk(double seconds, bool vec2) {
+    const int64_t target = static_cast<int64_t>(seconds * rate_hz);
+    if (target - walk_steps_ > kMaxWalkCatchUp) walk_steps_ = target - kMaxWalkCatchUp;
+    for (; walk_steps_ < target; walk_steps_++) {
+        if (!vec2) {
+            walk_value_ =
+                std::clamp(walk_value_ + step * RandomSigned(&rng_state_), std::min(min, max), std::max(min, max));
+            continue;
+        }
+        walk_.x += step * RandomSigned(&rng_state_);
+        walk_.y += step * RandomSigned(&rng_state_);
+        const float dx = walk_.x - center.x;
+        const float dy = walk_.y - center.y;
+        const float length = std::sqrt(dx * dx + dy * dy);
+        if (length > radius && length > 0.0f) {
+            walk_.x = center.x + dx * radius / length;
+            walk_.y = center.y + dy * radius / length;
+        }
+    }
+}
+
+float InputGenerator::EvaluateScalar(int64_t predicted_time) {
+    const double seconds = SecondsSinceStart(predicted_time);
+    const double cycles = seconds * frequency_hz + phase;
+    const double fraction = cycles - std::floor(cycles);
+    switch (shape) {
+        case Shape::kRamp:
+            return min + (max - min) * static_cast<float>(fraction);
+        case Shape::kSine:
+            return min + (max - min) * static_cast<float>(0.5 + 0.5 * std::sin(kTwoPi * cycles));
+        case Shape::kSquare:
+            return fraction < duty ? max : min;
+        case Shape::kRandomWalk:
+            StepWalk(seconds, false);
+            return walk_value_;
+        default:
+            return EvaluateVec2(predicted_time).x;
+    }
+}
+
+OxVector2f InputGenerator::EvaluateVec2(int64_t predicted_time) {
+    const double seconds = SecondsSinceStart(predicted_time);
+    const double angle = kTwoPi * (seconds * frequency_hz + phase);
+    switch (shape) {
+        case Shape::kCircle:
+            return {center.x + radius * static_cast<float>(std::cos(angle)),
+                    center.y + radius * static_cast<float>(std::sin(angle))};
+        case Shape::kFigureEight:
+            return {center.x + radius * static_cast<float>(std::sin(angle)),
+                    center.y + radius * static_cast<float>(std::sin(angle) * std::cos(angle))};
+        case Shape::kRandomWalk:
+            StepWalk(seconds, true);
+            return walk_;
+        default: {
+            const float value = EvaluateScalar(predicted_time);
+            return {value, value};
+        }
+    }
+}
+
+}  // namespace ox_sim
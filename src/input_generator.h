@@ -0,0 +1,56 @@
+#pragma once
+
+#include <ox_driver.h>
+
+#include <cstdint>
+#include <string>
+
+namespace ox_sim {
+
+// A periodic or random signal that drives an input component, evaluated at the predicted_time the
+// runtime samples the component at. Time starts at the first sample, so a new generator always
+// begins at phase 0 (plus `phase`).
+struct InputGenerator {
+    enum class Shape {
+        kRamp,         // FLOAT/BOOLEAN: sawtooth from min to max once per period
+        kSine,         // FLOAT/BOOLEAN: min..max
+        kSquare,       // FLOAT/BOOLEAN: max for `duty` of each period, min for the rest
+        kCircle,       // VEC2: center + radius * (cos, sin)
+        kFigureEight,  // VEC2: center + radius * (sin t, sin t cos t)
+        kRandomWalk,   // FLOAT/BOOLEAN within min..max, VEC2 within radius of center
+    };
+
+    Shape shape = Shape::kSine;
+    float min = 0.0f;
+    float max = 1.0f;
+    float frequency_hz = 1.0f;
+    float phase = 0.0f;  // in periods
+    float duty = 0.5f;
+    float radius = 1.0f;
+    OxVector2f center = {0.0f, 0.0f};
+    float step = 0.05f;     // random walk: largest change per step
+    float rate_hz = 90.0f;  // random walk: steps per second
+    uint64_t seed = 1;
+
+    static bool IsVec2Shape(Shape shape) { return shape == Shape::kCircle || shape == Shape::kFigureEight; }
+    static const char* ShapeName(Shape shape);
+    // "ramp", "sine", "square", "circle", "figure_eight" or "random_walk"
+    static bool ParseShape(const std::string& name, Shape* out);
+
+    // Evaluate at `predicted_time` (ns). Random walks only move forward: a time before the last
+    // step returns the current value.
+    float EvaluateScalar(int64_t predicted_time);
+    OxVector2f EvaluateVec2(int64_t predicted_time);
+
+   private:
+    double SecondsSinceStart(int64_t predicted_time);
+    void StepWalk(double seconds, bool vec2);
+
+    int64_t start_time_ = INT64_MIN;  // predicted_time of the first sample
+    int64_t walk_steps_ = 0;
+    uint64_t rng_state_ = 0;
+    float walk_value_ = 0.0f;         // random walk position, FLOAT/BOOLEAN
+    OxVector2f walk_ = {0.0f, 0.0f};  // random walk position, VEC2
+};
+
+}  // namespace ox_sim
@@ -0,0 +1,142 @@
+#include "latency_probe.h"
+
+#include <chrono>
+#include <utility>
+
+#include "log.h"
+#include "metrics.h"
+#include "trace.h"
+
+namespace ox_sim {
+
+static metrics::Histogram g_input_to_photon("ox_input_to_photon_seconds",
+                                            "Time from an injected input to the first frame that visibly reacted");
+
+const char* LatencyProbe::StateName(State state) {
+    switch (state) {
+        case State::kIdle:
+            return "idle";
+        case State::kRunning:
+            return "running";
+        case State::kFinished:
+            return "finished";
+        case State::kFailed:
+            return "failed";
+    }
+    return "unknown";
+}
+
+void LatencyProbe::Start(const LatencyProbeConfig& config, SimulatorCore* simulator) {
+    ProfiledLock lock(mutex_);
+    if (state_ == State::kRunning && waiting_) {
+        SetInput(config_.rest_value);
+    }
+    config_ = config;
+    simulator_ = simulator;
+    state_ = State::kRunning;
+    error_.clear();
+    samples_.clear();
+    timeouts_ = 0;
+    waiting_ = false;
+    settle_left_ = config_.settle_frames;
+    baseline_.resize(config_.region.PixelCount() * 4);
+
+    SetInput(config_.rest_value);
+    active_.store(true, std::memory_order_release);
+    OX_LOG_INFO("Latency probe started: %u trials on %s%s", config_.trials, config_.user_path.c_str(),
+                config_.component_path.c_str());
+}
+
+void LatencyProbe::Stop() {
+    ProfiledLock lock(mutex_);
+    if (state_ != State::kRunning) return;
+    if (waiting_) SetInput(config_.rest_value);
+    Finish(State::kIdle, "");
+    OX_LOG_INFO("Latency probe stopped");
+}
+
+LatencyProbe::Status LatencyProbe::GetStatus() const {
+    ProfiledLock lock(mutex_);
+    Status status;
+    status.state = state_;
+    status.trials = config_.trials;
+    status.timeouts = timeouts_;
+    status.samples = samples_;
+    status.error = error_;
+    return status;
+}
+
+void LatencyProbe::SetInput(const InputValue& value) {
+    const char* user_path = config_.user_path.c_str();
+    const char* component_path = config_.component_path.c_str();
+    switch (config_.type) {
+        case ComponentType::BOOLEAN:
+            simulator_->SetInputStateBoolean(user_path, component_path, std::get<bool>(value));
+            break;
+        case ComponentType::FLOAT:
+            simulator_->SetInputStateFloat(user_path, component_path, std::get<float>(value));
+            break;
+        case ComponentType::VEC2:
+            simulator_->SetInputStateVec2(user_path, component_path, std::get<OxVector2f>(value));
+            break;
+    }
+}
+
+void LatencyProbe::Finish(State state, std::string error) {
+    state_ = state;
+    error_ = std::move(error);
+    waiting_ = false;
+    active_.store(false, std::memory_order_release);
+}
+
+void LatencyProbe::EndTrial() {
+    SetInput(config_.rest_value);
+    waiting_ = false;
+    settle_left_ = config_.settle_frames;
+    if (samples_.size() + timeouts_ >= config_.trials) {
+        OX_LOG_INFO("Latency probe finished: %zu samples, %u timeouts", samples_.size(), timeouts_);
+        Finish(State::kFinished, "");
+    }
+}
+
+void LatencyProbe::ProcessFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels) {
+    OX_TRACE_SCOPE("latency", "ProcessFrame");
+    const int64_t now_ns = trace::NowNs();
+    ProfiledLock lock(mutex_);
+    if (state_ != State::kRunning || eye != config_.eye) return;
+
+    const PixelRect& region = config_.region;
+    if (!region.FitsIn(width, height)) {
+        if (waiting_) SetInput(config_.rest_value);
+        Finish(State::kFailed, "region is outside the " + std::to_string(width) + "x" + std::to_string(height) +
+                                   " frame");
+        return;
+    }
+
+    if (!waiting_) {
+        if (settle_left_ > 0) {
+            settle_left_--;
+            return;
+        }
+        CopyRegionRGBA(pixels, width, height, region, baseline_.data());
+        SetInput(config_.active_value);
+        waiting_ = true;
+        frames_since_injection_ = 0;
+        injected_ns_ = now_ns;
+        return;
+    }
+
+    frames_since_injection_++;
+    const int64_t latency_ns = now_ns - injected_ns_;
+    if (RegionMeanAbsDiff(pixels, width, height, region, baseline_.data()) >= config_.threshold) {
+        samples_.push_back({frames_since_injection_, latency_ns});
+        g_input_to_photon.Observe(std::chrono::nanoseconds(latency_ns));
+        EndTrial();
+    } else if (latency_ns >= config_.timeout_ns) {
+        timeouts_++;
+        OX_LOG_WARN("Latency probe: no change after %u frames", frames_since_injection_);
+        EndTrial();
+    }
+}
+
+}  // namespace ox_sim
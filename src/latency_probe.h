@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pixel_ops.h"
+#include "profiled_mutex.h"
+#include "simulator_core.h"
+
+namespace ox_sim {
+
+// One input-to-photon measurement run: which input to toggle and where on screen to watch for the
+// app's reaction.
+struct LatencyProbeConfig {
+    std::string user_path;       // e.g. "/user/hand/right"
+    std::string component_path;  // e.g. "/input/trigger/value"
+    ComponentType type = ComponentType::FLOAT;
+    InputValue active_value;  // injected at the start of each trial
+    InputValue rest_value;    // restored once the trial has seen its change (or timed out)
+
+    uint32_t eye = 0;
+    PixelRect region;        // GET /v1/views coordinates
+    float threshold = 8.0f;  // mean absolute R/G/B difference (0-255) that counts as a visible change
+    uint32_t trials = 10;
+    uint32_t settle_frames = 10;  // frames to wait after restoring rest_value before the next trial
+    int64_t timeout_ns = 2'000'000'000;
+};
+
+// Measures how long an app takes to visibly react to an input, without a GPU or any app
+// cooperation. Each trial waits `settle_frames` frames, copies the watched region of the current
+// frame as a baseline, injects active_value through SimulatorCore and then compares the region of
+// every later frame of `eye` against the baseline (SumAbsDiffRGB) until the difference reaches
+// the threshold. The delay is recorded in frames and in milliseconds from the injection to the
+// submit of the changed frame; rest_value is then restored.
+class LatencyProbe {
+   public:
+    enum class State { kIdle, kRunning, kFinished, kFailed };
+
+    struct Sample {
+        uint32_t frames;  // frames of `eye` submitted after the injection, including the changed one
+        int64_t latency_ns;
+    };
+
+    struct Status {
+        State state = State::kIdle;
+        uint32_t trials = 0;  // configured
+        uint32_t timeouts = 0;
+        std::vector<Sample> samples;
+        std::string error;  // kFailed
+    };
+
+    LatencyProbe() : mutex_("latency_probe") {}
+
+    // Replace any running measurement; the first trial starts settle_frames frames from now.
+    void Start(const LatencyProbeConfig& config, SimulatorCore* simulator);
+
+    // Stop the running measurement and restore rest_value if a trial was in flight.
+    void Stop();
+
+    Status GetStatus() const;
+
+    // Driver hook, called from submit_frame_pixels with RGBA8 pixels. A single atomic load unless a
+    // measurement is running.
+    void OnFrameSubmitted(uint32_t eye, uint32_t width, uint32_t height, const void* pixels, size_t size) {
+        if (!active_.load(std::memory_order_acquire)) return;
+        if (size < static_cast<size_t>(width) * height * 4) return;
+        ProcessFrame(eye, width, height, static_cast<const uint8_t*>(pixels));
+    }
+
+    static const char* StateName(State state);
+
+   private:
+    void ProcessFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels);
+
+    // Both require mutex_.
+    void SetInput(const InputValue& value);
+    void EndTrial();
+    void Finish(State state, std::string error);
+
+    mutable ProfiledMutex mutex_;
+    std::atomic<bool> active_{false};
+
+    LatencyProbeConfig config_;
+    SimulatorCore* simulator_ = nullptr;
+    State state_ = State::kIdle;
+    std::string error_;
+    std::vector<Sample> samples_;
+    uint32_t timeouts_ = 0;
+
+    // Current trial: counting down settle frames, or waiting for the region to change.
+    bool waiting_ = false;
+    uint32_t settle_left_ = 0;
+    uint32_t frames_since_injection_ = 0;
+    int64_t injected_ns_ = 0;
+    std::vector<uint8_t> baseline_;  // config_.region of the frame before the injection
+};
+
+// Get the driver's latency probe - implemented in driver.cpp
+LatencyProbe* GetLatencyProbe();
+
+}  // namespace ox_sim
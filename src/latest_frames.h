@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "task_pool.h"
+
+namespace ox_sim {
+
+// Hands the newest frame of each eye from the frame submit hook to a background consumer.
+//
+// Each eye has one slot. The hook refills its eye's slot for every frame it keeps, replacing a
+// frame that was not taken yet, so a consumer that falls behind skips frames instead of queueing
+// them. The consumer takes the older of the two pending frames first and works on the taken copy
+// without holding the owner's lock.
+//
+// Given a task pool, it also schedules the consumer: Publish() queues `task` at capture priority
+// unless one is already queued or running, and each task handles one frame and ends with
+// TaskDone(), which queues the next task while frames are pending. A steady stream of frames thus
+// never keeps a pool worker from other work for longer than one frame. Without a pool the owner
+// drains the slots from its own thread.
+//
+// Not synchronized: everything but the work on taken() requires the owner's mutex. Job needs an
+// int64_t time_ns member, the time the frame was queued.
+template <typename Job>
+class LatestFrames {
+   public:
+    LatestFrames() = default;
+    LatestFrames(TaskPool* pool, TaskPool::Task task) : pool_(pool), task_(std::move(task)) {}
+
+    LatestFrames(const LatestFrames&) = delete;
+    LatestFrames& operator=(const LatestFrames&) = delete;
+
+    // Whether the eye's slot holds a frame that was not taken yet.
+    bool pending(uint32_t eye) const { return pending_[eye]; }
+    bool AnyPending() const { return pending_[0] || pending_[1]; }
+
+    // A task is queued or running.
+    bool scheduled() const { return scheduled_; }
+
+    // The eye's slot, no longer pending, for the hook to fill before Publish(). A frame left
+    // unpublished is dropped.
+    Job& Refill(uint32_t eye) {
+        pending_[eye] = false;
+        return slots_[eye];
+    }
+
+    // Mark the eye's refilled slot pending and queue a task for it, unless `stopping`.
+    void Publish(uint32_t eye, bool stopping) {
+        pending_[eye] = true;
+        Schedule(stopping);
+    }
+
+    // Drop the pending frames.
+    void Clear() { pending_[0] = pending_[1] = false; }
+
+    // Move the older pending frame into taken() and return its eye, or -1 if none is pending.
+    int Take() {
+        int eye = pending_[0] ? 0 : pending_[1] ? 1 : -1;
+        if (eye < 0) return -1;
+        if (eye == 0 && pending_[1] && slots_[1].time_ns < slots_[0].time_ns) eye = 1;
+        std::swap(taken_, slots_[eye]);
+        pending_[eye] = false;
+        return eye;
+    }
+
+    // The frame last returned by Take(). Only the consumer touches it, so it may be used without
+    // the owner's lock.
+    Job& taken() { return taken_; }
+
+    // End of a task: queues the next one while frames are pending, unless `stopping`. Returns
+    // whether a task is still queued; when it is not, a Stop() waiting for scheduled() can go on.
+    bool TaskDone(bool stopping) {
+        scheduled_ = false;
+        if (AnyPending()) Schedule(stopping);
+        return scheduled_;
+    }
+
+   private:
+    void Schedule(bool stopping) {
+        if (!pool_ || scheduled_ || stopping) return;
+        scheduled_ = pool_->Submit(TaskPriority::kCapture, task_);
+    }
+
+    TaskPool* pool_ = nullptr;
+    TaskPool::Task task_;
+    bool scheduled_ = false;
+
+    Job slots_[2];
+    bool pending_[2] = {false, false};
+    Job taken_;
+};
+
+}  // namespace ox_sim
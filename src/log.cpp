@@ -0,0 +1,317 @@
+#include "log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+namespace ox_sim {
+namespace logging {
+
+namespace detail {
+std::atomic<int> g_level{static_cast<int>(LogLevel::INFO)};
+}  // namespace detail
+
+namespace {
+
+constexpr size_t kRingCapacity = 1024;  // must be a power of two
+constexpr size_t kMaxMessage = 256;     // bytes per message, including the terminator
+
+struct Entry {
+    std::atomic<uint64_t> sequence{0};
+    int64_t time_ns;  // system_clock, for wall-clock timestamps
+    LogLevel level;
+    uint32_t suppressed;  // messages from the same site dropped by rate limiting before this one
+    char text[kMaxMessage];
+};
+
+// Bounded multi-producer/single-consumer ring (Vyukov's sequence-numbered slots). Producers claim a
+// slot with a CAS on `head` and publish it by bumping the slot's sequence; nobody ever waits.
+class Ring {
+   public:
+    Ring() {
+        for (size_t i = 0; i < kRingCapacity; i++) entries_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Returns a slot to fill and publish with Publish(), or nullptr if the ring is full.
+    Entry* Claim() {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Entry& e = entries_[pos & (kRingCapacity - 1)];
+            const uint64_t seq = e.sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return &e;
+            } else if (diff < 0) {
+                return nullptr;  // full
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Publish(Entry* e) {
+        const uint64_t pos = e->sequence.load(std::memory_order_relaxed);
+        e->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    // Consumer side: the next published entry, or nullptr. Call Release() when done with it.
+    Entry* Peek() {
+        Entry& e = entries_[tail_ & (kRingCapacity - 1)];
+        return e.sequence.load(std::memory_order_acquire) == tail_ + 1 ? &e : nullptr;
+    }
+
+    void Release(Entry* e) {
+        e->sequence.store(tail_ + kRingCapacity, std::memory_order_release);
+        tail_++;
+    }
+
+   private:
+    Entry entries_[kRingCapacity];
+    std::atomic<uint64_t> head_{0};
+    uint64_t tail_ = 0;  // consumer only
+};
+
+class Logger {
+   public:
+    // Starts the sink thread on first use. After Stop() it stays stopped until Start() is called again
+    // (Configure() does), so messages logged during shutdown are written synchronously.
+    void EnsureStarted() {
+        if (!started_once_.load(std::memory_order_acquire)) Start();
+    }
+
+    void Start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (IsRunning()) return;
+        if (!ring_) ring_ = new Ring();
+        stopping_ = false;
+        running_.store(true, std::memory_order_release);
+        thread_ = std::thread(&Logger::SinkThread, this);
+        started_once_.store(true, std::memory_order_release);
+    }
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    Ring& ring() { return *ring_; }
+
+    void CountDropped() { dropped_.fetch_add(1, std::memory_order_relaxed); }
+
+    void SetDestination(const std::string& destination) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_destination_ = destination;
+        has_pending_destination_ = true;
+        // With the sink stopped, apply right away for synchronous writes.
+        if (!IsRunning()) ApplyPendingDestination();
+        cv_.notify_one();
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!IsRunning() || stopping_) return;
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+        running_.store(false, std::memory_order_release);
+
+        // Pick up anything published between the sink's last pass and running_ going false.
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (Entry* e = ring_->Peek()) {
+            WriteLine(e->time_ns, e->level, e->suppressed, e->text);
+            ring_->Release(e);
+        }
+        std::fflush(out_);
+    }
+
+    // Used once the sink has stopped (driver shutdown): format and write on the calling thread.
+    void WriteSync(LogLevel level, uint32_t suppressed, const char* text) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WriteLine(CurrentTimeNs(), level, suppressed, text);
+        std::fflush(out_);
+    }
+
+    static int64_t CurrentTimeNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+   private:
+    void SinkThread() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            ApplyPendingDestination();
+
+            bool wrote = false;
+            while (Entry* e = ring_->Peek()) {
+                WriteLine(e->time_ns, e->level, e->suppressed, e->text);
+                ring_->Release(e);
+                wrote = true;
+            }
+            if (const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+                char text[96];
+                std::snprintf(text, sizeof(text), "%llu log messages dropped (logger ring full)",
+                              static_cast<unsigned long long>(dropped));
+                WriteLine(CurrentTimeNs(), LogLevel::WARN, 0, text);
+                wrote = true;
+            }
+            if (wrote) std::fflush(out_);
+
+            if (stopping_) break;
+            // Producers never signal (that would need a lock); poll instead.
+            cv_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    // Requires mutex_.
+    void ApplyPendingDestination() {
+        if (!has_pending_destination_) return;
+        has_pending_destination_ = false;
+
+        FILE* next = stdout;
+        if (pending_destination_ == "stderr") {
+            next = stderr;
+        } else if (!pending_destination_.empty() && pending_destination_ != "stdout") {
+            next = std::fopen(pending_destination_.c_str(), "a");
+            if (!next) {
+                std::fprintf(stderr, "Failed to open log file %s, logging to stdout\n", pending_destination_.c_str());
+                next = stdout;
+            }
+        }
+        std::fflush(out_);
+        if (out_ != stdout && out_ != stderr) std::fclose(out_);
+        out_ = next;
+    }
+
+    // Requires mutex_ (or the sink thread).
+    void WriteLine(int64_t time_ns, LogLevel level, uint32_t suppressed, const char* text) {
+        const std::time_t seconds = static_cast<std::time_t>(time_ns / 1'000'000'000);
+        const int millis = static_cast<int>((time_ns / 1'000'000) % 1000);
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &seconds);
+#else
+        localtime_r(&seconds, &tm);
+#endif
+        std::fprintf(out_, "[%02d:%02d:%02d.%03d] [%s] ", tm.tm_hour, tm.tm_min, tm.tm_sec, millis, LevelName(level));
+        if (suppressed) std::fprintf(out_, "(%u similar messages suppressed) ", suppressed);
+        std::fputs(text, out_);
+        std::fputc('\n', out_);
+    }
+
+    std::atomic<bool> started_once_{false};
+    Ring* ring_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> dropped_{0};
+
+    // Guards out_, the pending destination, stopping_ and thread start/stop. Producers only take it
+    // for synchronous writes after Stop().
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    FILE* out_ = stdout;
+    std::string pending_destination_;
+    bool has_pending_destination_ = false;
+    bool stopping_ = false;
+};
+
+// Intentionally leaked: the sink thread may still be running during static destruction.
+Logger& GetLogger() {
+    static Logger* logger = new Logger();
+    return *logger;
+}
+
+// Returns false if the site is over its budget for the current window. On the first message of a
+// new window, *suppressed receives the number of messages dropped in the previous one.
+bool AllowSite(SiteLimiter& site, int64_t now_ns, uint32_t* suppressed) {
+    int64_t start = site.window_start_ns.load(std::memory_order_relaxed);
+    if (now_ns - start >= SiteLimiter::kWindowNs &&
+        site.window_start_ns.compare_exchange_strong(start, now_ns, std::memory_order_relaxed)) {
+        *suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        site.count.store(0, std::memory_order_relaxed);
+    }
+    if (site.count.fetch_add(1, std::memory_order_relaxed) < SiteLimiter::kBurstPerWindow) return true;
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+}  // namespace
+
+bool ParseLevel(const std::string& name, LogLevel* out) {
+    static const struct {
+        const char* name;
+        LogLevel level;
+    } kLevels[] = {
+        {"debug", LogLevel::DEBUG}, {"info", LogLevel::INFO}, {"warn", LogLevel::WARN},
+        {"error", LogLevel::ERR},   {"off", LogLevel::OFF},
+    };
+    for (const auto& l : kLevels) {
+        if (name == l.name) {
+            *out = l.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* LevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG:
+            return "debug";
+        case LogLevel::INFO:
+            return "info";
+        case LogLevel::WARN:
+            return "warn";
+        case LogLevel::ERR:
+            return "error";
+        default:
+            return "off";
+    }
+}
+
+void Configure(LogLevel level, const std::string& destination) {
+    detail::g_level.store(static_cast<int>(level), std::memory_order_relaxed);
+    Logger& logger = GetLogger();
+    logger.SetDestination(destination);
+    logger.Start();
+}
+
+void Shutdown() { GetLogger().Stop(); }
+
+void Write(LogLevel level, SiteLimiter& site, const char* format, ...) {
+    const int64_t now_ns = Logger::CurrentTimeNs();
+    uint32_t suppressed = 0;
+    if (!AllowSite(site, now_ns, &suppressed)) return;
+
+    Logger& logger = GetLogger();
+    logger.EnsureStarted();
+
+    va_list args;
+    va_start(args, format);
+    if (!logger.IsRunning()) {
+        char text[kMaxMessage];
+        std::vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        logger.WriteSync(level, suppressed, text);
+        return;
+    }
+
+    Entry* e = logger.ring().Claim();
+    if (!e) {
+        va_end(args);
+        logger.CountDropped();
+        return;
+    }
+    e->time_ns = now_ns;
+    e->level = level;
+    e->suppressed = suppressed;
+    std::vsnprintf(e->text, sizeof(e->text), format, args);
+    va_end(args);
+    logger.ring().Publish(e);
+}
+
+}  // namespace logging
+}  // namespace ox_sim
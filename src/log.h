@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace ox_sim {
+namespace logging {
+
+// ERR rather than ERROR: windows.h defines ERROR as a macro.
+enum class LogLevel : int { DEBUG = 0, INFO, WARN, ERR, OFF };
+
+// Parse "debug", "info", "warn", "error" or "off". Returns false (and leaves *out untouched) otherwise.
+bool ParseLevel(const std::string& name, LogLevel* out);
+const char* LevelName(LogLevel level);
+
+// Per-call-site rate limiter state; OX_LOG_* macros keep one as a function-local static.
+// A site may emit kBurstPerWindow messages per second; the rest are counted and reported with the
+// site's next message.
+struct SiteLimiter {
+    static constexpr uint32_t kBurstPerWindow = 10;
+    static constexpr int64_t kWindowNs = 1'000'000'000;
+
+    std::atomic<int64_t> window_start_ns{0};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+namespace detail {
+extern std::atomic<int> g_level;
+}  // namespace detail
+
+inline bool IsEnabled(LogLevel level) {
+    return static_cast<int>(level) >= detail::g_level.load(std::memory_order_relaxed) && level != LogLevel::OFF;
+}
+
+// Set the minimum level and the destination: "stdout" (or empty), "stderr", or a file path (appended to).
+// Messages logged before the first Configure() go to stdout at INFO level.
+void Configure(LogLevel level, const std::string& destination);
+
+// Drain pending messages and stop the sink thread. Later messages are written synchronously.
+void Shutdown();
+
+// printf-style. Formats into a fixed-size ring slot (long messages are truncated) and returns
+// without doing any I/O; a background thread writes the messages out. Never blocks: if the ring is
+// full the message is dropped and counted.
+void Write(LogLevel level, SiteLimiter& site, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    ;
+
+}  // namespace logging
+}  // namespace ox_sim
+
+#define OX_LOG(level, ...)                                                                                             \
+    do {                                                                                                               \
+        if (::ox_sim::logging::IsEnabled(level)) {                                                                     \
+            static ::ox_sim::logging::SiteLimiter ox_log_site;                                                         \
+            ::ox_sim::logging::Write(level, ox_log_site, __VA_ARGS__);                                                 \
+        }                                                                                                              \
+    } while (0)
+
+#define OX_LOG_DEBUG(...) OX_LOG(::ox_sim::logging::LogLevel::DEBUG, __VA_ARGS__)
+#define OX_LOG_INFO(...) OX_LOG(::ox_sim::logging::LogLevel::INFO, __VA_ARGS__)
+#define OX_LOG_WARN(...) OX_LOG(::ox_sim::logging::LogLevel::WARN, __VA_ARGS__)
+#define OX_LOG_ERROR(...) OX_LOG(::ox_sim::logging::LogLevel::ERR, __VA_ARGS__)
@@ -0,0 +1,223 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "log.h"
+
+namespace ox_sim {
+namespace metrics {
+
+namespace {
+
+// Total number of accumulator slots available to all registered series.
+constexpr uint32_t kMaxSlots = 4096;
+
+// Slots past kMaxSlots that series registered after the table filled up share. They are never
+// exported, so such a series reads as missing instead of corrupting another one. Wide enough for
+// a histogram.
+constexpr uint32_t kScratchSlots = static_cast<uint32_t>(kBucketCount) + 1;
+
+enum class Kind { COUNTER, GAUGE, HISTOGRAM };
+
+struct Series {
+    std::string name;
+    std::string help;
+    std::string labels;
+    Kind kind;
+    uint32_t slot;
+};
+
+// Per-thread accumulators. Only the owning thread writes to a shard, so increments are plain
+// relaxed load/store pairs (no locked read-modify-write); scrapes read them with relaxed loads.
+struct Shard {
+    std::atomic<uint64_t> values[kMaxSlots + kScratchSlots];
+
+    Shard() {
+        for (auto& v : values) v.store(0, std::memory_order_relaxed);
+    }
+
+    void Add(uint32_t slot, uint64_t n) {
+        std::atomic<uint64_t>& v = values[slot];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+struct Registry {
+    std::mutex mutex;  // guards series, shards and retired (never taken on the increment path)
+    std::vector<Series> series;
+    std::vector<Shard*> shards;
+    Shard retired;  // accumulated values of threads that have exited
+    Shard late;     // updates made by threads after their own shard was retired (see LocalShard())
+    uint32_t next_slot = 0;
+    bool overflowed = false;
+
+    uint32_t Register(const char* name, const char* help, const char* labels, Kind kind, uint32_t width) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // Several instances (e.g. two SimulatorCore objects) may register the same series; share it.
+            for (const Series& s : series) {
+                if (s.kind == kind && s.name == name && s.labels == labels) return s.slot;
+            }
+            if (next_slot + width <= kMaxSlots) {
+                uint32_t slot = next_slot;
+                next_slot += width;
+                series.push_back({name, help, labels, kind, slot});
+                return slot;
+            }
+            if (overflowed) return kMaxSlots;
+            overflowed = true;
+        }
+        // Out of slots. Raise kMaxSlots if this ever happens.
+        OX_LOG_ERROR("Metrics: no slots left for %s; it and any later series will not be exported", name);
+        return kMaxSlots;
+    }
+};
+
+// Intentionally leaked so metrics defined as statics can still be updated during static destruction.
+Registry& GetRegistry() {
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+// The calling thread's shard. Plain pointers, so they stay readable while thread_local objects
+// with destructors are being destroyed.
+thread_local Shard* t_shard = nullptr;
+thread_local bool t_retired = false;
+
+// Folds the thread's shard into the retired shard when the thread exits.
+struct ShardRetirer {
+    ~ShardRetirer() {
+        if (!t_shard) return;
+        Registry& reg = GetRegistry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (uint32_t i = 0; i < reg.next_slot; i++) {
+            reg.retired.Add(i, t_shard->values[i].load(std::memory_order_relaxed));
+        }
+        reg.shards.erase(std::remove(reg.shards.begin(), reg.shards.end(), t_shard), reg.shards.end());
+        delete t_shard;
+        t_shard = nullptr;
+        t_retired = true;
+    }
+};
+
+Shard& LocalShard() {
+    if (t_shard) return *t_shard;
+    // Metrics updated from later thread_local or static destructors (e.g. the main thread's globals at
+    // exit) land in a shared shard. Concurrent updates to it can lose increments, which only matters
+    // for the last few updates of exiting threads.
+    if (t_retired) return GetRegistry().late;
+    thread_local ShardRetirer retirer;
+    t_shard = new Shard();
+    Registry& reg = GetRegistry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.shards.push_back(t_shard);
+    return *t_shard;
+}
+
+void AppendLabels(std::ostringstream& out, const std::string& labels, const char* extra) {
+    if (labels.empty() && !extra) return;
+    out << '{' << labels;
+    if (extra) out << (labels.empty() ? "" : ",") << extra;
+    out << '}';
+}
+
+}  // namespace
+
+Counter::Counter(const char* name, const char* help, const char* labels)
+    : slot_(GetRegistry().Register(name, help, labels, Kind::COUNTER, 1)) {}
+
+void Counter::Add(uint64_t n) { LocalShard().Add(slot_, n); }
+
+Gauge::Gauge(const char* name, const char* help, const char* labels)
+    : slot_(GetRegistry().Register(name, help, labels, Kind::GAUGE, 1)) {}
+
+// Negative deltas wrap around; the unsigned sum of all shards is still the right two's complement value.
+void Gauge::Add(int64_t n) { LocalShard().Add(slot_, static_cast<uint64_t>(n)); }
+
+Histogram::Histogram(const char* name, const char* help, const char* labels)
+    : slot_(GetRegistry().Register(name, help, labels, Kind::HISTOGRAM, kBucketCount + 1)) {}
+
+void Histogram::Observe(Clock::duration d) {
+    const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    uint32_t bucket = 0;
+    while (bucket < kBucketCount - 1 && ns > kLatencyBucketsNs[bucket]) bucket++;
+
+    Shard& shard = LocalShard();
+    shard.Add(slot_ + bucket, 1);
+    shard.Add(slot_ + kBucketCount, static_cast<uint64_t>(ns > 0 ? ns : 0));
+}
+
+std::string RenderPrometheus() {
+    Registry& reg = GetRegistry();
+
+    // Merge all thread accumulators into one snapshot.
+    std::vector<uint64_t> totals;
+    std::vector<Series> series;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        totals.resize(reg.next_slot);
+        for (uint32_t i = 0; i < reg.next_slot; i++) {
+            uint64_t sum = reg.retired.values[i].load(std::memory_order_relaxed) +
+                           reg.late.values[i].load(std::memory_order_relaxed);
+            for (const Shard* shard : reg.shards) sum += shard->values[i].load(std::memory_order_relaxed);
+            totals[i] = sum;
+        }
+        series = reg.series;
+    }
+
+    // Group series of the same family so HELP/TYPE are emitted once per metric name.
+    std::stable_sort(series.begin(), series.end(),
+                     [](const Series& a, const Series& b) { return a.name < b.name; });
+
+    std::ostringstream out;
+    const std::string* current_family = nullptr;
+    for (const Series& s : series) {
+        if (!current_family || *current_family != s.name) {
+            current_family = &s.name;
+            out << "# HELP " << s.name << ' ' << s.help << '\n';
+            const char* type = s.kind == Kind::COUNTER ? " counter" : s.kind == Kind::GAUGE ? " gauge" : " histogram";
+            out << "# TYPE " << s.name << type << '\n';
+        }
+
+        if (s.kind == Kind::COUNTER) {
+            out << s.name;
+            AppendLabels(out, s.labels, nullptr);
+            out << ' ' << totals[s.slot] << '\n';
+            continue;
+        }
+        if (s.kind == Kind::GAUGE) {
+            out << s.name;
+            AppendLabels(out, s.labels, nullptr);
+            out << ' ' << static_cast<int64_t>(totals[s.slot]) << '\n';
+            continue;
+        }
+
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < kBucketCount; b++) {
+            cumulative += totals[s.slot + b];
+            std::ostringstream le;
+            if (b < kBucketCount - 1) {
+                le << "le=\"" << static_cast<double>(kLatencyBucketsNs[b]) * 1e-9 << '"';
+            } else {
+                le << "le=\"+Inf\"";
+            }
+            out << s.name << "_bucket";
+            AppendLabels(out, s.labels, le.str().c_str());
+            out << ' ' << cumulative << '\n';
+        }
+        out << s.name << "_sum";
+        AppendLabels(out, s.labels, nullptr);
+        out << ' ' << static_cast<double>(totals[s.slot + kBucketCount]) * 1e-9 << '\n';
+        out << s.name << "_count";
+        AppendLabels(out, s.labels, nullptr);
+        out << ' ' << cumulative << '\n';
+    }
+    return out.str();
+}
+
+}  // namespace metrics
+}  // namespace ox_sim
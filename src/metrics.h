@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace ox_sim {
+namespace metrics {
+
+using Clock = std::chrono::steady_clock;
+
+// Upper bounds (in nanoseconds) of the latency histogram buckets; a final +Inf bucket is implicit.
+// Covers everything from an uncontended lock (~100ns) to a full-resolution PNG encode (~1s).
+inline constexpr int64_t kLatencyBucketsNs[] = {
+    250,        1'000,       5'000,       10'000,      50'000,        100'000,       500'000,
+    1'000'000,  2'000'000,   5'000'000,   10'000'000,  50'000'000,    100'000'000,   1'000'000'000,
+};
+inline constexpr size_t kBucketCount = sizeof(kLatencyBucketsNs) / sizeof(kLatencyBucketsNs[0]) + 1;
+
+// Monotonic counter. Each thread increments its own accumulator without locking; the per-thread
+// values are only summed when the metrics are scraped.
+class Counter {
+   public:
+    // labels is the Prometheus label body without braces, e.g. `route="/v1/status"`.
+    Counter(const char* name, const char* help, const char* labels = "");
+
+    void Add(uint64_t n = 1);
+
+   private:
+    uint32_t slot_;
+};
+
+// Value that goes up and down, e.g. a queue depth. Stored as per-thread deltas like Counter, so
+// one thread may Add() what another Sub()s; a scrape sums the deltas into the current value.
+class Gauge {
+   public:
+    Gauge(const char* name, const char* help, const char* labels = "");
+
+    void Add(int64_t n = 1);
+    void Sub(int64_t n = 1) { Add(-n); }
+
+   private:
+    uint32_t slot_;
+};
+
+// Latency histogram with fixed kLatencyBucketsNs buckets, stored in the same per-thread
+// accumulators as Counter. The series' _count doubles as the call count.
+class Histogram {
+   public:
+    Histogram(const char* name, const char* help, const char* labels = "");
+
+    void Observe(Clock::duration d);
+
+   private:
+    uint32_t slot_;  // kBucketCount bucket slots followed by one sum slot (ns)
+};
+
+// Observes the lifetime of the enclosing scope into a Histogram.
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(Histogram& histogram) : histogram_(histogram), start_(Clock::now()) {}
+    ~ScopedTimer() { histogram_.Observe(Clock::now() - start_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+   private:
+    Histogram& histogram_;
+    Clock::time_point start_;
+};
+
+// Merge all per-thread accumulators and render them in the Prometheus text exposition format (0.0.4).
+std::string RenderPrometheus();
+
+}  // namespace metrics
+}  // namespace ox_sim
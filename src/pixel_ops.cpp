@@ -0,0 +1,294 @@
+#include "pixel_ops.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OX_SIM_PIXEL_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define OX_SIM_PIXEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ox_sim {
+
+namespace {
+
+const uint8_t* ImageRow(const uint8_t* image, uint32_t image_width, uint32_t image_height, uint32_t y) {
+    return image + static_cast<size_t>(image_height - 1 - y) * image_width * 4;
+}
+
+uint64_t SumAbsDiffRGBScalar(const uint8_t* a, const uint8_t* b, size_t pixel_count) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < pixel_count * 4; i += 4) {
+        for (size_t c = 0; c < 3; c++) {
+            sum += a[i + c] > b[i + c] ? a[i + c] - b[i + c] : b[i + c] - a[i + c];
+        }
+    }
+    return sum;
+}
+
+uint64_t SumLumaScalar(const uint8_t* pixels, size_t pixel_count) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < pixel_count * 4; i += 4) {
+        sum += 77u * pixels[i] + 150u * pixels[i + 1] + 29u * pixels[i + 2];
+    }
+    return sum;
+}
+
+void AccumulateLumaStatsScalar(const uint8_t* pixels, size_t pixel_count, LumaStats* stats) {
+    for (size_t i = 0; i < pixel_count * 4; i += 4) {
+        const uint32_t luma = (77u * pixels[i] + 150u * pixels[i + 1] + 29u * pixels[i + 2]) >> 8;
+        stats->sum += luma;
+        stats->sum_squares += luma * luma;
+        stats->histogram[luma >> 4]++;
+    }
+}
+
+uint64_t MixHash(uint64_t h, uint64_t word) {
+    h = (h ^ word) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+// Vector steps accumulated in 32-bit lanes before they are widened; each step adds at most
+// 2 * 255 * 256 to a lane, so this stays far below 2^32.
+constexpr size_t kLumaBlockSteps = 4096;
+
+// Vector steps counted in 8-bit lanes before they are flushed.
+constexpr size_t kHistogramBlockSteps = 255;
+
+}  // namespace
+
+uint64_t SumAbsDiffRGB(const uint8_t* a, const uint8_t* b, size_t pixel_count) {
+    size_t i = 0;
+    uint64_t sum = 0;
+#if defined(OX_SIM_PIXEL_SSE2)
+    // 4 pixels per step; alpha bytes are zeroed in both inputs so they add nothing to the SAD.
+    const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 4 <= pixel_count; i += 4) {
+        const __m128i va = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * 4)), rgb_mask);
+        const __m128i vb = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i * 4)), rgb_mask);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    sum = lanes[0] + lanes[1];
+#elif defined(OX_SIM_PIXEL_NEON)
+    const uint8x16_t rgb_mask = vreinterpretq_u8_u32(vdupq_n_u32(0x00FFFFFF));
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 4 <= pixel_count; i += 4) {
+        const uint8x16_t diff = vandq_u8(vabdq_u8(vld1q_u8(a + i * 4), vld1q_u8(b + i * 4)), rgb_mask);
+        acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(diff)));
+    }
+    sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+    return sum + SumAbsDiffRGBScalar(a + i * 4, b + i * 4, pixel_count - i);
+}
+
+void DownsampleRGBA(const uint8_t* image, uint32_t image_width, uint32_t image_height, uint32_t factor, uint8_t* out) {
+    const uint32_t out_width = image_width / factor;
+    const uint32_t out_height = image_height / factor;
+    for (uint32_t y = 0; y < out_height; y++) {
+        const uint8_t* row0 = ImageRow(image, image_width, image_height, y * factor);
+        const uint8_t* row1 = factor > 1 ? ImageRow(image, image_width, image_height, y * factor + 1) : row0;
+        uint8_t* dst = out + static_cast<size_t>(y) * out_width * 4;
+        if (factor == 1) {
+            std::memcpy(dst, row0, static_cast<size_t>(out_width) * 4);
+            for (uint32_t x = 0; x < out_width; x++) dst[x * 4 + 3] = 255;
+            continue;
+        }
+        uint32_t x = 0;
+#if defined(OX_SIM_PIXEL_SSE2)
+        // Average the two rows, then the two pixels of the result: rounds up at each step, so the
+        // result can be one higher than the scalar path's.
+        for (; x < out_width; x++) {
+            const size_t offset = static_cast<size_t>(x) * factor * 4;
+            __m128i v = _mm_avg_epu8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row0 + offset)),
+                                     _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row1 + offset)));
+            v = _mm_avg_epu8(v, _mm_srli_epi64(v, 32));
+            const uint32_t pixel = static_cast<uint32_t>(_mm_cvtsi128_si32(v)) | 0xff000000u;
+            std::memcpy(dst + x * 4, &pixel, 4);
+        }
+#endif
+        for (; x < out_width; x++) {
+            const uint8_t* a = row0 + static_cast<size_t>(x) * factor * 4;
+            const uint8_t* b = row1 + static_cast<size_t>(x) * factor * 4;
+            for (int c = 0; c < 3; c++) {
+                dst[x * 4 + c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) / 4);
+            }
+            dst[x * 4 + 3] = 255;
+        }
+    }
+}
+
+uint64_t SumLuma(const uint8_t* pixels, size_t pixel_count) {
+    size_t i = 0;
+    uint64_t sum = 0;
+#if defined(OX_SIM_PIXEL_SSE2)
+    // 4 pixels per step: widen to 16 bits and multiply-add (R, G) and (B, A) pairs with the weights.
+    const __m128i weights = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    while (i + 4 <= pixel_count) {
+        __m128i block = zero;
+        for (size_t step = 0; step < kLumaBlockSteps && i + 4 <= pixel_count; step++, i += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+            block = _mm_add_epi32(block, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights));
+            block = _mm_add_epi32(block, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights));
+        }
+        acc = _mm_add_epi64(acc, _mm_add_epi64(_mm_unpacklo_epi32(block, zero), _mm_unpackhi_epi32(block, zero)));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    sum = lanes[0] + lanes[1];
+#elif defined(OX_SIM_PIXEL_NEON)
+    // 8 pixels per step, deinterleaved by vld4; a pixel's weighted sum fits in 16 bits.
+    uint64x2_t acc = vdupq_n_u64(0);
+    while (i + 8 <= pixel_count) {
+        uint32x4_t block = vdupq_n_u32(0);
+        for (size_t step = 0; step < kLumaBlockSteps && i + 8 <= pixel_count; step++, i += 8) {
+            const uint8x8x4_t v = vld4_u8(pixels + i * 4);
+            uint16x8_t luma = vmull_u8(v.val[0], vdup_n_u8(77));
+            luma = vmlal_u8(luma, v.val[1], vdup_n_u8(150));
+            luma = vmlal_u8(luma, v.val[2], vdup_n_u8(29));
+            block = vpadalq_u16(block, luma);
+        }
+        acc = vpadalq_u32(acc, block);
+    }
+    sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+    return sum + SumLumaScalar(pixels + i * 4, pixel_count - i);
+}
+
+void CopyRegionRGBA(const uint8_t* image, uint32_t image_width, uint32_t image_height, const PixelRect& rect,
+                    uint8_t* out) {
+    const size_t row_bytes = static_cast<size_t>(rect.width) * 4;
+    for (uint32_t row = 0; row < rect.height; row++) {
+        const uint8_t* src = ImageRow(image, image_width, image_height, rect.y + row) + static_cast<size_t>(rect.x) * 4;
+        std::memcpy(out + row * row_bytes, src, row_bytes);
+    }
+}
+
+float RegionMeanAbsDiff(const uint8_t* image, uint32_t image_width, uint32_t image_height, const PixelRect& rect,
+                        const uint8_t* region) {
+    const size_t row_bytes = static_cast<size_t>(rect.width) * 4;
+    uint64_t sum = 0;
+    for (uint32_t row = 0; row < rect.height; row++) {
+        const uint8_t* src = ImageRow(image, image_width, image_height, rect.y + row) + static_cast<size_t>(rect.x) * 4;
+        sum += SumAbsDiffRGB(src, region + row * row_bytes, rect.width);
+    }
+    return static_cast<float>(static_cast<double>(sum) / (static_cast<double>(rect.PixelCount()) * 3.0));
+}
+
+double LumaStats::Variance() const {
+    if (count == 0) return 0.0;
+    const double mean = Mean();
+    return std::max(static_cast<double>(sum_squares) / count - mean * mean, 0.0);
+}
+
+void AccumulateLumaStats(const uint8_t* pixels, size_t pixel_count, LumaStats* stats) {
+    size_t i = 0;
+    stats->count += pixel_count;
+    // The vector paths count, per bucket k >= 1, the pixels with luma >= 16 * k in 8-bit lanes (a
+    // compare yields -1, which is subtracted), and flush them every kHistogramBlockSteps steps.
+    // Bucket k then holds at_least[k] - at_least[k + 1].
+    uint64_t at_least[17] = {};
+#if defined(OX_SIM_PIXEL_SSE2)
+    // 16 pixels per step. After the multiply-add, lanes 0 and 2 of (lo + lo >> 32) hold the luma of
+    // two pixels; four loads are gathered and packed into one byte per pixel.
+    const __m128i weights = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    auto luma4 = [&](const uint8_t* p) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights);
+        lo = _mm_srli_epi32(_mm_add_epi32(lo, _mm_srli_epi64(lo, 32)), 8);
+        hi = _mm_srli_epi32(_mm_add_epi32(hi, _mm_srli_epi64(hi, 32)), 8);
+        return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+    };
+    while (i + 16 <= pixel_count) {
+        __m128i sum = zero;
+        __m128i sum_squares = zero;
+        __m128i counts[15];
+        for (__m128i& count : counts) count = zero;
+        for (size_t step = 0; step < kHistogramBlockSteps && i + 16 <= pixel_count; step++, i += 16) {
+            const uint8_t* p = pixels + i * 4;
+            const __m128i luma = _mm_packus_epi16(_mm_packs_epi32(luma4(p), luma4(p + 16)),
+                                                  _mm_packs_epi32(luma4(p + 32), luma4(p + 48)));
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(luma, zero));
+            const __m128i lo = _mm_unpacklo_epi8(luma, zero);
+            const __m128i hi = _mm_unpackhi_epi8(luma, zero);
+            sum_squares = _mm_add_epi32(sum_squares, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+            // Signed compare on sign-flipped bytes: luma >= 16 * k is luma > 16 * k - 1.
+            const __m128i flipped = _mm_xor_si128(luma, sign);
+            for (int k = 0; k < 15; k++) {
+                const __m128i bound = _mm_set1_epi8(static_cast<char>((16 * (k + 1) - 1) ^ 0x80));
+                counts[k] = _mm_sub_epi8(counts[k], _mm_cmpgt_epi8(flipped, bound));
+            }
+        }
+        uint64_t lanes[2];
+        for (int k = 0; k < 15; k++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_sad_epu8(counts[k], zero));
+            at_least[k + 1] += lanes[0] + lanes[1];
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+        stats->sum += lanes[0] + lanes[1];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes),
+                         _mm_add_epi64(_mm_unpacklo_epi32(sum_squares, zero), _mm_unpackhi_epi32(sum_squares, zero)));
+        stats->sum_squares += lanes[0] + lanes[1];
+    }
+#elif defined(OX_SIM_PIXEL_NEON)
+    // 8 pixels per step, deinterleaved by vld4.
+    while (i + 8 <= pixel_count) {
+        uint32x4_t sum = vdupq_n_u32(0);
+        uint32x4_t sum_squares = vdupq_n_u32(0);
+        uint8x8_t counts[15];
+        for (uint8x8_t& count : counts) count = vdup_n_u8(0);
+        for (size_t step = 0; step < kHistogramBlockSteps && i + 8 <= pixel_count; step++, i += 8) {
+            const uint8x8x4_t v = vld4_u8(pixels + i * 4);
+            uint16x8_t weighted = vmull_u8(v.val[0], vdup_n_u8(77));
+            weighted = vmlal_u8(weighted, v.val[1], vdup_n_u8(150));
+            weighted = vmlal_u8(weighted, v.val[2], vdup_n_u8(29));
+            const uint8x8_t luma = vshrn_n_u16(weighted, 8);
+            sum = vpadalq_u16(sum, vmovl_u8(luma));
+            sum_squares = vpadalq_u16(sum_squares, vmull_u8(luma, luma));
+            for (int k = 0; k < 15; k++) {
+                counts[k] = vsub_u8(counts[k], vcge_u8(luma, vdup_n_u8(static_cast<uint8_t>(16 * (k + 1)))));
+            }
+        }
+        for (int k = 0; k < 15; k++) {
+            const uint64x1_t count = vpaddl_u32(vpaddl_u16(vpaddl_u8(counts[k])));
+            at_least[k + 1] += vget_lane_u64(count, 0);
+        }
+        const uint64x2_t sum64 = vpaddlq_u32(sum);
+        const uint64x2_t sum_squares64 = vpaddlq_u32(sum_squares);
+        stats->sum += vgetq_lane_u64(sum64, 0) + vgetq_lane_u64(sum64, 1);
+        stats->sum_squares += vgetq_lane_u64(sum_squares64, 0) + vgetq_lane_u64(sum_squares64, 1);
+    }
+#endif
+    at_least[0] = i;
+    for (int k = 0; k < 16; k++) stats->histogram[k] += static_cast<uint32_t>(at_least[k] - at_least[k + 1]);
+    AccumulateLumaStatsScalar(pixels + i * 4, pixel_count - i, stats);
+}
+
+uint64_t HashBytes(const uint8_t* data, size_t size, uint64_t seed) {
+    // Four independent lanes so the multiplies overlap; 32 bytes per step.
+    uint64_t h0 = seed, h1 = seed + 1, h2 = seed + 2, h3 = seed + 3;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        uint64_t words[4];
+        std::memcpy(words, data + i, sizeof(words));
+        h0 = MixHash(h0, words[0]);
+        h1 = MixHash(h1, words[1]);
+        h2 = MixHash(h2, words[2]);
+        h3 = MixHash(h3, words[3]);
+    }
+    uint64_t h = MixHash(MixHash(MixHash(MixHash(size, h0), h1), h2), h3);
+    for (; i < size; i++) h = MixHash(h, data[i]);
+    return h;
+}
+
+}  // namespace ox_sim
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ox_sim {
+
+// Pixel kernels over the RGBA8 images the runtime submits. They use SSE2 on x86-64 and NEON on
+// ARM64, with a scalar fallback elsewhere; all variants return identical results unless noted.
+
+// Rectangle in the coordinates of GET /v1/views: origin top-left, y down. Submitted images are
+// stored bottom-row-first, so row `y` lives at memory row `height - 1 - y`.
+struct PixelRect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool FitsIn(uint32_t image_width, uint32_t image_height) const {
+        return width > 0 && height > 0 && x <= image_width && width <= image_width - x && y <= image_height &&
+               height <= image_height - y;
+    }
+    size_t PixelCount() const { return static_cast<size_t>(width) * height; }
+};
+
+// Sum over `pixel_count` pixels of |a - b| for the R, G and B channels. Alpha is ignored, since apps
+// frequently leave it undefined.
+uint64_t SumAbsDiffRGB(const uint8_t* a, const uint8_t* b, size_t pixel_count);
+
+// Copy `rect` of an image (image_width pixels per row, bottom-row-first) into `out`, top row first
+// and tightly packed (rect.PixelCount() * 4 bytes). `rect` must fit in the image.
+void CopyRegionRGBA(const uint8_t* image, uint32_t image_width, uint32_t image_height, const PixelRect& rect,
+                    uint8_t* out);
+
+// Mean absolute R/G/B difference (0-255) between `rect` of an image and a region previously copied
+// with CopyRegionRGBA().
+float RegionMeanAbsDiff(const uint8_t* image, uint32_t image_width, uint32_t image_height, const PixelRect& rect,
+                        const uint8_t* region);
+
+// Downsample an image (image_width pixels per row, bottom-row-first) by an integer `factor` into
+// `out`, top row first and tightly packed: (image_width / factor) x (image_height / factor) pixels.
+// Each output pixel averages the 2x2 pixels at the top-left of its factor x factor block, so only
+// two of every `factor` rows are read. Alpha is set to 255. The SSE2 variant rounds each of its two
+// averaging steps up, so its result can be one higher.
+void DownsampleRGBA(const uint8_t* image, uint32_t image_width, uint32_t image_height, uint32_t factor, uint8_t* out);
+
+// Sum over `pixel_count` pixels of 77 * R + 150 * G + 29 * B: BT.601 luma scaled by 256, so the mean
+// brightness (0-255) is the sum / (256 * pixel_count). Alpha is ignored.
+uint64_t SumLuma(const uint8_t* pixels, size_t pixel_count);
+
+// Brightness distribution of a set of pixels, in 8-bit BT.601 luma: (77 * R + 150 * G + 29 * B) >> 8.
+struct LumaStats {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t sum_squares = 0;
+    uint32_t histogram[16] = {};  // pixels per luma >> 4
+
+    double Mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+    double Variance() const;
+};
+
+// Add `pixel_count` pixels to `stats`. Alpha is ignored.
+void AccumulateLumaStats(const uint8_t* pixels, size_t pixel_count, LumaStats* stats);
+
+// 64-bit hash of `size` bytes, chained through `seed` so several rows can be hashed in turn. Meant
+// to tell whether an image changed, not to resist deliberate collisions.
+uint64_t HashBytes(const uint8_t* data, size_t size, uint64_t seed);
+
+}  // namespace ox_sim
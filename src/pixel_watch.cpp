@@ -0,0 +1,275 @@
+#include "pixel_watch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+#include "log.h"
+#include "metrics.h"
+#include "thread_placement.h"
+#include "trace.h"
+
+namespace ox_sim {
+
+static metrics::Counter g_frames_evaluated("ox_pixel_probe_frames_total", "Frames evaluated against pixel probes");
+static metrics::Counter g_frames_skipped("ox_pixel_probe_frames_skipped_total",
+                                         "Frames replaced by a newer one before the pixel probe worker got to them");
+static metrics::Counter g_transitions("ox_pixel_probe_transitions_total", "Pixel probe matched-state changes");
+static metrics::Histogram g_evaluate_duration("ox_pixel_probe_evaluate_seconds",
+                                              "Worker time spent evaluating the probes of one frame");
+
+bool PixelWatch::SetProbe(const std::string& id, const PixelProbeSpec& spec) {
+    ProfiledLock lock(mutex_);
+    Probe* probe = FindProbe(id);
+    if (probe) {
+        RemoveWaiters(id, probe->serial);
+    } else {
+        if (probes_.size() >= kMaxProbes) return false;
+        probes_.emplace_back();
+        probe = &probes_.back();
+    }
+    probe->status = PixelProbeStatus();
+    probe->status.id = id;
+    probe->status.spec = spec;
+    probe->serial = next_serial_++;
+
+    if (!worker_.joinable()) {
+        stopping_ = false;
+        worker_ = std::thread(&PixelWatch::WorkerThread, this);
+    }
+    RebuildSamples();
+    return true;
+}
+
+bool PixelWatch::RemoveProbe(const std::string& id) {
+    ProfiledLock lock(mutex_);
+    Probe* probe = FindProbe(id);
+    if (!probe) return false;
+    RemoveWaiters(id, probe->serial);
+    probes_.erase(probes_.begin() + (probe - probes_.data()));
+    RebuildSamples();
+    return true;
+}
+
+void PixelWatch::RemoveAll() {
+    ProfiledLock lock(mutex_);
+    for (const Probe& probe : probes_) RemoveWaiters(probe.status.id, probe.serial);
+    probes_.clear();
+    RebuildSamples();
+}
+
+std::vector<PixelProbeStatus> PixelWatch::GetProbes() const {
+    ProfiledLock lock(mutex_);
+    std::vector<PixelProbeStatus> result;
+    for (const Probe& probe : probes_) result.push_back(probe.status);
+    return result;
+}
+
+bool PixelWatch::GetProbe(const std::string& id, PixelProbeStatus* status) const {
+    ProfiledLock lock(mutex_);
+    for (const Probe& probe : probes_) {
+        if (probe.status.id == id) {
+            *status = probe.status;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<PixelProbeEvent> PixelWatch::GetEvents(uint64_t since, uint64_t* next_seq) const {
+    ProfiledLock lock(mutex_);
+    std::vector<PixelProbeEvent> result;
+    const uint64_t oldest = next_event_seq_ - events_.size();
+    for (uint64_t seq = std::max(since + 1, oldest); seq < next_event_seq_; seq++) {
+        result.push_back(events_[(seq - 1) % kMaxEvents]);
+    }
+    *next_seq = next_event_seq_ - 1;
+    return result;
+}
+
+bool PixelWatch::Wait(const std::string& id, bool matched, int64_t timeout_ns, WaitCallback callback) {
+    ProfiledLock lock(mutex_);
+    Probe* probe = FindProbe(id);
+    if (!probe) return false;
+    if (probe->status.evaluated && probe->status.matched == matched) {
+        callback(WaitResult::kReached, probe->status);
+        return true;
+    }
+    waiters_.push_back({id, probe->serial, matched, trace::NowNs() + timeout_ns, std::move(callback)});
+    cv_.notify_one();  // the worker may need an earlier deadline
+    return true;
+}
+
+void PixelWatch::DropWaiters() {
+    ProfiledLock lock(mutex_);
+    waiters_.clear();
+}
+
+void PixelWatch::Stop() {
+    {
+        ProfiledLock lock(mutex_);
+        active_.store(false, std::memory_order_release);
+        stopping_ = true;
+        waiters_.clear();
+    }
+    cv_.notify_one();
+    if (worker_.joinable()) worker_.join();
+}
+
+void PixelWatch::QueueFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels) {
+    OX_TRACE_SCOPE("pixel_watch", "QueueFrame");
+    const int64_t now_ns = trace::NowNs();
+    ProfiledLock lock(mutex_);
+    frames_[eye]++;
+
+    if (latest_.pending(eye)) g_frames_skipped.Add();
+    FrameJob& job = latest_.Refill(eye);
+    job.frame = frames_[eye];
+    job.time_ns = now_ns;
+    job.samples.clear();
+    job.pixels.clear();
+    for (const ProbeSample& sample : samples_) {
+        if (sample.spec.eye != eye) continue;
+        job.samples.push_back(sample);
+        ProbeSample& copy = job.samples.back();
+        copy.fits = copy.spec.region.FitsIn(width, height);
+        if (!copy.fits) continue;
+        copy.offset = job.pixels.size();
+        job.pixels.resize(copy.offset + copy.spec.region.PixelCount() * 4);
+        CopyRegionRGBA(pixels, width, height, copy.spec.region, job.pixels.data() + copy.offset);
+    }
+    if (job.samples.empty()) return;
+    latest_.Publish(eye, stopping_);
+    cv_.notify_one();
+}
+
+void PixelWatch::Evaluate(FrameJob& job) {
+    OX_TRACE_SCOPE("pixel_watch", "Evaluate");
+    metrics::ScopedTimer timer(g_evaluate_duration);
+    for (ProbeSample& sample : job.samples) {
+        if (!sample.fits) {
+            sample.matched = false;
+            continue;
+        }
+        const PixelProbeSpec& spec = sample.spec;
+        const uint8_t* region = job.pixels.data() + sample.offset;
+        if (spec.kind == PixelProbeSpec::Kind::kColor) {
+            sample.matched = true;
+            for (int c = 0; c < 3; c++) {
+                sample.observed[c] = region[c];
+                sample.matched = sample.matched && std::abs(region[c] - spec.color[c]) <= spec.tolerance;
+            }
+        } else {
+            const size_t count = spec.region.PixelCount();
+            sample.value = static_cast<float>(static_cast<double>(SumLuma(region, count)) / (256.0 * count));
+            sample.matched = spec.above ? sample.value > spec.threshold : sample.value < spec.threshold;
+        }
+    }
+}
+
+void PixelWatch::ApplyResults(const FrameJob& job) {
+    for (const ProbeSample& sample : job.samples) {
+        auto it = std::find_if(probes_.begin(), probes_.end(),
+                               [&sample](const Probe& probe) { return probe.serial == sample.serial; });
+        if (it == probes_.end()) continue;  // removed or replaced since the frame was queued
+
+        PixelProbeStatus& status = it->status;
+        const bool changed = !status.evaluated || status.matched != sample.matched;
+        status.evaluated = true;
+        status.matched = sample.matched;
+        status.value = sample.value;
+        std::copy(sample.observed, sample.observed + 3, status.observed);
+        status.frame = job.frame;
+        if (!changed) continue;
+
+        status.transitions++;
+        status.changed_ns = job.time_ns;
+        g_transitions.Add();
+        if (events_.size() < kMaxEvents) events_.resize(events_.size() + 1);
+        PixelProbeEvent& event = events_[(next_event_seq_ - 1) % kMaxEvents];
+        event = {next_event_seq_++, status.id, status.matched, job.frame, job.time_ns};
+        if (!sample.fits) {
+            OX_LOG_WARN("Pixel probe %s: region is outside the frame", status.id.c_str());
+        } else {
+            OX_LOG_DEBUG("Pixel probe %s: %s at frame %llu", status.id.c_str(),
+                         status.matched ? "matched" : "unmatched", static_cast<unsigned long long>(job.frame));
+        }
+    }
+}
+
+void PixelWatch::CompleteWaiters(int64_t now_ns) {
+    auto done = [this, now_ns](Waiter& waiter) {
+        Probe* probe = FindProbe(waiter.id);
+        if (probe && probe->serial == waiter.serial && probe->status.evaluated &&
+            probe->status.matched == waiter.matched) {
+            waiter.callback(WaitResult::kReached, probe->status);
+            return true;
+        }
+        if (now_ns >= waiter.deadline_ns) {
+            waiter.callback(WaitResult::kTimedOut, probe ? probe->status : PixelProbeStatus());
+            return true;
+        }
+        return false;
+    };
+    waiters_.erase(std::remove_if(waiters_.begin(), waiters_.end(), done), waiters_.end());
+}
+
+void PixelWatch::RemoveWaiters(const std::string& id, uint64_t serial) {
+    auto removed = [&id, serial](Waiter& waiter) {
+        if (waiter.id != id || waiter.serial != serial) return false;
+        PixelProbeStatus status;
+        status.id = id;
+        waiter.callback(WaitResult::kRemoved, status);
+        return true;
+    };
+    waiters_.erase(std::remove_if(waiters_.begin(), waiters_.end(), removed), waiters_.end());
+}
+
+void PixelWatch::RebuildSamples() {
+    samples_.clear();
+    for (const Probe& probe : probes_) {
+        ProbeSample sample;
+        sample.serial = probe.serial;
+        sample.spec = probe.status.spec;
+        samples_.push_back(sample);
+    }
+    active_.store(!probes_.empty() && !stopping_, std::memory_order_release);
+}
+
+PixelWatch::Probe* PixelWatch::FindProbe(const std::string& id) {
+    for (Probe& probe : probes_) {
+        if (probe.status.id == id) return &probe;
+    }
+    return nullptr;
+}
+
+void PixelWatch::WorkerThread() {
+    ApplyThreadPlacement(ThreadClass::kWorker, "-probe");
+    ProfiledLock lock(mutex_);
+    while (!stopping_) {
+        if (latest_.Take() < 0) {
+            if (waiters_.empty()) {
+                cv_.wait(lock);
+            } else {
+                int64_t deadline_ns = INT64_MAX;
+                for (const Waiter& waiter : waiters_) deadline_ns = std::min(deadline_ns, waiter.deadline_ns);
+                cv_.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>(deadline_ns - trace::NowNs(), 0)));
+                CompleteWaiters(trace::NowNs());
+            }
+            continue;
+        }
+
+        FrameJob& job = latest_.taken();
+        lock.unlock();
+        Evaluate(job);
+        lock.lock();
+
+        ApplyResults(job);
+        g_frames_evaluated.Add();
+        CompleteWaiters(trace::NowNs());
+    }
+}
+
+}  // namespace ox_sim
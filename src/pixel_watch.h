@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latest_frames.h"
+#include "pixel_ops.h"
+#include "profiled_mutex.h"
+
+namespace ox_sim {
+
+// A pixel assertion on one eye's submitted frames.
+struct PixelProbeSpec {
+    enum class Kind {
+        kColor,       // the pixel at (region.x, region.y) is within `tolerance` of `color`
+        kBrightness,  // the mean brightness of `region` is above (or below) `threshold`
+    };
+
+    Kind kind = Kind::kColor;
+    uint32_t eye = 0;
+    PixelRect region;  // GET /v1/views coordinates; 1x1 for kColor
+
+    uint8_t color[3] = {0, 0, 0};
+    uint8_t tolerance = 16;  // largest R/G/B difference that still matches
+
+    bool above = true;
+    float threshold = 128.0f;  // BT.601 luma, 0-255
+};
+
+// Latest evaluation of one probe.
+struct PixelProbeStatus {
+    std::string id;
+    PixelProbeSpec spec;
+    bool evaluated = false;  // at least one frame of spec.eye has been checked
+    bool matched = false;
+    float value = 0.0f;               // kBrightness: measured mean brightness
+    uint8_t observed[3] = {0, 0, 0};  // kColor: measured R/G/B
+    uint64_t frame = 0;               // number of the last evaluated frame of spec.eye
+    uint64_t transitions = 0;         // changes of `matched`, the first evaluation included
+    int64_t changed_ns = 0;           // submit time of the frame that last changed `matched`
+};
+
+// A change of a probe's `matched` state, numbered in the order they were seen.
+struct PixelProbeEvent {
+    uint64_t seq = 0;
+    std::string id;
+    bool matched = false;
+    uint64_t frame = 0;
+    int64_t time_ns = 0;
+};
+
+// Evaluates registered pixel probes against submitted frames so tests can wait for what the app
+// renders without reading images back. The submit hook only copies the probed regions of the frame
+// into the eye's pending job and wakes the worker thread, which evaluates the probes (SumLuma or a
+// per-channel compare), records `matched` transitions as events and completes waiters. If the
+// worker falls behind, the pending job is replaced by the newer frame and the older one is skipped.
+class PixelWatch {
+   public:
+    enum class WaitResult { kReached, kTimedOut, kRemoved };
+
+    // Runs on the worker thread (or on the calling thread when the state already matches) with the
+    // probe's status at that point. Must not call back into PixelWatch.
+    using WaitCallback = std::function<void(WaitResult result, const PixelProbeStatus& status)>;
+
+    static constexpr size_t kMaxProbes = 64;
+    static constexpr size_t kMaxEvents = 1024;
+
+    PixelWatch() : mutex_("pixel_watch") {}
+    ~PixelWatch() { Stop(); }
+
+    // Add or replace probe `id`; a replaced probe starts over unevaluated and completes its waiters
+    // with kRemoved. Returns false once kMaxProbes probes exist. Starts the worker on first use.
+    bool SetProbe(const std::string& id, const PixelProbeSpec& spec);
+    bool RemoveProbe(const std::string& id);
+    void RemoveAll();
+
+    std::vector<PixelProbeStatus> GetProbes() const;
+    bool GetProbe(const std::string& id, PixelProbeStatus* status) const;
+
+    // Events with seq > `since`, oldest first (only the last kMaxEvents are kept). *next_seq is the
+    // seq to pass as `since` next time.
+    std::vector<PixelProbeEvent> GetEvents(uint64_t since, uint64_t* next_seq) const;
+
+    // Call `callback` once probe `id` has been evaluated with matched == `matched`, or after
+    // `timeout_ns`. Returns false (without calling it) if there is no such probe.
+    bool Wait(const std::string& id, bool matched, int64_t timeout_ns, WaitCallback callback);
+
+    // Forget all pending waiters without calling them. The HTTP server calls this once its event loop
+    // has exited, before the connections the callbacks refer to are destroyed.
+    void DropWaiters();
+
+    // Stop the worker thread and drop all waiters; probes are kept.
+    void Stop();
+
+    // Driver hook, called from submit_frame_pixels with RGBA8 pixels. A single atomic load unless a
+    // probe is registered.
+    void OnFrameSubmitted(uint32_t eye, uint32_t width, uint32_t height, const void* pixels, size_t size) {
+        if (!active_.load(std::memory_order_acquire) || eye > 1) return;
+        if (size < static_cast<size_t>(width) * height * 4) return;
+        QueueFrame(eye, width, height, static_cast<const uint8_t*>(pixels));
+    }
+
+   private:
+    struct Probe {
+        PixelProbeStatus status;
+        uint64_t serial = 0;  // changes whenever the probe is (re)registered
+    };
+
+    // A probe's geometry as captured at submit time, with its pixels in the job's buffer, and the
+    // worker's result for it.
+    struct ProbeSample {
+        uint64_t serial = 0;
+        PixelProbeSpec spec;
+        size_t offset = 0;  // into FrameJob::pixels
+        bool fits = false;  // the region was inside the frame
+        bool matched = false;
+        float value = 0.0f;
+        uint8_t observed[3] = {0, 0, 0};
+    };
+
+    struct FrameJob {
+        uint64_t frame = 0;
+        int64_t time_ns = 0;
+        std::vector<ProbeSample> samples;
+        std::vector<uint8_t> pixels;
+    };
+
+    struct Waiter {
+        std::string id;
+        uint64_t serial;
+        bool matched;
+        int64_t deadline_ns;
+        WaitCallback callback;
+    };
+
+    void QueueFrame(uint32_t eye, uint32_t width, uint32_t height, const uint8_t* pixels);
+    void WorkerThread();
+
+    static void Evaluate(FrameJob& job);
+
+    // All require mutex_.
+    void ApplyResults(const FrameJob& job);
+    void CompleteWaiters(int64_t now_ns);
+    void RemoveWaiters(const std::string& id, uint64_t serial);
+    void RebuildSamples();
+    Probe* FindProbe(const std::string& id);
+
+    // Guards everything below except worker_ and the taken job. The submit hook holds it only to copy the
+    // probed regions into the eye's pending job; the worker evaluates without it.
+    mutable ProfiledMutex mutex_;
+    std::condition_variable_any cv_;
+    std::atomic<bool> active_{false};
+    std::thread worker_;
+    bool stopping_ = false;
+
+    std::vector<Probe> probes_;
+    uint64_t next_serial_ = 1;
+    std::vector<ProbeSample> samples_;  // probes_ geometry, the template for each job's samples
+
+    uint64_t frames_[2] = {0, 0};    // frames seen per eye
+    LatestFrames<FrameJob> latest_;  // drained by the worker
+
+    std::vector<PixelProbeEvent> events_;  // ring of kMaxEvents
+    uint64_t next_event_seq_ = 1;
+
+    std::vector<Waiter> waiters_;
+};
+
+// Get the driver's pixel watch - implemented in driver.cpp
+PixelWatch* GetPixelWatch();
+
+}  // namespace ox_sim
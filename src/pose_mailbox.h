@@ -0,0 +1,89 @@
+#pragma once
+
+#include <ox_driver.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace ox_sim {
+
+// Single-slot, latest-value mailbox for one device's pose: any number of writers, one reader.
+//
+// A sequence-tagged slot (a seqlock whose writers never wait): the sequence is odd while a post is
+// being written and advances by 2 per completed post. A writer that finds another post in progress
+// gives up instead of waiting - the two posts overlap, so ordering the loser first and letting the
+// other overwrite it is a valid outcome. The reader copies the slot and retries if the sequence
+// moved underneath it.
+//
+// `tag` identifies what the pose belongs to (SimulatorCore uses the device profile), so a post that
+// raced a profile switch can be recognised and discarded by the reader.
+class PoseMailbox {
+   public:
+    // Returns false if the post lost to a concurrent one (and was thereby coalesced).
+    bool Post(const OxPose& pose, bool is_active, const void* tag) {
+        uint64_t seq = seq_.load(std::memory_order_relaxed);
+        if ((seq & 1) || !seq_.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+            return false;
+        }
+        float values[kWords - 1];
+        std::memcpy(values, &pose, sizeof(values));
+        for (int i = 0; i < kWords - 1; i++) words_[i].store(Bits(values[i]), std::memory_order_relaxed);
+        words_[kWords - 1].store(is_active ? 1u : 0u, std::memory_order_relaxed);
+        tag_.store(tag, std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+        return true;
+    }
+
+    // Reader only. If anything was posted since the last Take(), copy out the newest post and return
+    // true; *coalesced is the number of completed posts it replaced unread. Returns false if nothing
+    // new was posted or every attempt overlapped a post (the next Take() picks it up).
+    bool Take(OxPose* pose, bool* is_active, const void** tag, uint64_t* coalesced) {
+        for (int attempt = 0; attempt < kReadAttempts; attempt++) {
+            const uint64_t seq = seq_.load(std::memory_order_acquire);
+            if (seq == taken_seq_) return false;
+            if (seq & 1) continue;
+
+            float values[kWords - 1];
+            for (int i = 0; i < kWords - 1; i++) values[i] = Float(words_[i].load(std::memory_order_relaxed));
+            const bool active = words_[kWords - 1].load(std::memory_order_relaxed) != 0;
+            const void* posted_tag = tag_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) != seq) continue;
+
+            std::memcpy(pose, values, sizeof(values));
+            *is_active = active;
+            *tag = posted_tag;
+            *coalesced = (seq - taken_seq_) / 2 - 1;
+            taken_seq_ = seq;
+            return true;
+        }
+        return false;
+    }
+
+    // Reader only: forget anything posted so far.
+    void Discard() { taken_seq_ = seq_.load(std::memory_order_acquire) & ~uint64_t{1}; }
+
+   private:
+    static_assert(sizeof(OxPose) == 7 * sizeof(float), "OxPose is expected to be position + orientation floats");
+    static constexpr int kWords = 8;  // 7 pose floats, is_active
+    static constexpr int kReadAttempts = 4;
+
+    static uint32_t Bits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+    static float Float(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<uint32_t> words_[kWords] = {};
+    std::atomic<const void*> tag_{nullptr};
+    uint64_t taken_seq_ = 0;
+};
+
+}  // namespace ox_sim
@@ -0,0 +1,202 @@
+#include "profiled_mutex.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+namespace ox_sim {
+
+namespace {
+
+// Fixed-size open-addressing table of call sites. Slots are claimed with a CAS on their key and
+// never freed, so recording never allocates or takes a lock.
+constexpr size_t kMaxSites = 256;  // must be a power of two
+
+struct SiteSlot {
+    std::atomic<uint64_t> key{0};  // 0 = free
+    std::atomic<bool> ready{false};
+    const char* lock_name = nullptr;
+    const char* file = nullptr;
+    const char* function = nullptr;
+    int line = 0;
+
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> wait_ns_total{0};
+    std::atomic<uint64_t> wait_ns_max{0};
+    std::atomic<uint64_t> hold_ns_total{0};
+    std::atomic<uint64_t> hold_ns_max{0};
+};
+
+SiteSlot g_sites[kMaxSites];
+std::atomic<bool> g_enabled{false};
+
+#ifdef OX_SIM_LOCK_PROFILING
+uint64_t SiteKey(const char* lock_name, const char* file, int line) {
+    uint64_t h = std::hash<const void*>()(lock_name);
+    h = h * 0x9E3779B97F4A7C15ull ^ std::hash<const void*>()(file);
+    h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(line);
+    return h ? h : 1;
+}
+
+SiteSlot* FindOrInsertSite(const char* lock_name, const char* file, int line, const char* function) {
+    const uint64_t key = SiteKey(lock_name, file, line);
+    for (size_t probe = 0; probe < kMaxSites; probe++) {
+        SiteSlot& slot = g_sites[(key + probe) & (kMaxSites - 1)];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                slot.lock_name = lock_name;
+                slot.file = file;
+                slot.line = line;
+                slot.function = function;
+                slot.ready.store(true, std::memory_order_release);
+                return &slot;
+            }
+            // Lost the race; `current` now holds the winner's key.
+        }
+        if (current == key) return &slot;
+    }
+    return nullptr;  // table full: this site goes unprofiled
+}
+#endif
+
+void UpdateMax(std::atomic<uint64_t>& max, uint64_t value) {
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t ToNs(metrics::Clock::duration d) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+}
+
+std::string Labels(const char* name) { return std::string("lock=\"") + name + "\""; }
+
+}  // namespace
+
+ProfiledMutex::ProfiledMutex(const char* name)
+    : name_(name),
+      wait_("ox_lock_wait_seconds", "Time spent waiting to acquire simulator locks", Labels(name).c_str()),
+      hold_("ox_lock_hold_seconds", "Time simulator locks were held (recorded while lock profiling is enabled)",
+            Labels(name).c_str()) {}
+
+ProfiledLock::ProfiledLock(ProfiledMutex& mutex, const char* file, int line, const char* function)
+    : mutex_(mutex), file_(file), function_(function), line_(line) {
+    lock();
+}
+
+ProfiledLock::~ProfiledLock() {
+    if (locked_) unlock();
+}
+
+void ProfiledLock::lock() {
+    locked_ = true;
+#ifdef OX_SIM_LOCK_PROFILING
+    if (g_enabled.load(std::memory_order_relaxed)) {
+        SiteSlot* site = FindOrInsertSite(mutex_.name_, file_, line_, function_);
+        const metrics::Clock::time_point start = metrics::Clock::now();
+        const bool contended = !mutex_.mutex_.try_lock();
+        if (contended) mutex_.mutex_.lock();
+        acquired_ = metrics::Clock::now();
+
+        const uint64_t wait_ns = contended ? ToNs(acquired_ - start) : 0;
+        mutex_.wait_.Observe(contended ? acquired_ - start : metrics::Clock::duration::zero());
+        if (site) {
+            site->acquisitions.fetch_add(1, std::memory_order_relaxed);
+            if (contended) site->contended.fetch_add(1, std::memory_order_relaxed);
+            site->wait_ns_total.fetch_add(wait_ns, std::memory_order_relaxed);
+            UpdateMax(site->wait_ns_max, wait_ns);
+        }
+        site_ = site;
+        profiled_ = true;
+        return;
+    }
+#else
+    (void)file_;
+    (void)line_;
+    (void)function_;
+#endif
+    // Profiling off: only the wait histogram, and no clock reads unless we actually block.
+    profiled_ = false;
+    if (mutex_.mutex_.try_lock()) {
+        mutex_.wait_.Observe(metrics::Clock::duration::zero());
+        return;
+    }
+    const metrics::Clock::time_point start = metrics::Clock::now();
+    mutex_.mutex_.lock();
+    mutex_.wait_.Observe(metrics::Clock::now() - start);
+}
+
+void ProfiledLock::unlock() {
+    locked_ = false;
+    if (profiled_) {
+        const metrics::Clock::duration held = metrics::Clock::now() - acquired_;
+        mutex_.mutex_.unlock();
+        mutex_.hold_.Observe(held);
+        if (site_) {
+            SiteSlot* site = static_cast<SiteSlot*>(site_);
+            const uint64_t hold_ns = ToNs(held);
+            site->hold_ns_total.fetch_add(hold_ns, std::memory_order_relaxed);
+            UpdateMax(site->hold_ns_max, hold_ns);
+        }
+        return;
+    }
+    mutex_.mutex_.unlock();
+}
+
+namespace lock_profiler {
+
+bool IsCompiledIn() {
+#ifdef OX_SIM_LOCK_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SetEnabled(bool enabled) { g_enabled.store(enabled && IsCompiledIn(), std::memory_order_relaxed); }
+
+bool IsEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void Reset() {
+    for (SiteSlot& slot : g_sites) {
+        slot.acquisitions.store(0, std::memory_order_relaxed);
+        slot.contended.store(0, std::memory_order_relaxed);
+        slot.wait_ns_total.store(0, std::memory_order_relaxed);
+        slot.wait_ns_max.store(0, std::memory_order_relaxed);
+        slot.hold_ns_total.store(0, std::memory_order_relaxed);
+        slot.hold_ns_max.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::vector<LockSiteStats> TopContendedSites(size_t count) {
+    std::vector<LockSiteStats> sites;
+    for (const SiteSlot& slot : g_sites) {
+        if (!slot.ready.load(std::memory_order_acquire)) continue;
+        LockSiteStats s;
+        s.lock_name = slot.lock_name;
+        s.file = slot.file;
+        s.function = slot.function;
+        s.line = slot.line;
+        s.acquisitions = slot.acquisitions.load(std::memory_order_relaxed);
+        s.contended = slot.contended.load(std::memory_order_relaxed);
+        s.wait_ns_total = slot.wait_ns_total.load(std::memory_order_relaxed);
+        s.wait_ns_max = slot.wait_ns_max.load(std::memory_order_relaxed);
+        s.hold_ns_total = slot.hold_ns_total.load(std::memory_order_relaxed);
+        s.hold_ns_max = slot.hold_ns_max.load(std::memory_order_relaxed);
+        if (s.acquisitions == 0) continue;
+        sites.push_back(s);
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const LockSiteStats& a, const LockSiteStats& b) {
+        if (a.wait_ns_total != b.wait_ns_total) return a.wait_ns_total > b.wait_ns_total;
+        return a.contended > b.contended;
+    });
+    if (sites.size() > count) sites.resize(count);
+    return sites;
+}
+
+}  // namespace lock_profiler
+
+}  // namespace ox_sim
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+
+namespace ox_sim {
+
+// Per-call-site contention statistics, aggregated over all ProfiledLock acquisitions made
+// from one source location on one named lock.
+struct LockSiteStats {
+    const char* lock_name;
+    const char* file;
+    const char* function;
+    int line;
+    uint64_t acquisitions;
+    uint64_t contended;  // acquisitions that had to block
+    uint64_t wait_ns_total;
+    uint64_t wait_ns_max;
+    uint64_t hold_ns_total;
+    uint64_t hold_ns_max;
+};
+
+// std::mutex wrapper that feeds ox_lock_wait_seconds{lock="<name>"} and, while lock profiling is
+// enabled, per-call-site acquisition/wait/hold statistics. Acquire it through ProfiledLock.
+class ProfiledMutex {
+   public:
+    // `name` must be a string literal; it labels the metrics series and the profiler report.
+    explicit ProfiledMutex(const char* name);
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    const char* name() const { return name_; }
+
+   private:
+    friend class ProfiledLock;
+
+    std::mutex mutex_;
+    const char* name_;
+    metrics::Histogram wait_;
+    metrics::Histogram hold_;
+};
+
+// Scoped lock for ProfiledMutex. The call site is captured from the constructor's default
+// arguments, so call it exactly like std::lock_guard: `ProfiledLock lock(state_mutex_);`.
+//
+// Like std::unique_lock it can be released and retaken with unlock()/lock(), which also makes it
+// usable with std::condition_variable_any. Each retake counts as another acquisition at the same
+// call site, and time spent unlocked is not counted as hold time.
+class ProfiledLock {
+   public:
+    explicit ProfiledLock(ProfiledMutex& mutex, const char* file = __builtin_FILE(), int line = __builtin_LINE(),
+                          const char* function = __builtin_FUNCTION());
+    ~ProfiledLock();
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    void lock();
+    void unlock();
+
+   private:
+    ProfiledMutex& mutex_;
+    const char* file_;
+    const char* function_;
+    int line_;
+    bool locked_ = false;
+    bool profiled_ = false;  // profiling was enabled when the lock was taken
+    void* site_ = nullptr;   // profiler slot for this call site (null if the site table is full)
+    metrics::Clock::time_point acquired_;
+};
+
+namespace lock_profiler {
+
+// Whether per-site profiling was compiled in (CMake option OX_SIM_LOCK_PROFILING).
+bool IsCompiledIn();
+
+// Runtime switch for per-site profiling (config.json "lock_profiling", PUT /v1/locks).
+// Has no effect when profiling is not compiled in.
+void SetEnabled(bool enabled);
+bool IsEnabled();
+
+// Clear all per-site statistics.
+void Reset();
+
+// The `count` call sites with the most total wait time, most contended first.
+std::vector<LockSiteStats> TopContendedSites(size_t count);
+
+}  // namespace lock_profiler
+
+}  // namespace ox_sim
@@ -0,0 +1,100 @@
+#include "qoi.h"
+
+#include <cstring>
+
+namespace ox_sim {
+
+namespace {
+
+constexpr uint8_t kOpIndex = 0x00;
+constexpr uint8_t kOpDiff = 0x40;
+constexpr uint8_t kOpLuma = 0x80;
+constexpr uint8_t kOpRun = 0xc0;
+constexpr uint8_t kOpRGB = 0xfe;
+constexpr uint8_t kOpRGBA = 0xff;
+constexpr int kMaxRun = 62;
+constexpr uint8_t kEndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+uint32_t Load(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void PutBigEndian(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+}  // namespace
+
+void EncodeQoi(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>* out) {
+    const size_t pixel_count = static_cast<size_t>(width) * height;
+    const size_t start = out->size();
+    // Worst case is 5 bytes per pixel (QOI_OP_RGBA); shrink to the real size at the end.
+    out->resize(start + 14 + pixel_count * 5 + sizeof(kEndMarker));
+    uint8_t* p = out->data() + start;
+
+    std::memcpy(p, "qoif", 4);
+    PutBigEndian(p + 4, width);
+    PutBigEndian(p + 8, height);
+    p[12] = 4;  // channels
+    p[13] = 0;  // sRGB with linear alpha
+    p += 14;
+
+    uint32_t index[64] = {};
+    uint8_t prev[4] = {0, 0, 0, 255};
+    int run = 0;
+    for (size_t i = 0; i < pixel_count; i++) {
+        const uint8_t* px = rgba + i * 4;
+        if (Load(px) == Load(prev)) {
+            if (++run == kMaxRun) {
+                *p++ = kOpRun | (run - 1);
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *p++ = kOpRun | (run - 1);
+            run = 0;
+        }
+
+        const int slot = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (index[slot] == Load(px)) {
+            *p++ = kOpIndex | slot;
+        } else {
+            index[slot] = Load(px);
+            if (px[3] == prev[3]) {
+                const int8_t dr = static_cast<int8_t>(px[0] - prev[0]);
+                const int8_t dg = static_cast<int8_t>(px[1] - prev[1]);
+                const int8_t db = static_cast<int8_t>(px[2] - prev[2]);
+                const int8_t dr_dg = static_cast<int8_t>(dr - dg);
+                const int8_t db_dg = static_cast<int8_t>(db - dg);
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *p++ = kOpDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+                } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                    *p++ = kOpLuma | (dg + 32);
+                    *p++ = static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8));
+                } else {
+                    *p++ = kOpRGB;
+                    std::memcpy(p, px, 3);
+                    p += 3;
+                }
+            } else {
+                *p++ = kOpRGBA;
+                std::memcpy(p, px, 4);
+                p += 4;
+            }
+        }
+        std::memcpy(prev, px, 4);
+    }
+    if (run > 0) *p++ = kOpRun | (run - 1);
+
+    std::memcpy(p, kEndMarker, sizeof(kEndMarker));
+    p += sizeof(kEndMarker);
+    out->resize(p - out->data());
+}
+
+}  // namespace ox_sim
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ox_sim {
+
+// Encode tightly packed, top-row-first RGBA8 pixels as a QOI image ("Quite OK Image" format,
+// https://qoiformat.org) and append it to `out`. QOI is lossless and encodes in a single pass with a
+// 64-entry color cache. It compresses rendered frames about as well as a fast PNG encoder at a
+// fraction of the cost, cheap enough to keep up with frames as they arrive.
+void EncodeQoi(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>* out);
+
+}  // namespace ox_sim
@@ -0,0 +1,250 @@
+#include "scenario.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "log.h"
+#include "trace.h"
+
+namespace ox_sim {
+
+namespace {
+
+OxQuaternion Slerp(const OxQuaternion& a, OxQuaternion b, float t) {
+    float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    if (dot < 0.0f) {  // take the short way round
+        b = {-b.x, -b.y, -b.z, -b.w};
+        dot = -dot;
+    }
+
+    float wa = 1.0f - t;
+    float wb = t;
+    if (dot < 0.9995f) {
+        const float theta = std::acos(dot);
+        const float sin_theta = std::sin(theta);
+        wa = std::sin(wa * theta) / sin_theta;
+        wb = std::sin(wb * theta) / sin_theta;
+    }
+
+    OxQuaternion q = {wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z, wa * a.w + wb * b.w};
+    const float len = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (len > 0.0f) {
+        q.x /= len;
+        q.y /= len;
+        q.z /= len;
+        q.w /= len;
+    }
+    return q;
+}
+
+float Lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+}  // namespace
+
+const char* ScenarioRunner::StateName(State state) {
+    switch (state) {
+        case State::kIdle:
+            return "idle";
+        case State::kRunning:
+            return "running";
+        case State::kWaiting:
+            return "waiting";
+        case State::kFinished:
+            return "finished";
+        case State::kFailed:
+            return "failed";
+    }
+    return "unknown";
+}
+
+void ScenarioRunner::Start(Scenario scenario, SimulatorCore* simulator, const DeviceProfile** device_profile_ptr) {
+    ProfiledLock lock(mutex_);
+    scenario_ = std::move(scenario);
+    simulator_ = simulator;
+    device_profile_ptr_ = device_profile_ptr;
+    state_ = State::kRunning;
+    error_.clear();
+    started_ = false;
+    time_ns_ = 0;
+    next_event_ = 0;
+    frames_ = 0;
+    wait_ = nullptr;
+    active_segments_.assign(scenario_.targets.size(), -1);
+
+    last_time_.store(INT64_MIN, std::memory_order_relaxed);
+    active_.store(true, std::memory_order_release);
+    OX_LOG_INFO("Scenario started: %zu events, %.3f s", scenario_.events.size(),
+                static_cast<double>(scenario_.duration_ns) / 1e9);
+}
+
+void ScenarioRunner::Stop() {
+    ProfiledLock lock(mutex_);
+    if (state_ == State::kRunning || state_ == State::kWaiting) {
+        Finish(State::kIdle, "");
+        OX_LOG_INFO("Scenario stopped");
+    }
+}
+
+ScenarioRunner::Status ScenarioRunner::GetStatus() const {
+    ProfiledLock lock(mutex_);
+    Status status;
+    status.state = state_;
+    status.time_ns = time_ns_;
+    status.duration_ns = scenario_.duration_ns;
+    status.next_event = next_event_;
+    status.event_count = scenario_.events.size();
+    status.frames = frames_;
+    status.error = error_;
+    return status;
+}
+
+void ScenarioRunner::Finish(State state, std::string error) {
+    state_ = state;
+    error_ = std::move(error);
+    wait_ = nullptr;
+    active_.store(false, std::memory_order_release);
+}
+
+bool ScenarioRunner::WaitSatisfied(const ScenarioEvent& wait, uint32_t session_state) const {
+    if (wait.type == ScenarioEvent::Type::kWaitSession) {
+        return session_state == wait.session_state;
+    }
+    return frames_ - wait_start_frames_ >= wait.frames;
+}
+
+void ScenarioRunner::Apply(const ScenarioEvent& event) {
+    if (event.type == ScenarioEvent::Type::kSwitchProfile) {
+        if (simulator_->SwitchDevice(event.profile)) {
+            *device_profile_ptr_ = event.profile;
+            // Segments of the previous profile's devices are meaningless now.
+            std::fill(active_segments_.begin(), active_segments_.end(), -1);
+        } else {
+            OX_LOG_WARN("Scenario: failed to switch to %s", event.profile->name);
+        }
+        return;
+    }
+
+    const ScenarioTarget& target = scenario_.targets[event.target];
+    const char* user_path = target.user_path.c_str();
+    const char* component_path = target.component_path.c_str();
+    if (event.type == ScenarioEvent::Type::kSetPose) {
+        simulator_->SetDevicePose(user_path, event.pose, event.active);
+        return;
+    }
+    switch (target.type) {
+        case ComponentType::BOOLEAN:
+            simulator_->SetInputStateBoolean(user_path, component_path, std::get<bool>(event.value));
+            break;
+        case ComponentType::FLOAT:
+            simulator_->SetInputStateFloat(user_path, component_path, std::get<float>(event.value));
+            break;
+        case ComponentType::VEC2:
+            simulator_->SetInputStateVec2(user_path, component_path, std::get<OxVector2f>(event.value));
+            break;
+    }
+}
+
+void ScenarioRunner::ApplySegment(const ScenarioEvent& segment, int64_t time_ns) {
+    const ScenarioTarget& target = scenario_.targets[segment.target];
+    const int64_t length = segment.end_ns - segment.time_ns;
+    const float t = length > 0 ? std::clamp(static_cast<float>(static_cast<double>(time_ns - segment.time_ns) /
+                                                               static_cast<double>(length)),
+                                            0.0f, 1.0f)
+                               : 1.0f;
+
+    if (segment.type == ScenarioEvent::Type::kPoseSegment) {
+        OxPose pose;
+        pose.position.x = Lerp(segment.pose.position.x, segment.pose_end.position.x, t);
+        pose.position.y = Lerp(segment.pose.position.y, segment.pose_end.position.y, t);
+        pose.position.z = Lerp(segment.pose.position.z, segment.pose_end.position.z, t);
+        pose.orientation = Slerp(segment.pose.orientation, segment.pose_end.orientation, t);
+        simulator_->SetDevicePose(target.user_path.c_str(), pose, t >= 1.0f ? segment.active_end : segment.active);
+    } else if (target.type == ComponentType::VEC2) {
+        const OxVector2f& a = std::get<OxVector2f>(segment.value);
+        const OxVector2f& b = std::get<OxVector2f>(segment.value_end);
+        simulator_->SetInputStateVec2(target.user_path.c_str(), target.component_path.c_str(),
+                                      {Lerp(a.x, b.x, t), Lerp(a.y, b.y, t)});
+    } else {
+        simulator_->SetInputStateFloat(
+            target.user_path.c_str(), target.component_path.c_str(),
+            Lerp(std::get<float>(segment.value), std::get<float>(segment.value_end), t));
+    }
+}
+
+void ScenarioRunner::AdvanceFrame(int64_t predicted_time, uint32_t session_state) {
+    OX_TRACE_SCOPE("scenario", "AdvanceFrame");
+    ProfiledLock lock(mutex_);
+    const int64_t previous_time = last_time_.load(std::memory_order_relaxed);
+    if (!active_.load(std::memory_order_relaxed) || predicted_time <= previous_time) {
+        return;  // another callback of the same frame got here first
+    }
+    last_time_.store(predicted_time, std::memory_order_relaxed);
+    frames_++;
+
+    if (!started_) {
+        started_ = true;  // the first frame plays time 0
+    } else if (state_ == State::kWaiting) {
+        if (wait_->timeout_ns > 0 && predicted_time - wait_start_time_ >= wait_->timeout_ns) {
+            OX_LOG_WARN("Scenario: wait at %.3f s timed out", static_cast<double>(wait_->time_ns) / 1e9);
+            Finish(State::kFailed, "wait timed out");
+            return;
+        }
+        if (!WaitSatisfied(*wait_, session_state)) {
+            return;
+        }
+        // The clock resumes from the wait's time on the next frame.
+        wait_ = nullptr;
+        state_ = State::kRunning;
+    } else {
+        time_ns_ += scenario_.clock == Scenario::Clock::kFrames ? scenario_.frame_step_ns
+                                                                 : predicted_time - previous_time;
+    }
+
+    const std::vector<ScenarioEvent>& events = scenario_.events;
+    while (next_event_ < events.size() && events[next_event_].time_ns <= time_ns_) {
+        const size_t index = next_event_++;
+        const ScenarioEvent& event = events[index];
+        switch (event.type) {
+            case ScenarioEvent::Type::kPoseSegment:
+            case ScenarioEvent::Type::kInputSegment:
+                active_segments_[event.target] = static_cast<int32_t>(index);
+                break;
+            case ScenarioEvent::Type::kWaitSession:
+            case ScenarioEvent::Type::kWaitFrames:
+                wait_start_time_ = predicted_time;
+                wait_start_frames_ = frames_;
+                if (WaitSatisfied(event, session_state)) {
+                    break;
+                }
+                // Stop the clock at the wait so what follows keeps its spacing relative to it.
+                time_ns_ = event.time_ns;
+                wait_ = &event;
+                state_ = State::kWaiting;
+                break;
+            default:  // poses, inputs and profile switches
+                Apply(event);
+                break;
+        }
+        if (state_ == State::kWaiting) break;
+    }
+
+    bool segments_running = false;
+    for (int32_t& index : active_segments_) {
+        if (index < 0) continue;
+        const ScenarioEvent& segment = events[index];
+        ApplySegment(segment, time_ns_);
+        if (time_ns_ >= segment.end_ns) {
+            index = -1;
+        } else {
+            segments_running = true;
+        }
+    }
+
+    if (state_ == State::kRunning && next_event_ == events.size() && !segments_running) {
+        OX_LOG_INFO("Scenario finished after %llu frames", static_cast<unsigned long long>(frames_));
+        Finish(State::kFinished, "");
+    }
+}
+
+}  // namespace ox_sim
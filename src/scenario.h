@@ -0,0 +1,144 @@
+#pragma once
+
+#include <ox_driver.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "device_profiles.h"
+#include "profiled_mutex.h"
+#include "simulator_core.h"
+
+namespace ox_sim {
+
+// A pose or input component driven by a scenario.
+struct ScenarioTarget {
+    std::string user_path;       // e.g. "/user/hand/right"
+    std::string component_path;  // e.g. "/input/trigger/value"; empty for a device pose
+    ComponentType type = ComponentType::FLOAT;
+};
+
+struct ScenarioEvent {
+    enum class Type : uint8_t {
+        kSetPose,        // pose at time_ns
+        kSetInput,       // value at time_ns
+        kPoseSegment,    // pose moving from pose to pose_end over [time_ns, end_ns]
+        kInputSegment,   // FLOAT/VEC2 value moving from value to value_end over [time_ns, end_ns]
+        kSwitchProfile,  // switch to profile
+        kWaitSession,    // pause the scenario clock until the session reaches session_state
+        kWaitFrames,     // pause the scenario clock for `frames` frames
+    };
+
+    Type type;
+    int64_t time_ns;  // scenario time the event fires at
+    int64_t end_ns;   // segments: when the target reaches its end value
+    uint32_t target;  // index into Scenario::targets (poses and inputs)
+
+    OxPose pose;
+    OxPose pose_end;
+    bool active;
+    bool active_end;  // pose segments: active flag once the end pose is reached
+    InputValue value;
+    InputValue value_end;
+
+    const DeviceProfile* profile;
+    uint32_t session_state;  // OxSessionState
+    uint64_t frames;
+    int64_t timeout_ns;  // waits; 0 waits forever
+};
+
+// A compiled scenario (see CompileScenario() in the API): every keyframe pair, value change,
+// profile switch and wait as one flat array sorted by time. At equal times profile switches come
+// first, then waits, then pose and input changes.
+struct Scenario {
+    enum class Clock {
+        kPredictedTime,  // scenario time follows the frames' predicted_time
+        kFrames,         // scenario time advances by frame_step_ns per frame, whatever the app's frame rate
+    };
+
+    Clock clock = Clock::kPredictedTime;
+    int64_t frame_step_ns = 0;
+    std::vector<ScenarioTarget> targets;
+    std::vector<ScenarioEvent> events;
+    int64_t duration_ns = 0;  // scenario time of the last event or segment end, not counting waits
+};
+
+// Plays a Scenario against a SimulatorCore from the driver's frame callbacks.
+//
+// Each frame (each new predicted_time) advances the scenario clock, fires the events that are due
+// and evaluates the active keyframe segments at the frame's exact scenario time, so motion is
+// sampled where the app will render it rather than where the last HTTP call left it. Waits stop the
+// clock: later events keep their spacing relative to the wait.
+class ScenarioRunner {
+   public:
+    enum class State { kIdle, kRunning, kWaiting, kFinished, kFailed };
+
+    struct Status {
+        State state = State::kIdle;
+        int64_t time_ns = 0;      // current scenario time
+        int64_t duration_ns = 0;  // Scenario::duration_ns
+        size_t next_event = 0;
+        size_t event_count = 0;
+        uint64_t frames = 0;  // frames since Start()
+        std::string error;    // kFailed
+    };
+
+    ScenarioRunner() : mutex_("scenario") {}
+
+    // Replace any running scenario with `scenario`; it starts on the next frame. Profile switches
+    // call simulator->SwitchDevice() and update *device_profile_ptr, as PUT /v1/profile does.
+    void Start(Scenario scenario, SimulatorCore* simulator, const DeviceProfile** device_profile_ptr);
+
+    // Stop the running scenario, leaving poses and inputs where they are.
+    void Stop();
+
+    Status GetStatus() const;
+
+    // Driver hook, called from the frame callbacks with the frame's predicted_time. Only the first
+    // call for a new (later) predicted_time does any work; the rest return after two atomic loads.
+    void Advance(int64_t predicted_time, uint32_t session_state) {
+        if (!active_.load(std::memory_order_acquire) || predicted_time <= last_time_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        AdvanceFrame(predicted_time, session_state);
+    }
+
+    static const char* StateName(State state);
+
+   private:
+    void AdvanceFrame(int64_t predicted_time, uint32_t session_state);
+
+    // All require mutex_.
+    bool WaitSatisfied(const ScenarioEvent& wait, uint32_t session_state) const;
+    void Apply(const ScenarioEvent& event);
+    void ApplySegment(const ScenarioEvent& segment, int64_t time_ns);
+    void Finish(State state, std::string error);
+
+    mutable ProfiledMutex mutex_;
+    std::atomic<bool> active_{false};
+    std::atomic<int64_t> last_time_{INT64_MIN};
+
+    Scenario scenario_;
+    SimulatorCore* simulator_ = nullptr;
+    const DeviceProfile** device_profile_ptr_ = nullptr;
+    State state_ = State::kIdle;
+    std::string error_;
+    bool started_ = false;
+    int64_t time_ns_ = 0;
+    size_t next_event_ = 0;
+    uint64_t frames_ = 0;
+
+    // kWaiting: the wait event and when it started
+    const ScenarioEvent* wait_ = nullptr;
+    int64_t wait_start_time_ = 0;
+    uint64_t wait_start_frames_ = 0;
+
+    std::vector<int32_t> active_segments_;  // per target: event index of its running segment, or -1
+};
+
+// Get the driver's scenario runner - implemented in driver.cpp
+ScenarioRunner* GetScenarioRunner();
+
+}  // namespace ox_sim
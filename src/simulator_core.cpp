@@ -1,12 +1,65 @@
 #include "simulator_core.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <unordered_map>
 
+#include "metrics.h"
+
 namespace ox_sim {
 
-SimulatorCore::SimulatorCore() : profile_(nullptr), state_{} { state_.device_count = 0; }
+// Indexed by ComponentType (FLOAT, BOOLEAN, VEC2).
+static metrics::Counter g_input_coalesced[3] = {
+    {"ox_input_changes_coalesced_total", "Input changes overwritten before any frame sampled them", "type=\"float\""},
+    {"ox_input_changes_coalesced_total", "Input changes overwritten before any frame sampled them",
+     "type=\"boolean\""},
+    {"ox_input_changes_coalesced_total", "Input changes overwritten before any frame sampled them", "type=\"vec2\""},
+};
+static metrics::Counter g_input_dropped[3] = {
+    {"ox_input_changes_dropped_total", "Latched input changes dropped because the latch queue was full",
+     "type=\"float\""},
+    {"ox_input_changes_dropped_total", "Latched input changes dropped because the latch queue was full",
+     "type=\"boolean\""},
+    {"ox_input_changes_dropped_total", "Latched input changes dropped because the latch queue was full",
+     "type=\"vec2\""},
+};
+
+static metrics::Counter g_pose_coalesced("ox_pose_writes_coalesced_total",
+                                         "Pose writes replaced by a newer one for the same device before any read");
+
+static metrics::Counter g_state_commits("ox_state_commits_total", "Batches of staged writes published by commit mode");
+static metrics::Counter g_staged_writes("ox_staged_writes_total", "Pose and input writes published by commit mode");
+static metrics::Counter g_staged_dropped("ox_staged_writes_dropped_total",
+                                         "Staged writes dropped because the staging buffer was full");
+
+// Commit mode without frames (an app that stopped rendering) must not grow the buffer forever.
+static constexpr size_t kMaxStagedWrites = 4096;
+
+static bool SameValue(const InputValue& a, const InputValue& b) {
+    if (a.index() != b.index()) return false;
+    if (const bool* va = std::get_if<bool>(&a)) return *va == std::get<bool>(b);
+    if (const float* va = std::get_if<float>(&a)) return *va == std::get<float>(b);
+    const OxVector2f& va = std::get<OxVector2f>(a);
+    const OxVector2f& vb = std::get<OxVector2f>(b);
+    return va.x == vb.x && va.y == vb.y;
+}
+
+bool ParseInputLatchPolicy(const std::string& name, InputLatchPolicy* out) {
+    if (name == "level") {
+        *out = InputLatchPolicy::kLevel;
+    } else if (name == "latch") {
+        *out = InputLatchPolicy::kLatch;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SimulatorCore::SimulatorCore()
+    : profile_(nullptr), state_{}, state_mutex_("state_mutex"), staging_mutex_("staging_mutex") {
+    state_.device_count = 0;
+}
 
 SimulatorCore::~SimulatorCore() { Shutdown(); }
 
@@ -73,8 +126,10 @@ bool SimulatorCore::Initialize(const DeviceProfile* profile) {
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(state_mutex_);
+    ProfiledLock lock(state_mutex_);
     profile_ = profile;
+    generators_.clear();
+    for (PoseMailbox& mailbox : pose_mailboxes_) mailbox.Discard();
 
     // Initialize devices from profile
     state_.device_count = std::min(static_cast<size_t>(OX_MAX_DEVICES), profile->devices.size());
@@ -95,6 +150,7 @@ bool SimulatorCore::Initialize(const DeviceProfile* profile) {
         // Initialize input state (all components to zero/false)
         size_t max_component_index = dev_def.components.size();
         state_.device_inputs[i].values.resize(max_component_index);
+        input_latches_[i].assign(max_component_index, InputLatch{});
 
         // Pre-populate all components for this device
         for (size_t comp_index = 0; comp_index < dev_def.components.size(); ++comp_index) {
@@ -113,30 +169,65 @@ bool SimulatorCore::Initialize(const DeviceProfile* profile) {
         }
     }
 
+    mailbox_profile_.store(profile, std::memory_order_release);
     return true;
 }
 
 bool SimulatorCore::SwitchDevice(const DeviceProfile* profile) {
     Shutdown();
-    return Initialize(profile);
+    const bool ok = Initialize(profile);
+    NotifyChanged();
+    return ok;
+}
+
+void SimulatorCore::SetChangeListener(ChangeListener listener, void* context) {
+    change_listener_.store(nullptr, std::memory_order_release);
+    change_listener_context_.store(context, std::memory_order_release);
+    change_listener_.store(listener, std::memory_order_release);
+}
+
+void SimulatorCore::NotifyChanged() {
+    if (ChangeListener listener = change_listener_.load(std::memory_order_acquire)) {
+        listener(change_listener_context_.load(std::memory_order_acquire));
+    }
 }
 
 void SimulatorCore::Shutdown() {
-    std::lock_guard<std::mutex> lock(state_mutex_);
+    ProfiledLock lock(state_mutex_);
+    mailbox_profile_.store(nullptr, std::memory_order_release);
     profile_ = nullptr;
     state_.device_count = 0;
+    generators_.clear();
+    for (auto& latches : input_latches_) latches.clear();
+
+    ProfiledLock staging_lock(staging_mutex_);
+    staged_.clear();
+    staged_pending_.store(false, std::memory_order_release);
 }
 
 void SimulatorCore::UpdateAllDevices(OxDeviceState* out_states, uint32_t* out_count) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
+    ProfiledLock lock(state_mutex_);
+    DrainPoseMailboxes();
     *out_count = state_.device_count;
     for (uint32_t i = 0; i < state_.device_count && i < OX_MAX_DEVICES; i++) {
         out_states[i] = state_.devices[i];
     }
 }
 
+const DeviceProfile* SimulatorCore::GetSnapshot(DeviceState* out) {
+    ProfiledLock lock(state_mutex_);
+    DrainPoseMailboxes();
+    out->device_count = state_.device_count;
+    for (uint32_t i = 0; i < state_.device_count; i++) {
+        out->devices[i] = state_.devices[i];
+        out->device_inputs[i].values = state_.device_inputs[i].values;
+    }
+    return profile_;
+}
+
 bool SimulatorCore::GetDevicePose(const char* user_path, OxPose* out_pose, bool* out_is_active) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
+    ProfiledLock lock(state_mutex_);
+    DrainPoseMailboxes();
 
     int device_index = FindDeviceIndexByUserPath(user_path);
     if (device_index < 0) {
@@ -149,41 +240,87 @@ bool SimulatorCore::GetDevicePose(const char* user_path, OxPose* out_pose, bool*
 }
 
 void SimulatorCore::SetDevicePose(const char* user_path, const OxPose& pose, bool is_active) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (Stage(StagedWrite::Kind::kPose, user_path, "", &pose, is_active, InputValue{})) return;
+    PostPose(user_path, pose, is_active);
+    NotifyChanged();
+}
 
+void SimulatorCore::StorePose(const char* user_path, const OxPose& pose, bool is_active) {
     // Find the device by user path
     int device_index = FindDeviceIndexByUserPath(user_path);
-    const DeviceDef* device_def = FindDeviceDefByUserPath(user_path);
     if (device_index < 0) {
         return;
     }
+    StoreDevicePose(static_cast<uint32_t>(device_index), pose, is_active);
+}
 
+void SimulatorCore::StoreDevicePose(uint32_t device_index, const OxPose& pose, bool is_active) {
     state_.devices[device_index].pose = pose;
-    bool device_always_active = device_def ? device_def->always_active : false;
+    bool device_always_active = profile_->devices[device_index].always_active;
     state_.devices[device_index].is_active = device_always_active ? 1 : (is_active ? 1 : 0);
 }
 
+void SimulatorCore::PostPose(const char* user_path, const OxPose& pose, bool is_active) {
+    const DeviceProfile* profile = mailbox_profile_.load(std::memory_order_acquire);
+    if (!profile) return;
+
+    const size_t device_count = std::min(static_cast<size_t>(OX_MAX_DEVICES), profile->devices.size());
+    for (size_t i = 0; i < device_count; i++) {
+        if (std::strcmp(profile->devices[i].user_path, user_path) == 0) {
+            if (!pose_mailboxes_[i].Post(pose, is_active, profile)) g_pose_coalesced.Add();
+            pose_posts_.fetch_add(1, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+void SimulatorCore::DrainPoseMailboxes() {
+    const uint64_t posts = pose_posts_.load(std::memory_order_acquire);
+    if (posts == pose_posts_drained_) return;
+    pose_posts_drained_ = posts;
+
+    for (uint32_t i = 0; i < state_.device_count; i++) {
+        OxPose pose;
+        bool is_active;
+        const void* tag;
+        uint64_t coalesced;
+        if (!pose_mailboxes_[i].Take(&pose, &is_active, &tag, &coalesced)) continue;
+        if (coalesced > 0) g_pose_coalesced.Add(coalesced);
+        if (tag == profile_) StoreDevicePose(i, pose, is_active);  // else posted for the previous profile
+    }
+}
+
 template <ComponentType CT, typename T>
-OxComponentResult SimulatorCore::GetInputState(const char* user_path, const char* component_path, T* out_value) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
+OxComponentResult SimulatorCore::GetInputState(const char* user_path, const char* component_path,
+                                               int64_t predicted_time, T* out_value) {
+    ProfiledLock lock(state_mutex_);
 
     auto [input, comp_index, comp_type] = ValidateDeviceAndComponent(user_path, component_path);
     if (!input || comp_index == -1) {
         return OX_COMPONENT_UNAVAILABLE;
     }
 
+    InputValue value = input->values[comp_index];
+    if (predicted_time != kStoredValue) {
+        const uint32_t device_index = static_cast<uint32_t>(input - state_.device_inputs);
+        value = SampleLatched(device_index, comp_index, predicted_time);
+        if (!generators_.empty()) {
+            ApplyGenerators(device_index, comp_index, predicted_time, &value);
+        }
+    }
+
     if (comp_type == CT) {
-        *out_value = std::get<T>(input->values[comp_index]);
+        *out_value = std::get<T>(value);
         return OX_COMPONENT_AVAILABLE;
     } else if (CT == ComponentType::FLOAT && comp_type == ComponentType::BOOLEAN) {
         if constexpr (CT == ComponentType::FLOAT) {
-            bool val = std::get<bool>(input->values[comp_index]);
+            bool val = std::get<bool>(value);
             *out_value = val ? 1.0f : 0.0f;
         }
         return OX_COMPONENT_AVAILABLE;
     } else if (CT == ComponentType::BOOLEAN && comp_type == ComponentType::FLOAT) {
         if constexpr (CT == ComponentType::BOOLEAN) {
-            float val = std::get<float>(input->values[comp_index]);
+            float val = std::get<float>(value);
             *out_value = (val >= 0.5f) ? true : false;
         }
         return OX_COMPONENT_AVAILABLE;
@@ -193,14 +330,13 @@ OxComponentResult SimulatorCore::GetInputState(const char* user_path, const char
 }
 
 template <ComponentType CT, typename T>
-void SimulatorCore::SetInputState(const char* user_path, const char* component_path, const T& value) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
-
+void SimulatorCore::StoreInput(const char* user_path, const char* component_path, const T& value) {
     auto [input, comp_index, comp_type] = ValidateDeviceAndComponent(user_path, component_path);
     if (!input || comp_index == -1) {
         return;
     }
 
+    const InputValue old_value = input->values[comp_index];
     if (comp_type == CT) {
         input->values[comp_index] = value;
     } else if (CT == ComponentType::FLOAT && comp_type == ComponentType::BOOLEAN) {
@@ -214,35 +350,70 @@ void SimulatorCore::SetInputState(const char* user_path, const char* component_p
     } else {
         return;
     }
+    LatchWrite(static_cast<uint32_t>(input - state_.device_inputs), comp_index, old_value);
+
+    if constexpr (CT == ComponentType::FLOAT) {
+        SyncLinkedVec2FromFloat(user_path, component_path);
+    } else if constexpr (CT == ComponentType::VEC2) {
+        SyncLinkedFloatsFromVec2(user_path, component_path);
+    }
 }
 
 OxComponentResult SimulatorCore::GetInputStateBoolean(const char* user_path, const char* component_path,
                                                       bool* out_value) {
-    return GetInputState<ComponentType::BOOLEAN, bool>(user_path, component_path, out_value);
+    return GetInputState<ComponentType::BOOLEAN, bool>(user_path, component_path, kStoredValue, out_value);
 }
 
 OxComponentResult SimulatorCore::GetInputStateFloat(const char* user_path, const char* component_path,
                                                     float* out_value) {
-    return GetInputState<ComponentType::FLOAT, float>(user_path, component_path, out_value);
+    return GetInputState<ComponentType::FLOAT, float>(user_path, component_path, kStoredValue, out_value);
 }
 
 OxComponentResult SimulatorCore::GetInputStateVec2(const char* user_path, const char* component_path,
                                                    OxVector2f* out_value) {
-    return GetInputState<ComponentType::VEC2, OxVector2f>(user_path, component_path, out_value);
+    return GetInputState<ComponentType::VEC2, OxVector2f>(user_path, component_path, kStoredValue, out_value);
+}
+
+OxComponentResult SimulatorCore::GetInputStateBoolean(const char* user_path, const char* component_path,
+                                                      int64_t predicted_time, bool* out_value) {
+    return GetInputState<ComponentType::BOOLEAN, bool>(user_path, component_path, predicted_time, out_value);
+}
+
+OxComponentResult SimulatorCore::GetInputStateFloat(const char* user_path, const char* component_path,
+                                                    int64_t predicted_time, float* out_value) {
+    return GetInputState<ComponentType::FLOAT, float>(user_path, component_path, predicted_time, out_value);
+}
+
+OxComponentResult SimulatorCore::GetInputStateVec2(const char* user_path, const char* component_path,
+                                                   int64_t predicted_time, OxVector2f* out_value) {
+    return GetInputState<ComponentType::VEC2, OxVector2f>(user_path, component_path, predicted_time, out_value);
 }
 
 void SimulatorCore::SetInputStateBoolean(const char* user_path, const char* component_path, bool value) {
-    SetInputState<ComponentType::BOOLEAN, bool>(user_path, component_path, value);
+    if (Stage(StagedWrite::Kind::kBoolean, user_path, component_path, nullptr, false, value)) return;
+    {
+        ProfiledLock lock(state_mutex_);
+        StoreInput<ComponentType::BOOLEAN, bool>(user_path, component_path, value);
+    }
+    NotifyChanged();
 }
 
 void SimulatorCore::SetInputStateFloat(const char* user_path, const char* component_path, float value) {
-    SetInputState<ComponentType::FLOAT, float>(user_path, component_path, value);
-    SyncLinkedVec2FromFloat(user_path, component_path);
+    if (Stage(StagedWrite::Kind::kFloat, user_path, component_path, nullptr, false, value)) return;
+    {
+        ProfiledLock lock(state_mutex_);
+        StoreInput<ComponentType::FLOAT, float>(user_path, component_path, value);
+    }
+    NotifyChanged();
 }
 
 void SimulatorCore::SetInputStateVec2(const char* user_path, const char* component_path, const OxVector2f& value) {
-    SetInputState<ComponentType::VEC2, OxVector2f>(user_path, component_path, value);
-    SyncLinkedFloatsFromVec2(user_path, component_path);
+    if (Stage(StagedWrite::Kind::kVec2, user_path, component_path, nullptr, false, value)) return;
+    {
+        ProfiledLock lock(state_mutex_);
+        StoreInput<ComponentType::VEC2, OxVector2f>(user_path, component_path, value);
+    }
+    NotifyChanged();
 }
 
 // ---------------------------------------------------------------------------
@@ -252,8 +423,6 @@ void SimulatorCore::SetInputStateVec2(const char* user_path, const char* compone
 // After a FLOAT axis component is set, propagate the new value into its parent
 // VEC2 component (if one is declared via linked_vec2_path / linked_axis).
 void SimulatorCore::SyncLinkedVec2FromFloat(const char* user_path, const char* component_path) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
-
     const DeviceDef* dev_def = FindDeviceDefByUserPath(user_path);
     if (!dev_def) return;
 
@@ -282,17 +451,17 @@ void SimulatorCore::SyncLinkedVec2FromFloat(const char* user_path, const char* c
     auto [vec2_idx, vec2_type] = FindComponentInfo(dev_def, src_def->linked_vec2_path);
     if (vec2_idx == -1 || vec2_type != ComponentType::VEC2) return;
     OxVector2f& vec2_val = std::get<OxVector2f>(inputs.values[vec2_idx]);
+    const InputValue old_value = vec2_val;
     if (src_def->linked_axis == Vec2Axis::X)
         vec2_val.x = axis_val;
     else
         vec2_val.y = axis_val;
+    LatchWrite(static_cast<uint32_t>(device_index), vec2_idx, old_value);
 }
 
 // After a VEC2 component is set, propagate x / y into the FLOAT axis components
 // that declare themselves as linked to this VEC2.
 void SimulatorCore::SyncLinkedFloatsFromVec2(const char* user_path, const char* component_path) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
-
     const DeviceDef* dev_def = FindDeviceDefByUserPath(user_path);
     if (!dev_def) return;
 
@@ -311,9 +480,275 @@ void SimulatorCore::SyncLinkedFloatsFromVec2(const char* user_path, const char*
         if (c.type == ComponentType::FLOAT && c.linked_vec2_path != nullptr &&
             std::strcmp(c.linked_vec2_path, component_path) == 0 && c.linked_axis != Vec2Axis::NONE) {
             float new_val = (c.linked_axis == Vec2Axis::X) ? vec2_val.x : vec2_val.y;
+            const InputValue old_value = inputs.values[idx];
             inputs.values[idx] = new_val;
+            LatchWrite(static_cast<uint32_t>(device_index), idx, old_value);
         }
         idx++;
     }
 }
-}  // namespace ox_sim
\ No newline at end of file
+
+// ---------------------------------------------------------------------------
+// Input generators
+// ---------------------------------------------------------------------------
+
+bool SimulatorCore::SetInputGenerator(const char* user_path, const char* component_path,
+                                      const InputGenerator& generator) {
+    ProfiledLock lock(state_mutex_);
+
+    auto [input, comp_index, comp_type] = ValidateDeviceAndComponent(user_path, component_path);
+    if (!input || comp_index == -1) return false;
+    const bool vec2_shape = InputGenerator::IsVec2Shape(generator.shape);
+    if ((comp_type == ComponentType::VEC2) != vec2_shape && generator.shape != InputGenerator::Shape::kRandomWalk) {
+        return false;
+    }
+
+    const uint32_t device_index = static_cast<uint32_t>(input - state_.device_inputs);
+    const DeviceDef& dev_def = profile_->devices[device_index];
+    const ComponentDef& comp = dev_def.components[comp_index];
+
+    // One generator per linked VEC2/FLOAT group, so the two sides can't disagree.
+    auto linked = [&](const AttachedGenerator& attached) {
+        if (attached.device_index != device_index) return false;
+        if (attached.component_index == comp_index) return true;
+        const ComponentDef& other = dev_def.components[attached.component_index];
+        if (comp.type == ComponentType::VEC2) {
+            return other.linked_vec2_path && std::strcmp(other.linked_vec2_path, comp.path) == 0;
+        }
+        return comp.linked_vec2_path && std::strcmp(comp.linked_vec2_path, other.path) == 0;
+    };
+    generators_.erase(std::remove_if(generators_.begin(), generators_.end(), linked), generators_.end());
+
+    generators_.push_back({device_index, comp_index, generator});
+    return true;
+}
+
+bool SimulatorCore::ClearInputGenerator(const char* user_path, const char* component_path) {
+    ProfiledLock lock(state_mutex_);
+
+    auto [input, comp_index, comp_type] = ValidateDeviceAndComponent(user_path, component_path);
+    if (!input || comp_index == -1) return false;
+    const uint32_t device_index = static_cast<uint32_t>(input - state_.device_inputs);
+
+    const size_t count = generators_.size();
+    generators_.erase(std::remove_if(generators_.begin(), generators_.end(),
+                                     [&](const AttachedGenerator& attached) {
+                                         return attached.device_index == device_index &&
+                                                attached.component_index == comp_index;
+                                     }),
+                      generators_.end());
+    return generators_.size() != count;
+}
+
+void SimulatorCore::ClearInputGenerators() {
+    ProfiledLock lock(state_mutex_);
+    generators_.clear();
+}
+
+std::vector<std::pair<std::string, InputGenerator>> SimulatorCore::GetInputGenerators() const {
+    ProfiledLock lock(state_mutex_);
+    std::vector<std::pair<std::string, InputGenerator>> result;
+    result.reserve(generators_.size());
+    for (const AttachedGenerator& attached : generators_) {
+        const DeviceDef& dev_def = profile_->devices[attached.device_index];
+        result.emplace_back(std::string(dev_def.user_path) + dev_def.components[attached.component_index].path,
+                            attached.generator);
+    }
+    return result;
+}
+
+InputGenerator* SimulatorCore::FindGenerator(uint32_t device_index, int32_t component_index) {
+    for (AttachedGenerator& attached : generators_) {
+        if (attached.device_index == device_index && attached.component_index == component_index) {
+            return &attached.generator;
+        }
+    }
+    return nullptr;
+}
+
+void SimulatorCore::ApplyGenerators(uint32_t device_index, int32_t component_index, int64_t predicted_time,
+                                    InputValue* value) {
+    const DeviceDef& dev_def = profile_->devices[device_index];
+    const ComponentDef& comp = dev_def.components[component_index];
+
+    if (InputGenerator* generator = FindGenerator(device_index, component_index)) {
+        switch (comp.type) {
+            case ComponentType::BOOLEAN:
+                *value = generator->EvaluateScalar(predicted_time) >= 0.5f;
+                break;
+            case ComponentType::FLOAT:
+                *value = generator->EvaluateScalar(predicted_time);
+                break;
+            case ComponentType::VEC2:
+                *value = generator->EvaluateVec2(predicted_time);
+                break;
+        }
+        return;
+    }
+
+    // Linked pairs: a FLOAT axis follows its VEC2's generator, and a VEC2 takes each axis from the
+    // generator of the FLOAT linked to it. Evaluation is a pure function of time (random walks
+    // advance by time too), so both sides see the same value for the same predicted_time.
+    if (comp.type == ComponentType::FLOAT && comp.linked_vec2_path && comp.linked_axis != Vec2Axis::NONE) {
+        const int32_t vec2_index = FindComponentInfo(&dev_def, comp.linked_vec2_path).first;
+        if (InputGenerator* generator = FindGenerator(device_index, vec2_index)) {
+            const OxVector2f vec2_val = generator->EvaluateVec2(predicted_time);
+            *value = comp.linked_axis == Vec2Axis::X ? vec2_val.x : vec2_val.y;
+        }
+    } else if (comp.type == ComponentType::VEC2) {
+        OxVector2f& vec2_val = std::get<OxVector2f>(*value);
+        int32_t idx = 0;
+        for (const auto& c : dev_def.components) {
+            if (c.type == ComponentType::FLOAT && c.linked_vec2_path != nullptr &&
+                std::strcmp(c.linked_vec2_path, comp.path) == 0 && c.linked_axis != Vec2Axis::NONE) {
+                if (InputGenerator* generator = FindGenerator(device_index, idx)) {
+                    const float axis_val = generator->EvaluateScalar(predicted_time);
+                    (c.linked_axis == Vec2Axis::X ? vec2_val.x : vec2_val.y) = axis_val;
+                }
+            }
+            idx++;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Input latching
+// ---------------------------------------------------------------------------
+
+void SimulatorCore::SetInputLatchPolicy(ComponentType type, InputLatchPolicy policy) {
+    ProfiledLock lock(state_mutex_);
+    latch_policies_[static_cast<int>(type)] = policy;
+    for (auto& latches : input_latches_) {
+        for (InputLatch& latch : latches) latch.count = 0;
+    }
+}
+
+void SimulatorCore::LatchWrite(uint32_t device_index, int32_t component_index, const InputValue& old_value) {
+    const InputValue& new_value = state_.device_inputs[device_index].values[component_index];
+    if (SameValue(new_value, old_value)) return;
+
+    InputLatch& latch = input_latches_[device_index][component_index];
+    const int type = static_cast<int>(profile_->devices[device_index].components[component_index].type);
+    if (latch_policies_[type] == InputLatchPolicy::kLevel || latch.last_sample_time == INT64_MIN) {
+        if (latch.unsampled) g_input_coalesced[type].Add();
+        latch.unsampled = true;
+        return;
+    }
+
+    // kLatch: queue the value unless it's what the runtime will see last anyway.
+    const InputValue& last =
+        latch.count ? latch.pending[(latch.head + latch.count - 1) % InputLatch::kCapacity] : old_value;
+    if (SameValue(new_value, last)) {
+        // e.g. press + release + press before a frame: the queue already ends in "pressed"
+        return;
+    }
+    if (latch.count == InputLatch::kCapacity) {
+        latch.head = (latch.head + 1) % InputLatch::kCapacity;
+        latch.count--;
+        g_input_dropped[type].Add();
+    }
+    latch.pending[(latch.head + latch.count) % InputLatch::kCapacity] = new_value;
+    latch.count++;
+}
+
+InputValue SimulatorCore::SampleLatched(uint32_t device_index, int32_t component_index, int64_t predicted_time) {
+    const InputValue& stored = state_.device_inputs[device_index].values[component_index];
+    InputLatch& latch = input_latches_[device_index][component_index];
+    if (predicted_time > latch.last_sample_time) {
+        latch.last_sample_time = predicted_time;
+        latch.unsampled = false;
+        if (latch.count) {
+            latch.presented = latch.pending[latch.head];
+            latch.head = (latch.head + 1) % InputLatch::kCapacity;
+            latch.count--;
+        } else {
+            latch.presented = stored;
+        }
+    }
+    const int type = static_cast<int>(profile_->devices[device_index].components[component_index].type);
+    return latch_policies_[type] == InputLatchPolicy::kLatch ? latch.presented : stored;
+}
+
+// ---------------------------------------------------------------------------
+// Commit mode
+// ---------------------------------------------------------------------------
+
+void SimulatorCore::SetCommitMode(bool enabled) {
+    commit_mode_.store(enabled, std::memory_order_relaxed);
+    if (!enabled) CommitStaged();
+}
+
+size_t SimulatorCore::GetStagedCount() const {
+    ProfiledLock staging_lock(staging_mutex_);
+    return staged_.size();
+}
+
+bool SimulatorCore::Stage(StagedWrite::Kind kind, const char* user_path, const char* component_path,
+                          const OxPose* pose, bool is_active, const InputValue& value) {
+    if (!commit_mode_.load(std::memory_order_relaxed)) return false;
+
+    const size_t user_length = std::strlen(user_path);
+    const size_t component_length = std::strlen(component_path);
+    if (user_length >= sizeof(StagedWrite::user_path) || component_length >= sizeof(StagedWrite::component_path)) {
+        return true;  // can't name a component of any profile
+    }
+
+    ProfiledLock staging_lock(staging_mutex_);
+    if (staged_.size() >= kMaxStagedWrites) {
+        g_staged_dropped.Add();
+        return true;
+    }
+    StagedWrite& write = staged_.emplace_back();
+    write.kind = kind;
+    write.is_active = is_active;
+    if (pose) write.pose = *pose;
+    write.value = value;
+    std::memcpy(write.user_path, user_path, user_length + 1);
+    std::memcpy(write.component_path, component_path, component_length + 1);
+    staged_pending_.store(true, std::memory_order_release);
+    return true;
+}
+
+size_t SimulatorCore::CommitStaged() {
+    size_t count = 0;
+    {
+        ProfiledLock lock(state_mutex_);
+        DrainPoseMailboxes();  // earlier than anything staged
+        {
+            ProfiledLock staging_lock(staging_mutex_);
+            committing_.swap(staged_);
+            staged_pending_.store(false, std::memory_order_release);
+        }
+
+        for (const StagedWrite& write : committing_) {
+            switch (write.kind) {
+                case StagedWrite::Kind::kPose:
+                    StorePose(write.user_path, write.pose, write.is_active);
+                    break;
+                case StagedWrite::Kind::kBoolean:
+                    StoreInput<ComponentType::BOOLEAN, bool>(write.user_path, write.component_path,
+                                                             std::get<bool>(write.value));
+                    break;
+                case StagedWrite::Kind::kFloat:
+                    StoreInput<ComponentType::FLOAT, float>(write.user_path, write.component_path,
+                                                            std::get<float>(write.value));
+                    break;
+                case StagedWrite::Kind::kVec2:
+                    StoreInput<ComponentType::VEC2, OxVector2f>(write.user_path, write.component_path,
+                                                                std::get<OxVector2f>(write.value));
+                    break;
+            }
+        }
+        count = committing_.size();
+        committing_.clear();
+    }
+
+    if (count > 0) {
+        g_state_commits.Add();
+        g_staged_writes.Add(count);
+        NotifyChanged();
+    }
+    return count;
+}
+
+}  // namespace ox_sim
@@ -3,13 +3,18 @@
 #include <ox_driver.h>
 
 #include <atomic>
+#include <cstdint>
 #include <map>
 #include <mutex>
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "device_profiles.h"
+#include "input_generator.h"
+#include "pose_mailbox.h"
+#include "profiled_mutex.h"
 
 namespace ox_sim {
 
@@ -21,6 +26,42 @@ struct DeviceInputState {
     std::vector<InputValue> values;  // Indexed by component index
 };
 
+// How input writes that land between two frame samples reach the runtime.
+enum class InputLatchPolicy {
+    kLevel,  // the runtime sees the latest value; changes it never sampled are counted as coalesced
+    kLatch,  // every change is held for at least one frame, in order (a tap shorter than a frame still
+             // shows as one frame pressed, one released); overflowing changes are counted as dropped
+};
+
+// "level" or "latch"
+bool ParseInputLatchPolicy(const std::string& name, InputLatchPolicy* out);
+
+// Per-component latch queue behind InputLatchPolicy. Values are dequeued once per frame, on the
+// first sample with a new predicted_time.
+struct InputLatch {
+    static constexpr uint8_t kCapacity = 8;
+
+    InputValue pending[kCapacity];
+    uint8_t head = 0;
+    uint8_t count = 0;
+    int64_t last_sample_time = INT64_MIN;  // INT64_MIN: never sampled, so writes aren't queued
+    InputValue presented;                  // the value of the current frame
+    bool unsampled = false;                // changed since the last frame sample
+};
+
+// A pose or input write held back by commit mode until the next frame boundary. Paths are copied
+// so the caller's strings needn't outlive the call; they're resolved when the write is published.
+struct StagedWrite {
+    enum class Kind : uint8_t { kPose, kBoolean, kFloat, kVec2 };
+
+    Kind kind;
+    bool is_active;  // kPose
+    OxPose pose;     // kPose
+    InputValue value;
+    char user_path[128];
+    char component_path[128];  // empty for kPose
+};
+
 // Shared device state (written by API/GUI, read by driver)
 struct DeviceState {
     // Tracked devices: device[0] = HMD (/user/head), device[1+] = controllers, trackers, etc.
@@ -48,6 +89,11 @@ class SimulatorCore {
 
     // Device state access
     void UpdateAllDevices(OxDeviceState* out_states, uint32_t* out_count);
+
+    // Copy all device and input state under a single lock acquisition and return the profile it
+    // belongs to. The vectors in `out` are reused, so repeated calls with the same `out` don't
+    // allocate. devices[i] and device_inputs[i] correspond to profile->devices[i].
+    const DeviceProfile* GetSnapshot(DeviceState* out);
     bool GetDevicePose(const char* user_path, OxPose* out_pose, bool* out_is_active);
 
     // Input state access
@@ -55,7 +101,20 @@ class SimulatorCore {
     OxComponentResult GetInputStateFloat(const char* user_path, const char* component_path, float* out_value);
     OxComponentResult GetInputStateVec2(const char* user_path, const char* component_path, OxVector2f* out_value);
 
-    // Update device state
+    // Input state as the runtime samples it for `predicted_time` (the driver's input callbacks): as
+    // above, but a generator on the component or on its linked VEC2/FLOAT counterpart is evaluated
+    // at that time instead of returning the stored value.
+    OxComponentResult GetInputStateBoolean(const char* user_path, const char* component_path, int64_t predicted_time,
+                                           bool* out_value);
+    OxComponentResult GetInputStateFloat(const char* user_path, const char* component_path, int64_t predicted_time,
+                                         float* out_value);
+    OxComponentResult GetInputStateVec2(const char* user_path, const char* component_path, int64_t predicted_time,
+                                        OxVector2f* out_value);
+
+    // Update device state. Outside commit mode the pose is posted to the device's PoseMailbox
+    // without taking any lock; the next read (UpdateAllDevices(), GetDevicePose(), GetSnapshot())
+    // publishes the newest post per device, so a burst of writes between two frames costs the
+    // runtime one copy.
     void SetDevicePose(const char* user_path, const OxPose& pose, bool is_active);
 
     // Update input state
@@ -63,17 +122,74 @@ class SimulatorCore {
     void SetInputStateFloat(const char* user_path, const char* component_path, float value);
     void SetInputStateVec2(const char* user_path, const char* component_path, const OxVector2f& value);
 
+    // Frame-boundary commit mode. While enabled, SetDevicePose() and SetInputState*() only stage the
+    // write, under a lock of its own; the staged writes are published together by CommitStaged().
+    // The driver calls OnFrameBoundary() with each predicted_time, so every frame sees either all of
+    // a batch of writes or none of it. Reads return the published state. Disabling commit mode
+    // publishes whatever is staged; a profile switch drops it.
+    void SetCommitMode(bool enabled);
+    bool GetCommitMode() const { return commit_mode_.load(std::memory_order_relaxed); }
+    size_t GetStagedCount() const;
+
+    // Publish the staged writes now, in the order they were made. Returns how many were published.
+    size_t CommitStaged();
+
+    // Driver hook: the first call with a new (later) predicted_time publishes the staged writes. The
+    // rest of the frame's calls return after one atomic load.
+    void OnFrameBoundary(int64_t predicted_time) {
+        if (predicted_time <= frame_time_.load(std::memory_order_relaxed)) return;
+        frame_time_.store(predicted_time, std::memory_order_relaxed);
+        if (staged_pending_.load(std::memory_order_acquire)) CommitStaged();
+    }
+
+    // Latch policy per component type (defaults: BOOLEAN latch, FLOAT and VEC2 level). Keep FLOAT and
+    // VEC2 on the same policy so linked thumbstick axes stay consistent.
+    void SetInputLatchPolicy(ComponentType type, InputLatchPolicy policy);
+
+    // Input generators. A generator only affects what the runtime samples; the stored value (GET
+    // /v1/inputs, the GUI) is left alone. Attaching one to a VEC2 replaces any on its linked FLOAT
+    // axes and vice versa, so a thumbstick and its axes always agree. A profile switch drops them.
+    // SetInputGenerator() returns false if the component doesn't exist or the shape doesn't fit its
+    // type (circle and figure_eight are VEC2 only; ramp, sine and square are FLOAT/BOOLEAN only).
+    bool SetInputGenerator(const char* user_path, const char* component_path, const InputGenerator& generator);
+    bool ClearInputGenerator(const char* user_path, const char* component_path);
+    void ClearInputGenerators();
+    std::vector<std::pair<std::string, InputGenerator>> GetInputGenerators() const;  // binding path, generator
+
+    // Called after every pose, input or profile change, on the thread that made it and with no lock
+    // held. The GUI uses it to redraw only when something changed. The context must outlive the core
+    // or be unregistered (listener nullptr) first.
+    using ChangeListener = void (*)(void* context);
+    void SetChangeListener(ChangeListener listener, void* context);
+
     // Helper functions
     const DeviceDef* FindDeviceDefByUserPath(const char* user_path) const;
     std::pair<int32_t, ComponentType> FindComponentInfo(const DeviceDef* device_def, const char* component_path) const;
 
    private:
     // Template implementations for input state access
+    // predicted_time == kStoredValue reads the stored value without evaluating generators.
+    static constexpr int64_t kStoredValue = INT64_MIN;
     template <ComponentType CT, typename T>
-    OxComponentResult GetInputState(const char* user_path, const char* component_path, T* out_value);
-
+    OxComponentResult GetInputState(const char* user_path, const char* component_path, int64_t predicted_time,
+                                    T* out_value);
+
+    // Both require state_mutex_. StoreInput() also updates the component's linked VEC2/FLOAT
+    // counterpart.
+    void StorePose(const char* user_path, const OxPose& pose, bool is_active);
+    void StoreDevicePose(uint32_t device_index, const OxPose& pose, bool is_active);
+
+    // Pose mailboxes. DrainPoseMailboxes() requires state_mutex_ and moves the newest post of each
+    // device into state_; it's a single atomic load when nothing was posted.
+    void PostPose(const char* user_path, const OxPose& pose, bool is_active);
+    void DrainPoseMailboxes();
     template <ComponentType CT, typename T>
-    void SetInputState(const char* user_path, const char* component_path, const T& value);
+    void StoreInput(const char* user_path, const char* component_path, const T& value);
+
+    // Commit mode: queue a write for CommitStaged(). Returns false if commit mode is off; the caller
+    // then stores the write directly. Writes whose paths don't fit a StagedWrite are dropped.
+    bool Stage(StagedWrite::Kind kind, const char* user_path, const char* component_path, const OxPose* pose,
+               bool is_active, const InputValue& value);
 
     // Helper functions
     int FindDeviceIndexByUserPath(const char* user_path) const;
@@ -81,14 +197,51 @@ class SimulatorCore {
                                                                                      const char* component_path);
 
     // Sync helpers — called after setting a value to keep linked VEC2/FLOAT pairs consistent.
-    // Both are called WITHOUT holding state_mutex_ (they re-acquire it internally).
+    // Both require state_mutex_.
     void SyncLinkedVec2FromFloat(const char* user_path, const char* component_path);
     void SyncLinkedFloatsFromVec2(const char* user_path, const char* component_path);
 
+    void NotifyChanged();
+
+    // Both require state_mutex_. LatchWrite() is called after a component's stored value changed
+    // from old_value; SampleLatched() returns what the frame at predicted_time sees.
+    void LatchWrite(uint32_t device_index, int32_t component_index, const InputValue& old_value);
+    InputValue SampleLatched(uint32_t device_index, int32_t component_index, int64_t predicted_time);
+
+    struct AttachedGenerator {
+        uint32_t device_index;
+        int32_t component_index;
+        InputGenerator generator;
+    };
+
+    // Both require state_mutex_.
+    InputGenerator* FindGenerator(uint32_t device_index, int32_t component_index);
+    void ApplyGenerators(uint32_t device_index, int32_t component_index, int64_t predicted_time, InputValue* value);
+
     // Member variables
     const DeviceProfile* profile_;
     DeviceState state_;
-    mutable std::mutex state_mutex_;
+    mutable ProfiledMutex state_mutex_;
+    std::vector<AttachedGenerator> generators_;  // guarded by state_mutex_
+    std::vector<InputLatch> input_latches_[OX_MAX_DEVICES];  // per component, guarded by state_mutex_
+    InputLatchPolicy latch_policies_[3] = {InputLatchPolicy::kLevel, InputLatchPolicy::kLatch,
+                                           InputLatchPolicy::kLevel};  // indexed by ComponentType
+    // Pose mailboxes, indexed like state_.devices. mailbox_profile_ is the profile writers resolve
+    // user paths against (nullptr outside Initialize()..Shutdown()); posts are tagged with it.
+    PoseMailbox pose_mailboxes_[OX_MAX_DEVICES];
+    std::atomic<const DeviceProfile*> mailbox_profile_{nullptr};
+    std::atomic<uint64_t> pose_posts_{0};
+    uint64_t pose_posts_drained_ = 0;  // guarded by state_mutex_
+
+    // Commit mode. Lock order: state_mutex_, then staging_mutex_; writers only take staging_mutex_.
+    std::atomic<bool> commit_mode_{false};
+    std::atomic<bool> staged_pending_{false};
+    std::atomic<int64_t> frame_time_{INT64_MIN};
+    mutable ProfiledMutex staging_mutex_;
+    std::vector<StagedWrite> staged_;      // guarded by staging_mutex_
+    std::vector<StagedWrite> committing_;  // guarded by state_mutex_; reused by CommitStaged()
+    std::atomic<ChangeListener> change_listener_{nullptr};
+    std::atomic<void*> change_listener_context_{nullptr};
 };
 
 }  // namespace ox_sim
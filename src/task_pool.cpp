@@ -0,0 +1,145 @@
+#include "task_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <utility>
+
+#include "log.h"
+#include "thread_placement.h"
+#include "trace.h"
+
+namespace ox_sim {
+
+static metrics::Counter g_tasks_submitted[kTaskPriorityCount] = {
+    {"ox_task_pool_tasks_submitted_total", "Tasks submitted to the task pool", "priority=\"control\""},
+    {"ox_task_pool_tasks_submitted_total", "Tasks submitted to the task pool", "priority=\"capture\""},
+};
+static metrics::Gauge g_queue_depth[kTaskPriorityCount] = {
+    {"ox_task_pool_queue_depth", "Tasks waiting in the task pool's queues", "priority=\"control\""},
+    {"ox_task_pool_queue_depth", "Tasks waiting in the task pool's queues", "priority=\"capture\""},
+};
+static metrics::Histogram g_wait_duration[kTaskPriorityCount] = {
+    {"ox_task_pool_wait_seconds", "Time tasks spent queued before a worker started them", "priority=\"control\""},
+    {"ox_task_pool_wait_seconds", "Time tasks spent queued before a worker started them", "priority=\"capture\""},
+};
+static metrics::Histogram g_run_duration[kTaskPriorityCount] = {
+    {"ox_task_pool_run_seconds", "Time workers spent running tasks", "priority=\"control\""},
+    {"ox_task_pool_run_seconds", "Time workers spent running tasks", "priority=\"capture\""},
+};
+static metrics::Counter g_tasks_stolen("ox_task_pool_steals_total",
+                                       "Tasks a worker took from another worker's queue");
+
+// Pool and queue index of the calling thread if it is a task pool worker.
+static thread_local const TaskPool* t_pool = nullptr;
+static thread_local uint32_t t_worker = 0;
+
+void TaskPool::Start(uint32_t workers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load(std::memory_order_relaxed)) return;
+    workers = std::max(workers, 1u);
+    stopping_ = false;
+    workers_.clear();
+    for (uint32_t i = 0; i < workers; i++) workers_.push_back(std::make_unique<Worker>());
+    running_.store(true, std::memory_order_release);
+    for (uint32_t i = 0; i < workers; i++) workers_[i]->thread = std::thread(&TaskPool::WorkerThread, this, i);
+    OX_LOG_INFO("Task pool started with %u workers", workers);
+}
+
+void TaskPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load(std::memory_order_relaxed)) return;
+        running_.store(false, std::memory_order_release);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) worker->thread.join();
+
+    size_t dropped = 0;
+    for (auto& worker : workers_) {
+        for (int priority = 0; priority < kTaskPriorityCount; priority++) {
+            dropped += worker->queues[priority].size();
+            g_queue_depth[priority].Sub(static_cast<int64_t>(worker->queues[priority].size()));
+        }
+    }
+    workers_.clear();
+    queued_.store(0, std::memory_order_relaxed);
+    if (dropped > 0) OX_LOG_WARN("Task pool stopped with %zu queued tasks, dropped them", dropped);
+}
+
+bool TaskPool::Submit(TaskPriority priority, Task task) {
+    if (!running_.load(std::memory_order_acquire)) return false;
+    const int p = static_cast<int>(priority);
+    const uint32_t index = t_pool == this ? t_worker
+                                          : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[p].push_back({std::move(task), metrics::Clock::now()});
+    }
+    g_tasks_submitted[p].Add();
+    g_queue_depth[p].Add();
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // Taking mutex_ orders the wakeup after a worker's check of queued_, so it cannot be missed.
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    cv_.notify_one();
+    return true;
+}
+
+bool TaskPool::TakeTask(uint32_t index, QueuedTask* task, int* priority) {
+    const uint32_t count = static_cast<uint32_t>(workers_.size());
+    for (int p = 0; p < kTaskPriorityCount; p++) {
+        for (uint32_t i = 0; i < count; i++) {
+            Worker& worker = *workers_[(index + i) % count];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            std::deque<QueuedTask>& queue = worker.queues[p];
+            if (queue.empty()) continue;
+            if (i == 0) {
+                *task = std::move(queue.front());
+                queue.pop_front();
+            } else {
+                *task = std::move(queue.back());
+                queue.pop_back();
+                g_tasks_stolen.Add();
+            }
+            *priority = p;
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::WorkerThread(uint32_t index) {
+    trace::SetThreadName("task worker");
+    ApplyThreadPlacement(ThreadClass::kWorker, ("-" + std::to_string(index)).c_str());
+    t_pool = this;
+    t_worker = index;
+
+    QueuedTask task;
+    int priority = 0;
+    while (running_.load(std::memory_order_acquire)) {
+        if (!TakeTask(index, &task, &priority)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+            if (stopping_) break;
+            continue;
+        }
+        const metrics::Clock::time_point start = metrics::Clock::now();
+        g_queue_depth[priority].Sub();
+        g_wait_duration[priority].Observe(start - task.queued);
+        try {
+            OX_TRACE_SCOPE("task_pool", "RunTask");
+            task.task();
+        } catch (const std::exception& e) {
+            OX_LOG_ERROR("Task pool: task failed: %s", e.what());
+        }
+        g_run_duration[priority].Observe(metrics::Clock::now() - start);
+        task.task = nullptr;  // release its captures before sleeping
+    }
+    t_pool = nullptr;
+}
+
+}  // namespace ox_sim
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+
+namespace ox_sim {
+
+// Control work (answering API requests) runs before capture work (measuring, recording and
+// dumping frames) whenever both are queued.
+enum class TaskPriority { kControl, kCapture };
+inline constexpr int kTaskPriorityCount = 2;
+
+// Worker threads shared by the simulator's background work, so modules do not each start threads
+// of their own. Every worker has a queue per priority; tasks submitted from outside the pool are
+// spread over the workers round-robin and a task submitted from a worker goes to that worker's
+// queue. An idle worker takes the oldest task of its own queue or steals the newest one of another
+// worker's, looking for control work in all queues before it runs capture work.
+//
+// Tasks only ever run on the pool's own threads: Submit() queues and returns, it never runs the
+// task itself, so the runtime's callback threads can hand work to the pool without doing it.
+class TaskPool {
+   public:
+    using Task = std::function<void()>;
+
+    TaskPool() = default;
+    ~TaskPool() { Stop(); }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Start `workers` threads (at least one). Does nothing if the pool is running.
+    void Start(uint32_t workers);
+
+    // Wait for the running tasks, drop the queued ones and join the workers. Modules that submit
+    // tasks are stopped first, so normally nothing is queued by then.
+    void Stop();
+
+    // Queue `task`. Returns false, dropping the task, if the pool is not running.
+    bool Submit(TaskPriority priority, Task task);
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    uint32_t WorkerCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+   private:
+    struct QueuedTask {
+        Task task;
+        metrics::Clock::time_point queued;
+    };
+
+    struct Worker {
+        std::mutex mutex;  // guards queues
+        std::deque<QueuedTask> queues[kTaskPriorityCount];
+        std::thread thread;
+    };
+
+    void WorkerThread(uint32_t index);
+    bool TakeTask(uint32_t index, QueuedTask* task, int* priority);
+
+    std::vector<std::unique_ptr<Worker>> workers_;  // fixed while running
+    std::atomic<bool> running_{false};
+    std::atomic<uint32_t> next_worker_{0};  // round-robin target of external submits
+    std::atomic<uint64_t> queued_{0};       // tasks in all queues
+
+    // Idle workers sleep on cv_ until queued_ is non-zero; mutex_ also guards stopping_.
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+// Get the driver's task pool - implemented in driver.cpp
+TaskPool* GetTaskPool();
+
+}  // namespace ox_sim
@@ -0,0 +1,247 @@
+#include "thread_placement.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#include "log.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace ox_sim {
+
+// Highest CPU number accepted in a CPU list; also the size of Linux's default cpu_set_t.
+static constexpr int kMaxCpus = 1024;
+
+// Linux truncates longer thread names (15 characters plus the terminator).
+static constexpr size_t kMaxNameLength = 15;
+
+static const char* const kClassNames[kThreadClassCount] = {"http", "gui", "workers"};
+static const char* const kDefaultThreadNames[kThreadClassCount] = {"ox-http", "ox-gui", "ox-worker"};
+
+static std::mutex g_mutex;  // guards g_placements
+static ThreadPlacement g_placements[kThreadClassCount];
+
+const char* ThreadClassName(ThreadClass thread_class) { return kClassNames[static_cast<int>(thread_class)]; }
+
+// Parse a decimal CPU number at *p, advancing p past it.
+static bool ParseCpuNumber(const char*& p, int* out) {
+    if (*p < '0' || *p > '9') return false;
+    int value = 0;
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+        if (value >= kMaxCpus) return false;
+    }
+    *out = value;
+    return true;
+}
+
+bool ParseCpuSet(const std::string& cpus, std::vector<int>* out, std::string* error) {
+    out->clear();
+    if (cpus.size() > 2 && cpus[0] == '0' && (cpus[1] == 'x' || cpus[1] == 'X')) {
+        // Hex mask, lowest CPU in the last digit as for taskset.
+        const size_t digits = cpus.size() - 2;
+        if (digits * 4 > static_cast<size_t>(kMaxCpus)) {
+            *error = "mask too long";
+            return false;
+        }
+        for (size_t i = 0; i < digits; i++) {
+            const char c = cpus[cpus.size() - 1 - i];
+            int nibble;
+            if (c >= '0' && c <= '9') {
+                nibble = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                nibble = c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                nibble = c - 'A' + 10;
+            } else {
+                *error = "invalid hex digit in mask";
+                return false;
+            }
+            for (int bit = 0; bit < 4; bit++) {
+                if (nibble & (1 << bit)) out->push_back(static_cast<int>(i * 4) + bit);
+            }
+        }
+    } else {
+        // Comma-separated CPUs and inclusive ranges, e.g. "0,2-3".
+        const char* p = cpus.c_str();
+        while (*p) {
+            int first;
+            if (!ParseCpuNumber(p, &first)) {
+                *error = "expected a CPU number below 1024";
+                return false;
+            }
+            int last = first;
+            if (*p == '-') {
+                p++;
+                if (!ParseCpuNumber(p, &last) || last < first) {
+                    *error = "invalid CPU range";
+                    return false;
+                }
+            }
+            for (int cpu = first; cpu <= last; cpu++) out->push_back(cpu);
+            if (*p == ',') {
+                p++;
+            } else if (*p) {
+                *error = "expected ',' or '-'";
+                return false;
+            }
+        }
+    }
+    if (out->empty()) {
+        *error = "no CPUs selected";
+        return false;
+    }
+    return true;
+}
+
+bool ValidateThreadPlacement(const ThreadPlacement& placement, std::string* error) {
+    std::vector<int> cpus;
+    if (!placement.cpus.empty() && !ParseCpuSet(placement.cpus, &cpus, error)) {
+        *error = "cpus \"" + placement.cpus + "\": " + *error;
+        return false;
+    }
+    const std::string& policy = placement.policy;
+    const bool realtime = policy == "fifo" || policy == "rr";
+    if (!policy.empty() && !realtime && policy != "other" && policy != "batch" && policy != "idle") {
+        *error = "policy must be other, batch, idle, fifo or rr";
+        return false;
+    }
+    if (realtime && (placement.priority < 1 || placement.priority > 99)) {
+        *error = "fifo and rr need a priority from 1 to 99";
+        return false;
+    }
+    if (placement.has_nice && (placement.nice < -20 || placement.nice > 19)) {
+        *error = "nice must be from -20 to 19";
+        return false;
+    }
+    if (placement.name.size() > kMaxNameLength) {
+        *error = "name is longer than 15 characters";
+        return false;
+    }
+    return true;
+}
+
+void SetThreadPlacement(ThreadClass thread_class, const ThreadPlacement& placement) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_placements[static_cast<int>(thread_class)] = placement;
+}
+
+#ifdef _WIN32
+static void ApplyPlatform(const ThreadPlacement& placement, const std::string& name, const std::vector<int>& cpus,
+                          const char* class_name) {
+    std::wstring wide_name(name.begin(), name.end());
+    SetThreadDescription(GetCurrentThread(), wide_name.c_str());
+
+    if (!cpus.empty()) {
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus) {
+            if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= DWORD_PTR{1} << cpu;
+        }
+        if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+            OX_LOG_WARN("Thread placement: cannot set %s CPU affinity to %s", class_name, placement.cpus.c_str());
+        }
+    }
+
+    // Windows has no per-thread policies or nice values; map them onto the closest thread priority.
+    int priority = THREAD_PRIORITY_NORMAL;
+    if (placement.policy == "fifo" || placement.policy == "rr") {
+        priority = THREAD_PRIORITY_TIME_CRITICAL;
+    } else if (placement.policy == "idle") {
+        priority = THREAD_PRIORITY_IDLE;
+    } else if (placement.has_nice) {
+        priority = placement.nice <= -10 ? THREAD_PRIORITY_HIGHEST
+                   : placement.nice < 0  ? THREAD_PRIORITY_ABOVE_NORMAL
+                   : placement.nice >= 10 ? THREAD_PRIORITY_LOWEST
+                   : placement.nice > 0   ? THREAD_PRIORITY_BELOW_NORMAL
+                                          : THREAD_PRIORITY_NORMAL;
+    } else if (placement.policy.empty()) {
+        return;
+    }
+    if (!SetThreadPriority(GetCurrentThread(), priority)) {
+        OX_LOG_WARN("Thread placement: cannot set %s thread priority", class_name);
+    }
+}
+#elif defined(__linux__)
+static void ApplyPlatform(const ThreadPlacement& placement, const std::string& name, const std::vector<int>& cpus,
+                          const char* class_name) {
+    pthread_setname_np(pthread_self(), name.c_str());
+
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) CPU_SET(cpu, &set);
+        const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (result != 0) {
+            OX_LOG_WARN("Thread placement: cannot set %s CPU affinity to %s: %s", class_name, placement.cpus.c_str(),
+                        std::strerror(result));
+        }
+    }
+
+    if (!placement.policy.empty()) {
+        int policy = SCHED_OTHER;
+        if (placement.policy == "batch") policy = SCHED_BATCH;
+        if (placement.policy == "idle") policy = SCHED_IDLE;
+        if (placement.policy == "fifo") policy = SCHED_FIFO;
+        if (placement.policy == "rr") policy = SCHED_RR;
+        sched_param param{};
+        param.sched_priority = policy == SCHED_FIFO || policy == SCHED_RR ? placement.priority : 0;
+        const int result = pthread_setschedparam(pthread_self(), policy, &param);
+        if (result != 0) {
+            OX_LOG_WARN("Thread placement: cannot set %s scheduling policy %s: %s", class_name,
+                        placement.policy.c_str(), std::strerror(result));
+        }
+    }
+
+    // Linux keeps a nice value per thread; PRIO_PROCESS with a thread id sets only that thread's.
+    if (placement.has_nice) {
+        const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, placement.nice) != 0) {
+            OX_LOG_WARN("Thread placement: cannot set %s nice value %d: %s", class_name, placement.nice,
+                        std::strerror(errno));
+        }
+    }
+}
+#else
+static void ApplyPlatform(const ThreadPlacement& placement, const std::string& name, const std::vector<int>& cpus,
+                          const char* class_name) {
+    pthread_setname_np(name.c_str());
+    if (!cpus.empty() || !placement.policy.empty() || placement.has_nice) {
+        OX_LOG_WARN("Thread placement: only thread names are supported on this platform (%s)", class_name);
+    }
+}
+#endif
+
+void ApplyThreadPlacement(ThreadClass thread_class, const char* suffix) {
+    ThreadPlacement placement;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        placement = g_placements[static_cast<int>(thread_class)];
+    }
+    const int index = static_cast<int>(thread_class);
+    std::string name = (placement.name.empty() ? kDefaultThreadNames[index] : placement.name) + suffix;
+    if (name.size() > kMaxNameLength) name.resize(kMaxNameLength);
+
+    // Config loading already rejected malformed lists; an empty list here means "leave it alone".
+    std::vector<int> cpus;
+    std::string error;
+    if (!placement.cpus.empty()) ParseCpuSet(placement.cpus, &cpus, &error);
+
+    ApplyPlatform(placement, name, cpus, kClassNames[index]);
+}
+
+}  // namespace ox_sim
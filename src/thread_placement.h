@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ox_sim {
+
+// Groups of simulator threads that share one placement: the HTTP server (Crow's acceptor and
+// handler threads), the GUI thread, and the background workers (task pool and pixel probes).
+enum class ThreadClass { kHttp, kGui, kWorker };
+inline constexpr int kThreadClassCount = 3;
+
+// Where and how the threads of one class run. Empty/unset fields leave the inherited setting alone.
+struct ThreadPlacement {
+    std::string name;    // OS thread name prefix, empty = "ox-http", "ox-gui" or "ox-worker"
+    std::string cpus;    // allowed CPUs as a list ("2-3,6") or a hex mask ("0xc")
+    std::string policy;  // other, batch, idle, fifo or rr
+    int priority = 0;    // fifo/rr priority, 1-99
+    bool has_nice = false;
+    int nice = 0;  // -20 (favoured) to 19
+};
+
+// Config key of each class ("http", "gui", "workers"), indexed by ThreadClass.
+const char* ThreadClassName(ThreadClass thread_class);
+
+// Parse a CPU list or hex mask into CPU numbers. Returns false with *error set if it is malformed.
+bool ParseCpuSet(const std::string& cpus, std::vector<int>* out, std::string* error);
+
+// Check a placement read from config.json. Returns false with *error set if a field is invalid.
+bool ValidateThreadPlacement(const ThreadPlacement& placement, std::string* error);
+
+// Set the placement applied by later ApplyThreadPlacement() calls for `thread_class`.
+void SetThreadPlacement(ThreadClass thread_class, const ThreadPlacement& placement);
+
+// Name the calling thread and apply its class's CPU affinity, scheduling policy and nice value.
+// Each simulator thread calls this once when it starts; `suffix` tells apart threads of one
+// class (e.g. "-0"). Settings the platform does not support, or the process may not use (fifo
+// and rr usually need CAP_SYS_NICE), are logged and skipped. Linux supports everything; Windows
+// maps policy and nice to a thread priority; macOS only sets the name.
+void ApplyThreadPlacement(ThreadClass thread_class, const char* suffix = "");
+
+}  // namespace ox_sim
@@ -0,0 +1,170 @@
+#include "trace.h"
+
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace ox_sim {
+namespace trace {
+
+namespace detail {
+std::atomic<bool> g_enabled{false};
+}  // namespace detail
+
+namespace {
+
+// Slices per thread; a 90 Hz runtime issuing ~20 callbacks per frame fills this in ~9 seconds.
+constexpr uint32_t kRingCapacity = 16384;  // must be a power of two
+
+struct Event {
+    const char* category;
+    const char* name;
+    int64_t begin_ns;
+    int64_t end_ns;
+};
+
+// Single-producer/single-consumer ring: the owning thread appends, Stop() drains.
+// When the ring is full new events are dropped (and counted) rather than blocking the producer.
+struct ThreadRing {
+    Event events[kRingCapacity];
+    std::atomic<uint64_t> head{0};  // next write position (producer)
+    std::atomic<uint64_t> tail{0};  // next read position (consumer)
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<const char*> thread_name{nullptr};
+    std::atomic<bool> thread_alive{true};
+    uint32_t tid = 0;
+
+    void Push(const Event& e) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= kRingCapacity) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        events[h & (kRingCapacity - 1)] = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    uint32_t next_tid = 1;
+};
+
+Registry& GetRegistry() {
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+// Name given to SetThreadName(), applied when (and if) the thread's ring is created.
+thread_local const char* t_thread_name = nullptr;
+
+// Keeps the calling thread's ring registered; marks it dead on thread exit so the next Stop()
+// can release it after draining.
+struct ThreadRingHandle {
+    std::shared_ptr<ThreadRing> ring;
+
+    ThreadRing& Get() {
+        if (!ring) {
+            ring = std::make_shared<ThreadRing>();
+            ring->thread_name.store(t_thread_name, std::memory_order_relaxed);
+            Registry& reg = GetRegistry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            ring->tid = reg.next_tid++;
+            reg.rings.push_back(ring);
+        }
+        return *ring;
+    }
+
+    ~ThreadRingHandle() {
+        if (ring) ring->thread_alive.store(false, std::memory_order_relaxed);
+    }
+};
+
+thread_local ThreadRingHandle t_ring;
+
+void AppendJsonString(std::ostringstream& out, const char* s) {
+    out << '"';
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out << '\\';
+        out << *s;
+    }
+    out << '"';
+}
+
+}  // namespace
+
+void Start() {
+    Registry& reg = GetRegistry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& ring : reg.rings) {
+            ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+            ring->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+    detail::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+std::string Stop() {
+    detail::g_enabled.store(false, std::memory_order_relaxed);
+
+    Registry& reg = GetRegistry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    // Chrome's trace-event format: one complete ("X") event per scope, i.e. a begin/end pair.
+    std::ostringstream out;
+    out.precision(3);
+    out << std::fixed;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    uint64_t dropped = 0;
+    for (const auto& ring : reg.rings) {
+        if (const char* name = ring->thread_name.load(std::memory_order_relaxed)) {
+            out << (first ? "" : ",") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << ring->tid
+                << ",\"args\":{\"name\":";
+            AppendJsonString(out, name);
+            out << "}}";
+            first = false;
+        }
+
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (uint64_t i = ring->tail.load(std::memory_order_relaxed); i < head; i++) {
+            const Event& e = ring->events[i & (kRingCapacity - 1)];
+            out << (first ? "" : ",") << "{\"ph\":\"X\",\"cat\":";
+            AppendJsonString(out, e.category);
+            out << ",\"name\":";
+            AppendJsonString(out, e.name);
+            out << ",\"pid\":1,\"tid\":" << ring->tid << ",\"ts\":" << static_cast<double>(e.begin_ns) / 1000.0
+                << ",\"dur\":" << static_cast<double>(e.end_ns - e.begin_ns) / 1000.0 << '}';
+            first = false;
+        }
+        ring->tail.store(head, std::memory_order_release);
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    out << "],\"otherData\":{\"dropped_events\":" << dropped << "}}";
+
+    // Release rings of threads that have exited now that their events are flushed.
+    for (auto it = reg.rings.begin(); it != reg.rings.end();) {
+        if (!(*it)->thread_alive.load(std::memory_order_relaxed)) {
+            it = reg.rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return out.str();
+}
+
+void SetThreadName(const char* name) {
+    // Rings are only allocated once a thread records something, so naming a thread costs nothing.
+    t_thread_name = name;
+    if (t_ring.ring) t_ring.ring->thread_name.store(name, std::memory_order_relaxed);
+}
+
+void Record(const char* category, const char* name, int64_t begin_ns, int64_t end_ns) {
+    t_ring.Get().Push({category, name, begin_ns, end_ns});
+}
+
+}  // namespace trace
+}  // namespace ox_sim
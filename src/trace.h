@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace ox_sim {
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> g_enabled;
+}  // namespace detail
+
+// Whether OX_TRACE_SCOPE hooks were compiled in (CMake option OX_SIM_ENABLE_TRACING).
+inline constexpr bool IsCompiledIn() {
+#ifdef OX_SIM_ENABLE_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+// True while a capture started by Start() is running. A single relaxed load, so scopes are
+// essentially free when tracing is off.
+inline bool IsEnabled() { return detail::g_enabled.load(std::memory_order_relaxed); }
+
+inline int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Discard anything left over from a previous capture and start recording.
+void Start();
+
+// Stop recording and return everything captured since Start() as Chrome trace-event JSON
+// (loadable in chrome://tracing and ui.perfetto.dev).
+std::string Stop();
+
+// Name the calling thread in captured traces (e.g. "http", "gui"). `name` must be a string literal.
+void SetThreadName(const char* name);
+
+// Append a completed [begin_ns, end_ns] slice to the calling thread's ring buffer.
+// `category` and `name` must be string literals (only the pointers are stored).
+void Record(const char* category, const char* name, int64_t begin_ns, int64_t end_ns);
+
+// Records the lifetime of the enclosing scope when tracing is enabled.
+class Scope {
+   public:
+    Scope(const char* category, const char* name)
+        : category_(category), name_(name), begin_ns_(IsEnabled() ? NowNs() : -1) {}
+    ~Scope() {
+        if (begin_ns_ >= 0) Record(category_, name_, begin_ns_, NowNs());
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    const char* category_;
+    const char* name_;
+    int64_t begin_ns_;
+};
+
+}  // namespace trace
+}  // namespace ox_sim
+
+#ifdef OX_SIM_ENABLE_TRACING
+#define OX_TRACE_CONCAT_INNER(a, b) a##b
+#define OX_TRACE_CONCAT(a, b) OX_TRACE_CONCAT_INNER(a, b)
+#define OX_TRACE_SCOPE(category, name) ::ox_sim::trace::Scope OX_TRACE_CONCAT(trace_scope_, __LINE__)(category, name)
+#else
+#define OX_TRACE_SCOPE(category, name) ((void)0)
+#endif
@@ -0,0 +1,505 @@
+// Loopback load generator for the simulator's HTTP API.
+//
+// Opens many keep-alive connections to a locally running simulator and replays a weighted mix of
+// pose PUTs, input PUTs, status GETs and view GETs, either at a fixed total request rate or as
+// fast as the server answers. Reports throughput, p50/p99/p999 latency and time to first body byte
+// per route. Chunked responses (view GETs with --view-stream) are read chunk by chunk.
+//
+// Latency is measured from the time a request was *scheduled* to be sent, so a stalled server
+// shows up in the tail instead of silently lowering the offered load.
+//
+// Options:
+//   --host=<addr>          server address (default 127.0.0.1)
+//   --port=<port>          server port (default 8765)
+//   --connections=<n>      concurrent keep-alive connections (default 16)
+//   --threads=<n>          client I/O threads (default 1)
+//   --seconds=<s>          run time (default 10)
+//   --rate=<req/s>         total request rate across all connections, 0 = maximum throughput (default 0)
+//   --mix=<spec>           route weights (default pose:40,input:40,status:15,view:5)
+//   --view-size=<width>    ?size= for view GETs, 0 = full resolution (default 256)
+//   --view-stream          request views with ?stream=true, as a chunked PNG encoded while it is sent
+//   --out=<file>           write the JSON report to <file> instead of stdout
+
+#ifndef ASIO_STANDALONE
+#define ASIO_STANDALONE
+#endif
+#include <asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+enum Route { ROUTE_POSE, ROUTE_INPUT, ROUTE_STATUS, ROUTE_VIEW, ROUTE_COUNT };
+
+const char* const kRouteNames[ROUTE_COUNT] = {"pose", "input", "status", "view"};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8765;
+    int connections = 16;
+    int threads = 1;
+    double seconds = 10.0;
+    double rate = 0.0;
+    int weights[ROUTE_COUNT] = {40, 40, 15, 5};
+    int view_size = 256;
+    bool view_stream = false;
+    std::string out_path;
+};
+
+bool ParseMix(const std::string& spec, int* weights) {
+    for (int r = 0; r < ROUTE_COUNT; r++) weights[r] = 0;
+    std::istringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        const std::string name = item.substr(0, colon);
+        int r = 0;
+        while (r < ROUTE_COUNT && name != kRouteNames[r]) r++;
+        if (r == ROUTE_COUNT) return false;
+        weights[r] = std::atoi(item.c_str() + colon + 1);
+    }
+    int total = 0;
+    for (int r = 0; r < ROUTE_COUNT; r++) total += weights[r];
+    return total > 0;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&arg](const char* prefix) -> const char* {
+            return arg.rfind(prefix, 0) == 0 ? arg.c_str() + std::char_traits<char>::length(prefix) : nullptr;
+        };
+        if (const char* v = value("--host=")) {
+            options.host = v;
+        } else if (const char* v = value("--port=")) {
+            options.port = static_cast<uint16_t>(std::atoi(v));
+        } else if (const char* v = value("--connections=")) {
+            options.connections = std::max(1, std::atoi(v));
+        } else if (const char* v = value("--threads=")) {
+            options.threads = std::max(1, std::atoi(v));
+        } else if (const char* v = value("--seconds=")) {
+            options.seconds = std::atof(v);
+        } else if (const char* v = value("--rate=")) {
+            options.rate = std::atof(v);
+        } else if (const char* v = value("--mix=")) {
+            if (!ParseMix(v, options.weights)) {
+                std::cerr << "Invalid --mix: " << v << " (expected e.g. pose:40,input:40,status:15,view:5)"
+                          << std::endl;
+                return false;
+            }
+        } else if (const char* v = value("--view-size=")) {
+            options.view_size = std::atoi(v);
+        } else if (arg == "--view-stream") {
+            options.view_stream = true;
+        } else if (const char* v = value("--out=")) {
+            options.out_path = v;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.seconds > 0.0;
+}
+
+// Log-linear latency histogram (HdrHistogram-style): 64 linear sub-buckets per power of two,
+// i.e. under 2% relative error, in a fixed amount of memory regardless of the sample count.
+class LatencyHistogram {
+   public:
+    static constexpr int kSubBucketBits = 6;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMagnitudes = 40;  // up to 2^46 ns (~19 hours)
+    static constexpr size_t kBuckets = kSubBuckets + kMagnitudes * (kSubBuckets / 2);
+
+    LatencyHistogram() : counts_(kBuckets, 0) {}
+
+    void Record(int64_t ns) {
+        const uint64_t v = static_cast<uint64_t>(std::max<int64_t>(ns, 0));
+        counts_[Index(v)]++;
+        count_++;
+        max_ns_ = std::max(max_ns_, v);
+    }
+
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts_.size(); i++) counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        max_ns_ = std::max(max_ns_, other.max_ns_);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max_ns() const { return max_ns_; }
+
+    // Upper bound of the bucket holding the p-th quantile.
+    uint64_t Percentile(double p) const {
+        if (count_ == 0) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(count_))));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            seen += counts_[i];
+            if (seen >= rank) return std::min(UpperBound(i), max_ns_);
+        }
+        return max_ns_;
+    }
+
+   private:
+    static size_t Index(uint64_t v) {
+        if (v < kSubBuckets) return static_cast<size_t>(v);
+        int highest_bit = 0;
+        while ((v >> highest_bit) > 1) highest_bit++;
+        const int magnitude = highest_bit - (kSubBucketBits - 1);  // >= 1
+        if (magnitude > kMagnitudes) return kBuckets - 1;
+        const uint64_t sub = (v >> magnitude) - kSubBuckets / 2;  // in [0, kSubBuckets / 2)
+        return static_cast<size_t>(kSubBuckets + (magnitude - 1) * (kSubBuckets / 2) + sub);
+    }
+
+    static uint64_t UpperBound(size_t index) {
+        if (index < kSubBuckets) return index;
+        const size_t rel = index - kSubBuckets;
+        const int magnitude = static_cast<int>(rel / (kSubBuckets / 2)) + 1;
+        const uint64_t sub = rel % (kSubBuckets / 2) + kSubBuckets / 2;
+        return ((sub + 1) << magnitude) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t max_ns_ = 0;
+};
+
+struct RouteStats {
+    LatencyHistogram latency;
+    LatencyHistogram first_byte;  // until the first body byte (the first chunk of a chunked body)
+    uint64_t ok = 0;          // 2xx responses
+    uint64_t http_errors = 0;  // non-2xx responses
+    uint64_t bytes = 0;       // response body bytes
+};
+
+struct ConnectionStats {
+    RouteStats routes[ROUTE_COUNT];
+    uint64_t socket_errors = 0;
+};
+
+// One keep-alive connection running a request/response loop. All handlers for a connection run
+// sequentially, so its stats need no synchronization; they are merged after the io_context stops.
+class Connection : public std::enable_shared_from_this<Connection> {
+   public:
+    Connection(asio::io_context& io, const Options& options, const asio::ip::tcp::endpoint& endpoint, int id,
+               Clock::time_point start, Clock::time_point end, ConnectionStats& stats)
+        : socket_(io),
+          timer_(io),
+          options_(options),
+          endpoint_(endpoint),
+          end_(end),
+          stats_(stats),
+          rng_(0x9E3779B9u * static_cast<uint32_t>(id + 1)) {
+        if (options.rate > 0.0) {
+            interval_ = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(options.connections) / options.rate));
+            // Stagger connections evenly across one interval.
+            next_send_ = start + interval_ * id / options.connections;
+        } else {
+            next_send_ = start;
+        }
+        for (int r = 0; r < ROUTE_COUNT; r++) total_weight_ += options.weights[r];
+    }
+
+    void Start() {
+        auto self = shared_from_this();
+        socket_.async_connect(endpoint_, [self](const asio::error_code& ec) {
+            if (ec) return self->Fail(ec);
+            self->socket_.set_option(asio::ip::tcp::no_delay(true));
+            self->ScheduleNext();
+        });
+    }
+
+   private:
+    void ScheduleNext() {
+        const bool paced = interval_ != Clock::duration::zero();
+        if ((paced ? next_send_ : Clock::now()) >= end_) {
+            asio::error_code ignored;
+            socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+            socket_.close(ignored);
+            return;
+        }
+        if (!paced || next_send_ <= Clock::now()) {
+            Send();
+            return;
+        }
+        auto self = shared_from_this();
+        timer_.expires_at(next_send_);
+        timer_.async_wait([self](const asio::error_code& ec) {
+            if (!ec) self->Send();
+        });
+    }
+
+    Route PickRoute() {
+        rng_ = rng_ * 1664525u + 1013904223u;
+        int pick = static_cast<int>((rng_ >> 8) % static_cast<uint32_t>(total_weight_));
+        for (int r = 0; r < ROUTE_COUNT; r++) {
+            if (pick < options_.weights[r]) return static_cast<Route>(r);
+            pick -= options_.weights[r];
+        }
+        return ROUTE_STATUS;
+    }
+
+    void BuildRequest(Route route) {
+        const float t = static_cast<float>(sequence_ % 1000) / 1000.0f;
+        const char* hand = (sequence_ % 2) ? "left" : "right";
+        std::string method = "GET", path, body;
+        switch (route) {
+            case ROUTE_POSE: {
+                method = "PUT";
+                path = std::string("/v1/devices/user/hand/") + hand;
+                std::ostringstream json;
+                json << R"({"position":{"x":)" << (t - 0.5f) << R"(,"y":1.4,"z":-0.3},)"
+                     << R"("orientation":{"x":0,"y":0,"z":0,"w":1},"active":true})";
+                body = json.str();
+                break;
+            }
+            case ROUTE_INPUT: {
+                method = "PUT";
+                path = std::string("/v1/inputs/user/hand/") + hand + "/input/trigger/value";
+                body = "{\"value\":" + std::to_string(t) + "}";
+                break;
+            }
+            case ROUTE_STATUS:
+                path = "/v1/status";
+                break;
+            case ROUTE_VIEW:
+            default:
+                path = "/v1/views/0";
+                if (options_.view_size > 0) path += "?size=" + std::to_string(options_.view_size);
+                if (options_.view_stream) path += options_.view_size > 0 ? "&stream=true" : "?stream=true";
+                break;
+        }
+
+        request_.clear();
+        request_ += method + " " + path + " HTTP/1.1\r\nHost: " + options_.host + "\r\n";
+        if (!body.empty()) {
+            request_ += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+        }
+        request_ += "\r\n" + body;
+    }
+
+    void Send() {
+        route_ = PickRoute();
+        BuildRequest(route_);
+        sequence_++;
+
+        // Open-loop timing: measure from the scheduled send time, not the actual one.
+        scheduled_ = interval_ == Clock::duration::zero() ? Clock::now() : next_send_;
+        next_send_ += interval_;
+
+        auto self = shared_from_this();
+        asio::async_write(socket_, asio::buffer(request_), [self](const asio::error_code& ec, size_t) {
+            if (ec) return self->Fail(ec);
+            self->ReadHeaders();
+        });
+    }
+
+    void ReadHeaders() {
+        auto self = shared_from_this();
+        asio::async_read_until(socket_, buffer_, "\r\n\r\n", [self](const asio::error_code& ec, size_t header_bytes) {
+            if (ec) return self->Fail(ec);
+
+            std::string headers(asio::buffers_begin(self->buffer_.data()),
+                                asio::buffers_begin(self->buffer_.data()) + header_bytes);
+            self->buffer_.consume(header_bytes);
+
+            int status = 0;
+            if (headers.size() > 12) status = std::atoi(headers.c_str() + 9);  // "HTTP/1.1 200 OK"
+            size_t content_length = 0;
+            bool chunked = false;
+            for (size_t pos = 0; (pos = headers.find("\r\n", pos)) != std::string::npos;) {
+                pos += 2;
+                if (headers.compare(pos, 15, "Content-Length:") == 0 ||
+                    headers.compare(pos, 15, "content-length:") == 0) {
+                    content_length = static_cast<size_t>(std::strtoull(headers.c_str() + pos + 15, nullptr, 10));
+                } else if (headers.compare(pos, 18, "Transfer-Encoding:") == 0 ||
+                           headers.compare(pos, 18, "transfer-encoding:") == 0) {
+                    chunked = headers.compare(pos + 18, 8, " chunked") == 0;
+                }
+            }
+            if (chunked) return self->ReadChunkSize(status, 0);
+            self->first_byte_ = Clock::now();
+            self->ReadBody(status, content_length);
+        });
+    }
+
+    // Chunked body: a hexadecimal size line, then that many bytes and a CRLF, until a chunk of size 0
+    // (followed by the CRLF that ends the body; the server sends no trailers).
+    void ReadChunkSize(int status, size_t body_bytes) {
+        auto self = shared_from_this();
+        asio::async_read_until(
+            socket_, buffer_, "\r\n", [self, status, body_bytes](const asio::error_code& ec, size_t line_bytes) {
+                if (ec) return self->Fail(ec);
+                const std::string line(asio::buffers_begin(self->buffer_.data()),
+                                       asio::buffers_begin(self->buffer_.data()) + line_bytes);
+                self->buffer_.consume(line_bytes);
+                if (body_bytes == 0) self->first_byte_ = Clock::now();
+                self->ReadChunk(status, body_bytes, static_cast<size_t>(std::strtoull(line.c_str(), nullptr, 16)));
+            });
+    }
+
+    void ReadChunk(int status, size_t body_bytes, size_t chunk_size) {
+        auto self = shared_from_this();
+        const size_t needed = chunk_size + 2;
+        const size_t buffered = buffer_.size();
+        const size_t remaining = needed > buffered ? needed - buffered : 0;
+        asio::async_read(socket_, buffer_, asio::transfer_exactly(remaining),
+                         [self, status, body_bytes, chunk_size, needed](const asio::error_code& ec, size_t) {
+                             if (ec) return self->Fail(ec);
+                             self->buffer_.consume(needed);
+                             if (chunk_size == 0) return self->Complete(status, body_bytes);
+                             self->ReadChunkSize(status, body_bytes + chunk_size);
+                         });
+    }
+
+    void ReadBody(int status, size_t content_length) {
+        auto self = shared_from_this();
+        const size_t buffered = buffer_.size();
+        const size_t remaining = content_length > buffered ? content_length - buffered : 0;
+        asio::async_read(socket_, buffer_, asio::transfer_exactly(remaining),
+                         [self, status, content_length](const asio::error_code& ec, size_t) {
+                             if (ec) return self->Fail(ec);
+                             self->buffer_.consume(content_length);
+                             self->Complete(status, content_length);
+                         });
+    }
+
+    void Complete(int status, size_t body_bytes) {
+        RouteStats& stats = stats_.routes[route_];
+        stats.latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled_).count());
+        stats.first_byte.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(first_byte_ - scheduled_).count());
+        (status >= 200 && status < 300 ? stats.ok : stats.http_errors)++;
+        stats.bytes += body_bytes;
+        ScheduleNext();
+    }
+
+    void Fail(const asio::error_code& ec) {
+        if (stats_.socket_errors++ == 0) std::cerr << "Connection error: " << ec.message() << std::endl;
+        asio::error_code ignored;
+        socket_.close(ignored);
+    }
+
+    asio::ip::tcp::socket socket_;
+    asio::steady_timer timer_;
+    asio::streambuf buffer_;
+    const Options& options_;
+    asio::ip::tcp::endpoint endpoint_;
+    Clock::time_point end_;
+    ConnectionStats& stats_;
+
+    Clock::duration interval_ = Clock::duration::zero();
+    Clock::time_point next_send_;
+    Clock::time_point scheduled_;
+    Clock::time_point first_byte_;
+    std::string request_;
+    Route route_ = ROUTE_STATUS;
+    uint64_t sequence_ = 0;
+    uint32_t rng_;
+    int total_weight_ = 0;
+};
+
+double ToUs(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) return 2;
+
+    asio::io_context io;
+    asio::error_code ec;
+    const asio::ip::address address = asio::ip::make_address(options.host, ec);
+    if (ec) {
+        std::cerr << "Invalid --host: " << options.host << std::endl;
+        return 2;
+    }
+    const asio::ip::tcp::endpoint endpoint(address, options.port);
+
+    std::cerr << "Load test: " << options.connections << " connections, "
+              << (options.rate > 0.0 ? std::to_string(static_cast<int>(options.rate)) + " req/s" : "max throughput")
+              << ", " << options.seconds << " s against " << options.host << ":" << options.port << std::endl;
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end =
+        start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+
+    std::vector<ConnectionStats> stats(options.connections);
+    for (int i = 0; i < options.connections; i++) {
+        std::make_shared<Connection>(io, options, endpoint, i, start, end, stats[i])->Start();
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < options.threads; i++) threads.emplace_back([&io] { io.run(); });
+    io.run();
+    for (std::thread& t : threads) t.join();
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Merge per-connection stats
+    ConnectionStats total;
+    for (const ConnectionStats& s : stats) {
+        for (int r = 0; r < ROUTE_COUNT; r++) {
+            total.routes[r].latency.Merge(s.routes[r].latency);
+            total.routes[r].first_byte.Merge(s.routes[r].first_byte);
+            total.routes[r].ok += s.routes[r].ok;
+            total.routes[r].http_errors += s.routes[r].http_errors;
+            total.routes[r].bytes += s.routes[r].bytes;
+        }
+        total.socket_errors += s.socket_errors;
+    }
+
+    std::ostringstream out;
+    uint64_t requests = 0;
+    out << "{\n  \"config\": {\"connections\": " << options.connections << ", \"threads\": " << options.threads
+        << ", \"seconds\": " << options.seconds << ", \"rate\": " << options.rate << "},\n  \"routes\": {";
+    bool first = true;
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        const RouteStats& s = total.routes[r];
+        if (s.latency.count() == 0) continue;
+        requests += s.latency.count();
+        out << (first ? "" : ",") << "\n    \"" << kRouteNames[r] << "\": {\"requests\": " << s.latency.count()
+            << ", \"ok\": " << s.ok << ", \"http_errors\": " << s.http_errors
+            << ", \"throughput_rps\": " << static_cast<double>(s.latency.count()) / elapsed
+            << ", \"response_bytes\": " << s.bytes << ", \"p50_us\": " << ToUs(s.latency.Percentile(0.50))
+            << ", \"p99_us\": " << ToUs(s.latency.Percentile(0.99))
+            << ", \"p999_us\": " << ToUs(s.latency.Percentile(0.999)) << ", \"max_us\": " << ToUs(s.latency.max_ns())
+            << ", \"first_byte_p50_us\": " << ToUs(s.first_byte.Percentile(0.50))
+            << ", \"first_byte_p99_us\": " << ToUs(s.first_byte.Percentile(0.99)) << "}";
+        first = false;
+
+        std::cerr << "  " << kRouteNames[r] << ": " << static_cast<double>(s.latency.count()) / elapsed
+                  << " req/s, p50 " << ToUs(s.latency.Percentile(0.50)) << " us, p99 "
+                  << ToUs(s.latency.Percentile(0.99)) << " us, p999 " << ToUs(s.latency.Percentile(0.999))
+                  << " us, first byte p50 " << ToUs(s.first_byte.Percentile(0.50)) << " us (" << s.http_errors
+                  << " non-2xx)" << std::endl;
+    }
+    out << "\n  },\n  \"total\": {\"requests\": " << requests
+        << ", \"throughput_rps\": " << static_cast<double>(requests) / elapsed
+        << ", \"socket_errors\": " << total.socket_errors << "}\n}\n";
+
+    if (options.out_path.empty()) {
+        std::cout << out.str();
+    } else {
+        std::ofstream file(options.out_path);
+        if (!file) {
+            std::cerr << "Failed to open " << options.out_path << std::endl;
+            return 1;
+        }
+        file << out.str();
+    }
+    return total.socket_errors > 0 ? 1 : 0;
+}